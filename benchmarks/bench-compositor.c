@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+#include "testlib-layer-shell.h"
+
+#include "desktop.h"
+#include "render.h"
+
+#include <time.h>
+
+#define DEFAULT_FRAMES  300
+#define BURST_COMMITS   2000
+#define HIT_TEST_GRID_X 32
+#define HIT_TEST_GRID_Y 24
+#define HIT_TEST_ROUNDS 20
+#define DAMAGE_SIZE     16
+
+/*
+ * Drives scripted clients against a headless compositor and reports
+ * per frame CPU time of the compositor, commit throughput and hit
+ * test latency as JSON.
+ */
+
+typedef struct {
+  const char *name;
+  guint       n_toplevels;
+  guint       subsurface_depth;
+  guint       n_layer_surfaces;
+} PhocBenchScenario;
+
+static const PhocBenchScenario scenarios[] = {
+  { .name = "toplevels", .n_toplevels = 16 },
+  { .name = "many-toplevels", .n_toplevels = 64 },
+  { .name = "subsurfaces", .n_toplevels = 1, .subsurface_depth = 32 },
+  { .name = "layer-surfaces", .n_toplevels = 1, .n_layer_surfaces = 24 },
+  { .name = "mixed", .n_toplevels = 8, .subsurface_depth = 8, .n_layer_surfaces = 8 },
+};
+
+typedef struct {
+  struct wl_surface    *wl_surface;
+  struct wl_subsurface *wl_subsurface;
+  PhocTestBuffer        buffer;
+} PhocBenchSubsurface;
+
+typedef struct {
+  const PhocBenchScenario *scenario;
+  guint                    n_frames;
+
+  /* Written from the compositor's thread */
+  gint                     measuring;
+  gint64                   last_cpu_ns;
+  GArray                  *frame_times;    /* (element-type gint64), ns */
+  GArray                  *hit_test_times; /* (element-type gint64), ns */
+
+  /* Written from the client's thread */
+  double                   commits_per_second;
+  struct wl_subcompositor *subcompositor;
+
+  GMutex                   mutex;
+  GCond                    cond;
+  gboolean                 hit_test_done;
+} PhocBenchRun;
+
+
+static gint64
+get_thread_cpu_time_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+
+static gint64
+get_monotonic_time_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+
+static int
+compare_int64 (gconstpointer a, gconstpointer b)
+{
+  gint64 va = *(const gint64 *)a;
+  gint64 vb = *(const gint64 *)b;
+
+  return (va > vb) - (va < vb);
+}
+
+
+static void
+append_stats (GString *json, const char *name, GArray *samples, double unit)
+{
+  double sum = 0;
+  guint n = samples->len;
+
+  g_array_sort (samples, compare_int64);
+  for (guint i = 0; i < n; i++)
+    sum += g_array_index (samples, gint64, i);
+
+  g_string_append_printf (json,
+                          "\"%s\": {\"samples\": %u, \"mean\": %.3f, \"p50\": %.3f, "
+                          "\"p95\": %.3f, \"max\": %.3f}",
+                          name, n,
+                          n ? sum / n / unit : 0.0,
+                          n ? g_array_index (samples, gint64, n / 2) / unit : 0.0,
+                          n ? g_array_index (samples, gint64, (n * 95) / 100) / unit : 0.0,
+                          n ? g_array_index (samples, gint64, n - 1) / unit : 0.0);
+}
+
+/* Compositor side */
+
+static void
+on_render_end (PhocRenderer *renderer, PhocRenderContext *ctx, PhocBenchRun *run)
+{
+  gint64 now = get_thread_cpu_time_ns ();
+
+  if (!g_atomic_int_get (&run->measuring)) {
+    run->last_cpu_ns = 0;
+    return;
+  }
+
+  if (run->last_cpu_ns)
+    g_array_append_vals (run->frame_times, &(gint64){ now - run->last_cpu_ns }, 1);
+
+  run->last_cpu_ns = now;
+}
+
+
+static gboolean
+bench_server_prepare (PhocServer *server, gpointer data)
+{
+  PhocBenchRun *run = data;
+
+  g_signal_connect (phoc_server_get_renderer (server), "render-end",
+                    G_CALLBACK (on_render_end), run);
+  return TRUE;
+}
+
+
+static gboolean
+hit_test_in_server (gpointer data)
+{
+  PhocBenchRun *run = data;
+  PhocServer *server = phoc_server_get_default ();
+  PhocDesktop *desktop = phoc_server_get_desktop (server);
+  struct wlr_box box;
+
+  wlr_output_layout_get_box (desktop->layout, NULL, &box);
+
+  for (int round = 0; round < HIT_TEST_ROUNDS; round++) {
+    for (int y = 0; y < HIT_TEST_GRID_Y; y++) {
+      for (int x = 0; x < HIT_TEST_GRID_X; x++) {
+        double lx = box.x + (x + 0.5) * box.width / HIT_TEST_GRID_X;
+        double ly = box.y + (y + 0.5) * box.height / HIT_TEST_GRID_Y;
+        double sx, sy;
+        PhocView *view;
+        gint64 start = get_monotonic_time_ns ();
+
+        phoc_desktop_wlr_surface_at (desktop, lx, ly, &sx, &sy, &view);
+        g_array_append_vals (run->hit_test_times, &(gint64){ get_monotonic_time_ns () - start }, 1);
+      }
+    }
+  }
+
+  g_mutex_lock (&run->mutex);
+  run->hit_test_done = TRUE;
+  g_cond_signal (&run->cond);
+  g_mutex_unlock (&run->mutex);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Client side */
+
+static void
+registry_handle_global (void               *data,
+                        struct wl_registry *registry,
+                        uint32_t            name,
+                        const char         *interface,
+                        uint32_t            version)
+{
+  PhocBenchRun *run = data;
+
+  if (g_str_equal (interface, wl_subcompositor_interface.name))
+    run->subcompositor = wl_registry_bind (registry, name, &wl_subcompositor_interface, 1);
+}
+
+
+static void
+registry_handle_global_remove (void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+
+static const struct wl_registry_listener registry_listener = {
+  registry_handle_global,
+  registry_handle_global_remove,
+};
+
+
+static void
+frame_handle_done (void *data, struct wl_callback *callback, uint32_t time)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+  wl_callback_destroy (callback);
+}
+
+
+static const struct wl_callback_listener frame_listener = {
+  frame_handle_done,
+};
+
+
+static void
+fill_buffer (PhocTestBuffer *buffer, guint32 color)
+{
+  for (int i = 0; i < buffer->width * buffer->height * 4; i += 4)
+    *(guint32*)(buffer->shm_data + i) = color;
+}
+
+
+static void
+damage_and_commit (struct wl_surface *wl_surface, PhocTestBuffer *buffer, guint frame)
+{
+  int x = (frame * DAMAGE_SIZE) % MAX ((int)buffer->width - DAMAGE_SIZE, 1);
+  int y = (frame * DAMAGE_SIZE / 2) % MAX ((int)buffer->height - DAMAGE_SIZE, 1);
+
+  wl_surface_attach (wl_surface, buffer->wl_buffer, 0, 0);
+  wl_surface_damage_buffer (wl_surface, x, y, DAMAGE_SIZE, DAMAGE_SIZE);
+  wl_surface_commit (wl_surface);
+}
+
+
+static GPtrArray *
+create_subsurface_tree (PhocTestClientGlobals *globals,
+                        PhocBenchRun          *run,
+                        struct wl_surface     *parent,
+                        guint                  depth)
+{
+  GPtrArray *subsurfaces = g_ptr_array_new ();
+
+  for (guint i = 0; i < depth; i++) {
+    PhocBenchSubsurface *sub = g_new0 (PhocBenchSubsurface, 1);
+
+    sub->wl_surface = wl_compositor_create_surface (globals->compositor);
+    sub->wl_subsurface = wl_subcompositor_get_subsurface (run->subcompositor,
+                                                          sub->wl_surface,
+                                                          parent);
+    wl_subsurface_set_position (sub->wl_subsurface, 8, 8);
+    wl_subsurface_set_desync (sub->wl_subsurface);
+
+    phoc_test_client_create_shm_buffer (globals, &sub->buffer, 64, 64, WL_SHM_FORMAT_XRGB8888);
+    fill_buffer (&sub->buffer, 0xFF00FF00 + i);
+    damage_and_commit (sub->wl_surface, &sub->buffer, 0);
+
+    g_ptr_array_add (subsurfaces, sub);
+    parent = sub->wl_surface;
+  }
+
+  return subsurfaces;
+}
+
+
+static void
+commit_all (GPtrArray *toplevels, GPtrArray *subsurfaces, GPtrArray *layer_surfaces, guint frame)
+{
+  for (guint i = 0; i < toplevels->len; i++) {
+    PhocTestXdgToplevelSurface *xs = g_ptr_array_index (toplevels, i);
+
+    damage_and_commit (xs->wl_surface, &xs->buffer, frame);
+  }
+
+  for (guint i = 0; i < subsurfaces->len; i++) {
+    PhocBenchSubsurface *sub = g_ptr_array_index (subsurfaces, i);
+
+    damage_and_commit (sub->wl_surface, &sub->buffer, frame);
+  }
+
+  for (guint i = 0; i < layer_surfaces->len; i++) {
+    PhocTestLayerSurface *ls = g_ptr_array_index (layer_surfaces, i);
+
+    damage_and_commit (ls->wl_surface, &ls->buffer, frame);
+  }
+}
+
+
+static guint
+count_commits (GPtrArray *toplevels, GPtrArray *subsurfaces, GPtrArray *layer_surfaces)
+{
+  return toplevels->len + subsurfaces->len + layer_surfaces->len;
+}
+
+
+static gboolean
+bench_client_run (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocBenchRun *run = data;
+  const PhocBenchScenario *scenario = run->scenario;
+  g_autoptr (GPtrArray) toplevels = g_ptr_array_new ();
+  g_autoptr (GPtrArray) subsurfaces = NULL;
+  g_autoptr (GPtrArray) layer_surfaces = g_ptr_array_new ();
+  struct wl_registry *registry;
+  guint n_commits = 0;
+  gint64 start;
+
+  registry = wl_display_get_registry (globals->display);
+  wl_registry_add_listener (registry, &registry_listener, run);
+  wl_display_roundtrip (globals->display);
+  g_assert_nonnull (run->subcompositor);
+
+  for (guint i = 0; i < scenario->n_toplevels; i++) {
+    g_autofree char *title = g_strdup_printf ("bench-%u", i);
+    PhocTestXdgToplevelSurface *xs;
+
+    xs = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, title, 0xFF0000FF + i);
+    g_ptr_array_add (toplevels, xs);
+  }
+
+  g_assert_cmpint (toplevels->len, >, 0);
+  subsurfaces = create_subsurface_tree (globals, run,
+                                        ((PhocTestXdgToplevelSurface *)toplevels->pdata[0])->wl_surface,
+                                        scenario->subsurface_depth);
+
+  for (guint i = 0; i < scenario->n_layer_surfaces; i++) {
+    PhocTestLayerSurface *ls;
+
+    ls = phoc_test_layer_surface_new (globals, 0, 32, 0xFFFF0000 + i,
+                                      ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+                                      ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+                                      ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+                                      0);
+    g_ptr_array_add (layer_surfaces, ls);
+  }
+  wl_display_roundtrip (globals->display);
+
+  /* Constant damage, paced by the output's frame clock */
+  g_atomic_int_set (&run->measuring, TRUE);
+  for (guint frame = 0; frame < run->n_frames; frame++) {
+    PhocTestXdgToplevelSurface *xs = g_ptr_array_index (toplevels, 0);
+    struct wl_callback *callback = wl_surface_frame (xs->wl_surface);
+    gboolean done = FALSE;
+
+    wl_callback_add_listener (callback, &frame_listener, &done);
+    commit_all (toplevels, subsurfaces, layer_surfaces, frame);
+
+    while (!done && wl_display_dispatch (globals->display) != -1)
+      ;
+  }
+  g_atomic_int_set (&run->measuring, FALSE);
+
+  /* Commit throughput without waiting for frames */
+  start = g_get_monotonic_time ();
+  for (guint frame = 0; n_commits < BURST_COMMITS; frame++) {
+    commit_all (toplevels, subsurfaces, layer_surfaces, frame);
+    n_commits += count_commits (toplevels, subsurfaces, layer_surfaces);
+    if (frame % 8 == 0)
+      wl_display_roundtrip (globals->display);
+  }
+  wl_display_roundtrip (globals->display);
+  run->commits_per_second = n_commits / ((g_get_monotonic_time () - start) / (double)G_USEC_PER_SEC);
+
+  /* Hit testing has to happen in the compositor's thread */
+  g_idle_add (hit_test_in_server, run);
+  g_mutex_lock (&run->mutex);
+  while (!run->hit_test_done)
+    g_cond_wait (&run->cond, &run->mutex);
+  g_mutex_unlock (&run->mutex);
+
+  for (guint i = 0; i < subsurfaces->len; i++) {
+    PhocBenchSubsurface *sub = g_ptr_array_index (subsurfaces, i);
+
+    wl_subsurface_destroy (sub->wl_subsurface);
+    wl_surface_destroy (sub->wl_surface);
+    phoc_test_buffer_free (&sub->buffer);
+    g_free (sub);
+  }
+  g_ptr_array_foreach (layer_surfaces, (GFunc)phoc_test_layer_surface_free, NULL);
+  g_ptr_array_foreach (toplevels, (GFunc)phoc_test_xdg_toplevel_free, NULL);
+  g_clear_pointer (&run->subcompositor, wl_subcompositor_destroy);
+  wl_registry_destroy (registry);
+
+  return TRUE;
+}
+
+
+static void
+run_scenario (const PhocBenchScenario *scenario, guint n_frames, GString *json)
+{
+  PhocTestClientIface iface = {
+    .server_prepare = bench_server_prepare,
+    .client_run = bench_client_run,
+  };
+  PhocBenchRun run = {
+    .scenario = scenario,
+    .n_frames = n_frames,
+    .frame_times = g_array_new (FALSE, FALSE, sizeof (gint64)),
+    .hit_test_times = g_array_new (FALSE, FALSE, sizeof (gint64)),
+  };
+
+  g_mutex_init (&run.mutex);
+  g_cond_init (&run.cond);
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT * 30, &iface, &run);
+
+  g_string_append_printf (json,
+                          "    {\"name\": \"%s\", \"toplevels\": %u, \"subsurface-depth\": %u, "
+                          "\"layer-surfaces\": %u, \"frames\": %u, ",
+                          scenario->name,
+                          scenario->n_toplevels,
+                          scenario->subsurface_depth,
+                          scenario->n_layer_surfaces,
+                          n_frames);
+  append_stats (json, "frame-cpu-time-us", run.frame_times, 1000.0);
+  g_string_append_printf (json, ", \"commits-per-second\": %.1f, ", run.commits_per_second);
+  append_stats (json, "hit-test-ns", run.hit_test_times, 1.0);
+  g_string_append (json, "}");
+
+  g_array_unref (run.frame_times);
+  g_array_unref (run.hit_test_times);
+  g_mutex_clear (&run.mutex);
+  g_cond_clear (&run.cond);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autoptr (GOptionContext) opt_context = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GString) json = g_string_new ("{\n  \"benchmarks\": [\n");
+  g_autofree char *output = NULL;
+  g_autofree char *only = NULL;
+  int frames = DEFAULT_FRAMES;
+  gboolean first = TRUE;
+
+  const GOptionEntry options [] = {
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+     "File to write the results to instead of stdout", NULL},
+    {"frames", 'f', 0, G_OPTION_ARG_INT, &frames,
+     "Number of frames to render per scenario", NULL},
+    {"scenario", 's', 0, G_OPTION_ARG_STRING, &only,
+     "Only run the given scenario", NULL},
+    { NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+  };
+
+  opt_context = g_option_context_new ("- phoc benchmarks");
+  g_option_context_add_main_entries (opt_context, options, NULL);
+  if (!g_option_context_parse (opt_context, &argc, &argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    return EXIT_FAILURE;
+  }
+
+  for (guint i = 0; i < G_N_ELEMENTS (scenarios); i++) {
+    if (only && !g_str_equal (only, scenarios[i].name))
+      continue;
+
+    if (!first)
+      g_string_append (json, ",\n");
+    first = FALSE;
+
+    run_scenario (&scenarios[i], MAX (frames, 1), json);
+  }
+  g_string_append (json, "\n  ]\n}\n");
+
+  if (output) {
+    if (!g_file_set_contents (output, json->str, json->len, &err)) {
+      g_printerr ("Failed to write %s: %s\n", output, err->message);
+      return EXIT_FAILURE;
+    }
+  } else {
+    g_print ("%s", json->str);
+  }
+
+  return EXIT_SUCCESS;
+}
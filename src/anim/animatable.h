@@ -16,17 +16,22 @@ G_DECLARE_INTERFACE (PhocAnimatable, phoc_animatable, PHOC, ANIMATABLE, GObject)
 /**
  * PhocFrameCallback:
  * @self: The animatable
- * @last_frame: Time of the last frame in us
+ * @frame_time: Predicted presentation time of the frame in us
  * @user_data: User data passed when registering the callback
  *
  * Callback type for adding a function to update animations. See
  * phoc_animatable_add_frame_callback().
  *
+ * @frame_time is in the same time base as `g_get_monotonic_time()`
+ * and refers to when the frame being prepared will show up on
+ * screen. Animations should compute their progress from it so they
+ * match what is visible even when frames are late.
+ *
  * Returns: G_SOURCE_CONTINUE if the frame callback should continue to
  *  or G_SOURCE_REMOVE if the frame callback should be removed.
  */
 typedef gboolean (*PhocFrameCallback) (PhocAnimatable *self,
-                                       guint64         last_frame,
+                                       guint64         frame_time,
                                        gpointer        user_data);
 
 struct _PhocAnimatableInterface
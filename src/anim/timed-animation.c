@@ -47,7 +47,8 @@ struct _PhocTimedAnimation {
 
   PhocAnimatable      *animatable;
   PhocPropertyEaser   *prop_easer;
-  gint64               elapsed_ms;
+  gint64               elapsed_us;
+  gint64               last_frame_us;
   int                  duration;
   PhocAnimationState   state;
   guint                frame_callback_id;
@@ -135,15 +136,19 @@ stop_animation (PhocTimedAnimation *self)
 
 static gboolean
 on_frame_callback (PhocAnimatable *animatable,
-                   guint64         last_frame,
+                   guint64         frame_time,
                    gpointer        user_data)
 {
   PhocTimedAnimation *self = PHOC_TIMED_ANIMATION (user_data);
-  guint64 now = g_get_monotonic_time ();
-  guint t = self->elapsed_ms + ((now - last_frame) / 1000);
+  gint64 delta_us = MAX ((gint64)frame_time - self->last_frame_us, 0);
+  gint64 elapsed_us = self->elapsed_us + delta_us;
+  /* Only convert here so sub-millisecond parts of frames add up */
+  guint t = elapsed_us / 1000;
+
+  self->last_frame_us = frame_time;
 
   g_debug ("t: %d/%d", t, self->duration);
-  if (self->elapsed_ms > self->duration) {
+  if (self->elapsed_us > (gint64)self->duration * 1000) {
     self->frame_callback_id = 0;
     phoc_timed_animation_skip (self);
     return G_SOURCE_REMOVE;
@@ -153,7 +158,7 @@ on_frame_callback (PhocAnimatable *animatable,
   /* TODO: better emit changed progress? */
   g_signal_emit (self, signals[TICK], 0);
 
-  self->elapsed_ms = t;
+  self->elapsed_us = elapsed_us;
   return G_SOURCE_CONTINUE;
 }
 
@@ -171,7 +176,8 @@ play (PhocTimedAnimation *self)
   self->state = PHOC_TIMED_ANIMATION_PLAYING;
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_STATE]);
 
-  self->elapsed_ms = 0;
+  self->elapsed_us = 0;
+  self->last_frame_us = g_get_monotonic_time ();
 
   if (self->frame_callback_id)
     return;
@@ -472,7 +478,7 @@ phoc_timed_animation_skip (PhocTimedAnimation *self)
   stop_animation (self);
 
   update_properties (self, self->duration);
-  self->elapsed_ms = 0;
+  self->elapsed_us = 0;
 
   g_object_thaw_notify (G_OBJECT (self));
 
@@ -544,7 +550,7 @@ phoc_timed_animation_reset (PhocTimedAnimation *self)
   stop_animation (self);
 
   update_properties (self, 0);
-  self->elapsed_ms = 0;
+  self->elapsed_us = 0;
 
   g_object_thaw_notify (G_OBJECT (self));
 }
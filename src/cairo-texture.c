@@ -12,6 +12,7 @@
 #include <drm_fourcc.h>
 #include <wlr/interfaces/wlr_buffer.h>
 #include <wlr/render/wlr_texture.h>
+#include <wlr/util/box.h>
 
 enum {
   PROP_0,
@@ -22,6 +23,20 @@ enum {
 
 static GParamSpec *props[PROP_LAST_PROP];
 
+/**
+ * PhocCairoTexture:
+ *
+ * A cairo surface backed texture.
+ *
+ * Callers draw into the cairo context, mark the changed areas via
+ * [method@CairoTexture.add_damage_box] and then upload them via
+ * [method@CairoTexture.update].
+ *
+ * Once a texture was handed out for rendering it's not updated in
+ * place anymore as the GPU might still read from it. Instead a second
+ * texture is updated and swapped in. Each texture tracks the areas it
+ * is missing so only those get uploaded.
+ */
 struct _PhocCairoTexture {
   GObject parent;
 
@@ -31,7 +46,12 @@ struct _PhocCairoTexture {
   cairo_surface_t    *surface;
   cairo_t            *cairo;
 
-  struct wlr_texture *texture;
+  pixman_region32_t   damage;
+
+  struct wlr_texture *textures[2];
+  pixman_region32_t   stale[2];   /* areas where the texture lags behind the surface */
+  guint               front;
+  gboolean            front_in_use;
   struct wl_listener  renderer_destroy;
 };
 
@@ -121,8 +141,9 @@ handle_renderer_destroy (struct wl_listener *listener, void *data)
 {
   PhocCairoTexture *self = wl_container_of (listener, self, renderer_destroy);
 
-  /* Texter no longer valid */
-  self->texture = NULL;
+  /* Textures no longer valid */
+  self->textures[0] = NULL;
+  self->textures[1] = NULL;
 
   wl_list_remove (&self->renderer_destroy.link);
   wl_list_init (&self->renderer_destroy.link);
@@ -149,7 +170,7 @@ phoc_cairo_texture_constructed (GObject *object)
     return;
   }
   self->cairo = cairo_create (self->surface);
-  self->texture = wlr_texture_from_buffer (wlr_renderer, &self->buffer);
+  self->textures[self->front] = wlr_texture_from_buffer (wlr_renderer, &self->buffer);
   self->renderer_destroy.notify = handle_renderer_destroy;
   wl_signal_add (&wlr_renderer->events.destroy, &self->renderer_destroy);
 }
@@ -160,7 +181,11 @@ phoc_cairo_texture_finalize (GObject *object)
 {
   PhocCairoTexture *self = PHOC_CAIRO_TEXTURE (object);
 
-  g_clear_pointer (&self->texture, wlr_texture_destroy);
+  for (guint i = 0; i < G_N_ELEMENTS (self->textures); i++) {
+    g_clear_pointer (&self->textures[i], wlr_texture_destroy);
+    pixman_region32_fini (&self->stale[i]);
+  }
+  pixman_region32_fini (&self->damage);
   g_clear_pointer (&self->cairo, cairo_destroy);
   g_clear_pointer (&self->surface, cairo_surface_destroy);
   wlr_buffer_drop (&self->buffer);
@@ -207,6 +232,11 @@ phoc_cairo_texture_class_init (PhocCairoTextureClass *klass)
 static void
 phoc_cairo_texture_init (PhocCairoTexture *self)
 {
+  pixman_region32_init (&self->damage);
+  for (guint i = 0; i < G_N_ELEMENTS (self->stale); i++)
+    pixman_region32_init (&self->stale[i]);
+
+  wl_list_init (&self->renderer_destroy.link);
 }
 
 
@@ -228,27 +258,121 @@ phoc_cairo_texture_get_context (PhocCairoTexture *self)
 }
 
 
+/**
+ * phoc_cairo_texture_get_texture:
+ * @self: The cairo texture
+ *
+ * Get the texture to render. The texture is considered in use by the
+ * renderer afterwards so the next update goes to the other texture.
+ *
+ * Returns:(transfer none)(nullable): The texture
+ */
 struct wlr_texture *
 phoc_cairo_texture_get_texture (PhocCairoTexture *self)
 {
   g_assert (PHOC_IS_CAIRO_TEXTURE (self));
-  return self->texture;
+
+  self->front_in_use = TRUE;
+  return self->textures[self->front];
 }
 
+/**
+ * phoc_cairo_texture_add_damage_box:
+ * @self: The cairo texture
+ * @box: The changed area in surface coordinates
+ *
+ * Mark an area of the cairo surface as changed so it gets uploaded
+ * on the next [method@CairoTexture.update].
+ */
+void
+phoc_cairo_texture_add_damage_box (PhocCairoTexture *self, const struct wlr_box *box)
+{
+  g_assert (PHOC_IS_CAIRO_TEXTURE (self));
+
+  pixman_region32_union_rect (&self->damage, &self->damage,
+                              box->x, box->y, box->width, box->height);
+  pixman_region32_intersect_rect (&self->damage, &self->damage,
+                                  0, 0, self->width, self->height);
+}
 
+/**
+ * phoc_cairo_texture_update:
+ * @self: The cairo texture
+ *
+ * Upload the damaged areas of the cairo surface to the texture. If
+ * no damage was added since the last update the whole surface is
+ * uploaded.
+ */
 void
 phoc_cairo_texture_update (PhocCairoTexture *self)
 {
-  pixman_region32_t region;
+  PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+  guint target;
 
   g_assert (PHOC_IS_CAIRO_TEXTURE (self));
 
-  if (!self->texture)
+  if (!self->textures[self->front])
     return;
 
   cairo_surface_flush (self->surface);
 
-  pixman_region32_init_rect (&region, 0, 0, self->width, self->height);
-  wlr_texture_update_from_buffer (self->texture, &self->buffer, &region);
-  pixman_region32_fini (&region);
+  if (!pixman_region32_not_empty (&self->damage))
+    pixman_region32_union_rect (&self->damage, &self->damage, 0, 0, self->width, self->height);
+
+  for (guint i = 0; i < G_N_ELEMENTS (self->textures); i++) {
+    if (self->textures[i])
+      pixman_region32_union (&self->stale[i], &self->stale[i], &self->damage);
+  }
+  pixman_region32_clear (&self->damage);
+
+  /* Don't touch a texture the renderer might still be reading from */
+  target = self->front_in_use ? !self->front : self->front;
+
+  if (!self->textures[target]) {
+    struct wlr_renderer *wlr_renderer = phoc_renderer_get_wlr_renderer (renderer);
+
+    self->textures[target] = wlr_texture_from_buffer (wlr_renderer, &self->buffer);
+    if (self->textures[target]) {
+      /* A new texture is created with the surface's current content */
+      pixman_region32_clear (&self->stale[target]);
+    } else {
+      target = self->front;
+    }
+  }
+
+  if (pixman_region32_not_empty (&self->stale[target])) {
+    /* Renderers without uploads (pixman) read from the buffer directly */
+    if (!wlr_texture_update_from_buffer (self->textures[target], &self->buffer,
+                                         &self->stale[target])) {
+      g_debug ("Texture %p not updated", self->textures[target]);
+    }
+    pixman_region32_clear (&self->stale[target]);
+  }
+
+  self->front = target;
+  self->front_in_use = FALSE;
+}
+
+/**
+ * phoc_cairo_texture_get_stale:
+ * @self: The cairo texture
+ * @texture: One of the textures handed out by [method@CairoTexture.get_texture]
+ *
+ * Get the areas where @texture lags behind the cairo surface. These
+ * get uploaded once @texture is updated again.
+ *
+ * Returns:(transfer none)(nullable): The stale areas or `NULL` if
+ *   @texture isn't one of ours
+ */
+const pixman_region32_t *
+phoc_cairo_texture_get_stale (PhocCairoTexture *self, struct wlr_texture *texture)
+{
+  g_assert (PHOC_IS_CAIRO_TEXTURE (self));
+
+  for (guint i = 0; i < G_N_ELEMENTS (self->textures); i++) {
+    if (texture && self->textures[i] == texture)
+      return &self->stale[i];
+  }
+
+  return NULL;
 }
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <glib-object.h>
+#include <pixman.h>
+#include <wlr/util/box.h>
 
 G_BEGIN_DECLS
 
@@ -19,6 +21,10 @@ typedef struct _cairo cairo_t;
 PhocCairoTexture   *phoc_cairo_texture_new         (int width, int height);
 cairo_t            *phoc_cairo_texture_get_context (PhocCairoTexture *self);
 struct wlr_texture *phoc_cairo_texture_get_texture (PhocCairoTexture *self);
+void                phoc_cairo_texture_add_damage_box (PhocCairoTexture     *self,
+                                                       const struct wlr_box *box);
 void                phoc_cairo_texture_update      (PhocCairoTexture *self);
+const pixman_region32_t *phoc_cairo_texture_get_stale (PhocCairoTexture   *self,
+                                                       struct wlr_texture *texture);
 
 G_END_DECLS
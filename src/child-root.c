@@ -64,6 +64,21 @@ phoc_child_root_apply_damage (PhocChildRoot *self)
 }
 
 
+void
+phoc_child_root_apply_surface_damage (PhocChildRoot      *self,
+                                      struct wlr_surface *surface,
+                                      int                 sx,
+                                      int                 sy)
+{
+  PhocChildRootInterface *iface;
+
+  g_assert (PHOC_IS_CHILD_ROOT (self));
+  iface = PHOC_CHILD_ROOT_GET_IFACE (self);
+
+  iface->apply_surface_damage (self, surface, sx, sy);
+}
+
+
 void
 phoc_child_root_add_child (PhocChildRoot *self, PhocViewChild  *child)
 {
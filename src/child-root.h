@@ -25,6 +25,8 @@ G_DECLARE_INTERFACE (PhocChildRoot, phoc_child_root, PHOC, CHILD_ROOT, GObject)
  * @get_box: Get the root's surface box
  * @is_mapped: Check whether the root is mapped
  * @apply_damage: Submit the accumulated damage for the root and its children
+ * @apply_surface_damage: Submit the accumulated damage of a single
+ *   surface of the tree. The position is relative to the root.
  * @add_child: Invoked when a new child should is added
  * @remove_child: Invoked when a child should no longer be tracked by the root.
  * @unconstrain_popup: Get a box that the popup can use to unconstrain itself.
@@ -41,6 +43,10 @@ struct _PhocChildRootInterface
   void         (*get_box)           (PhocChildRoot *root, struct wlr_box *box);
   gboolean     (*is_mapped)         (PhocChildRoot *root);
   void         (*apply_damage)      (PhocChildRoot *root);
+  void         (*apply_surface_damage) (PhocChildRoot      *root,
+                                        struct wlr_surface *surface,
+                                        int                 sx,
+                                        int                 sy);
   void         (*add_child)         (PhocChildRoot *root, PhocViewChild *child);
   void         (*remove_child)      (PhocChildRoot *root, PhocViewChild *child);
   gboolean     (*unconstrain_popup) (PhocChildRoot *root, struct wlr_box *box);
@@ -50,6 +56,10 @@ void                    phoc_child_root_get_box                 (PhocChildRoot
                                                                  struct wlr_box *box);
 gboolean                phoc_child_root_is_mapped               (PhocChildRoot  *self);
 void                    phoc_child_root_apply_damage            (PhocChildRoot  *self);
+void                    phoc_child_root_apply_surface_damage    (PhocChildRoot      *self,
+                                                                 struct wlr_surface *surface,
+                                                                 int                 sx,
+                                                                 int                 sy);
 void                    phoc_child_root_add_child               (PhocChildRoot  *self,
                                                                  PhocViewChild  *child);
 void                    phoc_child_root_remove_child            (PhocChildRoot  *self,
@@ -14,6 +14,7 @@
 #include "gesture-drag.h"
 #include "gesture-swipe.h"
 #include "gesture.h"
+#include "input-device.h"
 #include "input-method-relay.h"
 #include "layer-shell-effects.h"
 #include "server.h"
@@ -52,6 +53,15 @@ typedef struct _PhocCursorPrivate {
 
   gboolean                   has_pointer_motion;
 
+  /* Motion accumulated until the end of the current input frame */
+  struct {
+    struct wlr_input_device *device;
+    double                   dx, dy;
+    guint32                  time_msec;
+    gboolean                 pending;
+  } pointer_motion;
+  GArray                    *touch_motions;  /* PhocPendingTouchMotion */
+
   /* State of the animated view when cursor touches a screen edge */
   struct {
     PhocColorRect         *rect;
@@ -77,6 +87,15 @@ typedef struct _PhocCursorPrivate {
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhocCursor, phoc_cursor, G_TYPE_OBJECT)
 
+/* Latest motion of a touch point within the current input frame */
+typedef struct {
+  struct wlr_touch_motion_event event;
+  double                        lx, ly;
+} PhocPendingTouchMotion;
+
+/* Enough for all fingers so we don't need to grow on motion */
+#define PHOC_CURSOR_PREALLOC_TOUCH_MOTIONS 10
+
 #define PHOC_CURSOR_SELF(p) PHOC_PRIV_CONTAINER(PHOC_CURSOR, PhocCursor, (p))
 
 static void handle_pointer_motion_relative (struct wl_listener *listener, void *data);
@@ -85,6 +104,7 @@ static void handle_pointer_button (struct wl_listener *listener, void *data);
 static void handle_pointer_axis (struct wl_listener *listener, void *data);
 static void handle_pointer_frame (struct wl_listener *listener, void *data);
 static void handle_touch_frame (struct wl_listener *listener, void *data);
+static void flush_touch_motions (PhocCursor *self);
 
 /* {{{ Cursor image */
 
@@ -566,6 +586,9 @@ send_touch_cancel (PhocSeat *seat, struct wlr_surface *surface)
   struct wl_client *client = wl_resource_get_client (surface->resource);
   struct wlr_seat_client *seat_client;
 
+  /* Clients need to see the motion that happened before the cancel */
+  flush_touch_motions (seat->cursor);
+
   seat_client = wlr_seat_client_for_wl_client (seat->seat, client);
   if (!seat_client)
     return;
@@ -695,17 +718,20 @@ handle_gestures_for_event_at (PhocCursor   *self,
                               gpointer      wlr_event,
                               gsize         size)
 {
-  g_autoptr (PhocEvent) event = phoc_event_new (type, wlr_event, size);
   GSList *gestures = phoc_cursor_get_gestures (self);
+  PhocEvent event;
 
   if (gestures == NULL)
     return;
 
+  /* Gestures copy what they need so the event can live on the stack */
+  phoc_event_init (&event, type, wlr_event, size);
+
   for (GSList *elem = gestures; elem; elem = elem->next) {
     PhocGesture *gesture = PHOC_GESTURE (elem->data);
 
     g_assert (PHOC_IS_GESTURE (gesture));
-    phoc_gesture_handle_event (gesture, event, lx, ly);
+    phoc_gesture_handle_event (gesture, &event, lx, ly);
   }
 }
 
@@ -979,6 +1005,7 @@ phoc_cursor_finalize (GObject *object)
 
   phoc_cursor_clear_view_state_change (self);
   g_clear_pointer (&priv->touch_points, g_hash_table_destroy);
+  g_clear_pointer (&priv->touch_motions, g_array_unref);
   g_clear_pointer (&priv->gestures, free_gestures);
 
   g_clear_object (&priv->interface_settings);
@@ -999,6 +1026,7 @@ phoc_cursor_finalize (GObject *object)
   wl_list_remove (&self->touch_down.link);
   wl_list_remove (&self->touch_up.link);
   wl_list_remove (&self->touch_motion.link);
+  wl_list_remove (&self->touch_cancel.link);
   wl_list_remove (&self->touch_frame.link);
   wl_list_remove (&self->tool_axis.link);
   wl_list_remove (&self->tool_tip.link);
@@ -1177,6 +1205,10 @@ phoc_cursor_init (PhocCursor *self)
                                               g_direct_equal,
                                               NULL,
                                               (GDestroyNotify)phoc_touch_point_destroy);
+  priv->touch_motions = g_array_sized_new (FALSE,
+                                           FALSE,
+                                           sizeof (PhocPendingTouchMotion),
+                                           PHOC_CURSOR_PREALLOC_TOUCH_MOTIONS);
   /*
    * Drag gesture starting at the current cursor position
    */
@@ -1390,13 +1422,33 @@ phoc_cursor_press_button (PhocCursor              *self,
 }
 
 
+/*
+ * Relative pointer clients get every event unmodified, even when
+ * motion is coalesced, as e.g. games rely on the raw deltas.
+ */
+static void
+send_relative_motion (PhocCursor *self,
+                      double      dx,
+                      double      dy,
+                      double      dx_unaccel,
+                      double      dy_unaccel,
+                      guint32     time_msec)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+
+  wlr_relative_pointer_manager_v1_send_relative_motion (desktop->relative_pointer_manager,
+                                                        self->seat->seat,
+                                                        (uint64_t)time_msec * 1000,
+                                                        dx, dy,
+                                                        dx_unaccel, dy_unaccel);
+}
+
+
 static void
 phoc_cursor_pointer_motion (PhocCursor              *self,
                             struct wlr_input_device *device,
                             double                   dx,
                             double                   dy,
-                            double                   dx_unaccel,
-                            double                   dy_unaccel,
                             guint32                  time_msec)
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
@@ -1408,12 +1460,6 @@ phoc_cursor_pointer_motion (PhocCursor              *self,
   }
   phoc_seat_notify_activity (self->seat);
 
-  wlr_relative_pointer_manager_v1_send_relative_motion (desktop->relative_pointer_manager,
-                                                        self->seat->seat,
-                                                        (uint64_t)time_msec * 1000,
-                                                        dx, dy,
-                                                        dx_unaccel, dy_unaccel);
-
   if (self->active_constraint && device->type == WLR_INPUT_DEVICE_POINTER) {
     struct wlr_surface *wlr_surface;
     double sx, sy, sx_out, sy_out;
@@ -1438,6 +1484,59 @@ phoc_cursor_pointer_motion (PhocCursor              *self,
 }
 
 
+static void
+flush_pointer_motion (PhocCursor *self)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  if (!priv->pointer_motion.pending)
+    return;
+
+  priv->pointer_motion.pending = FALSE;
+  phoc_cursor_pointer_motion (self,
+                              priv->pointer_motion.device,
+                              priv->pointer_motion.dx,
+                              priv->pointer_motion.dy,
+                              priv->pointer_motion.time_msec);
+}
+
+/*
+ * Accumulate pointer motion until the end of the input frame so focus
+ * is resolved and clients are notified once per frame. Returns %FALSE
+ * if the device doesn't coalesce motion and the motion should be
+ * processed right away.
+ */
+static gboolean
+queue_pointer_motion (PhocCursor              *self,
+                      struct wlr_input_device *device,
+                      double                   dx,
+                      double                   dy,
+                      guint32                  time_msec)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+  PhocInputDevice *input_device = device->data;
+
+  if (priv->pointer_motion.pending && priv->pointer_motion.device != device)
+    flush_pointer_motion (self);
+
+  if (!input_device || !phoc_input_device_get_coalesce_motion (input_device))
+    return FALSE;
+
+  if (!priv->pointer_motion.pending) {
+    priv->pointer_motion.device = device;
+    priv->pointer_motion.dx = 0;
+    priv->pointer_motion.dy = 0;
+    priv->pointer_motion.pending = TRUE;
+  }
+
+  priv->pointer_motion.dx += dx;
+  priv->pointer_motion.dy += dy;
+  priv->pointer_motion.time_msec = time_msec;
+
+  return TRUE;
+}
+
+
 static void
 handle_pointer_motion_relative (struct wl_listener *listener, void *data)
 {
@@ -1446,13 +1545,12 @@ handle_pointer_motion_relative (struct wl_listener *listener, void *data)
   double dx = event->delta_x;
   double dy = event->delta_y;
 
-  phoc_cursor_pointer_motion (self,
-                              &event->pointer->base,
-                              dx,
-                              dy,
-                              event->unaccel_dx,
-                              event->unaccel_dy,
-                              event->time_msec);
+  send_relative_motion (self, dx, dy, event->unaccel_dx, event->unaccel_dy, event->time_msec);
+
+  if (queue_pointer_motion (self, &event->pointer->base, dx, dy, event->time_msec))
+    return;
+
+  phoc_cursor_pointer_motion (self, &event->pointer->base, dx, dy, event->time_msec);
 }
 
 
@@ -1461,6 +1559,7 @@ handle_pointer_motion_absolute (struct wl_listener *listener, void *data)
 {
   PhocCursor *self = wl_container_of (listener, self, motion_absolute);
   struct wlr_pointer_motion_absolute_event *event = data;
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
   double dx, dy, lx, ly;
 
   wlr_cursor_absolute_to_layout_coords (self->cursor,
@@ -1470,10 +1569,23 @@ handle_pointer_motion_absolute (struct wl_listener *listener, void *data)
 
   handle_gestures_for_event_at (self, lx, ly, PHOC_EVENT_MOTION_NOTIFY, event, sizeof (*event));
 
+  if (priv->pointer_motion.pending && priv->pointer_motion.device != &event->pointer->base)
+    flush_pointer_motion (self);
+
   dx = lx - self->cursor->x;
   dy = ly - self->cursor->y;
+  /* Relative to where the queued motion will take the cursor */
+  if (priv->pointer_motion.pending) {
+    dx -= priv->pointer_motion.dx;
+    dy -= priv->pointer_motion.dy;
+  }
+
+  send_relative_motion (self, dx, dy, dx, dy, event->time_msec);
+
+  if (queue_pointer_motion (self, &event->pointer->base, dx, dy, event->time_msec))
+    return;
 
-  phoc_cursor_pointer_motion (self, &event->pointer->base, dx, dy, dx, dy, event->time_msec);
+  phoc_cursor_pointer_motion (self, &event->pointer->base, dx, dy, event->time_msec);
 }
 
 
@@ -1485,6 +1597,9 @@ handle_pointer_button (struct wl_listener *listener, void *data)
   PhocEventType type;
   bool is_touch = event->pointer->base.type == WLR_INPUT_DEVICE_TOUCH;
 
+  /* Buttons act on the position the pointer moved to */
+  flush_pointer_motion (self);
+
   phoc_seat_notify_activity (self->seat);
   g_debug ("%s %d is_touch: %d", __func__, __LINE__, is_touch);
   if (!is_touch) {
@@ -1524,6 +1639,8 @@ handle_pointer_axis (struct wl_listener *listener, void *data)
   struct wlr_pointer_axis_event *event = data;
   PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
 
+  flush_pointer_motion (self);
+
   if (!priv->has_pointer_motion) {
     priv->has_pointer_motion = TRUE;
     phoc_cursor_show (self);
@@ -1539,6 +1656,8 @@ handle_pointer_frame (struct wl_listener *listener, void *data)
 {
   PhocCursor *self = wl_container_of (listener, self, frame);
 
+  flush_pointer_motion (self);
+
   phoc_seat_notify_activity (self->seat);
   wlr_seat_pointer_notify_frame (self->seat->seat);
 
@@ -1559,6 +1678,9 @@ phoc_cursor_handle_touch_down (PhocCursor                  *self,
   PhocTouchPoint *touch_point;
   double lx, ly;
 
+  /* Keep the order of events as seen by clients */
+  flush_touch_motions (self);
+
   touch_point = phoc_cursor_add_touch_point (self, event);
   lx = touch_point->lx;
   ly = touch_point->ly;
@@ -1611,6 +1733,9 @@ phoc_cursor_handle_touch_up (PhocCursor                *self,
   if (!touch_point)
     return;
 
+  /* Clients need to see the last position before the point goes away */
+  flush_touch_motions (self);
+
   handle_gestures_for_event_at (self, touch_point->lx, touch_point->ly,
                                 PHOC_EVENT_TOUCH_END, event, sizeof (*event));
   phoc_cursor_remove_touch_point (self, event->touch_id);
@@ -1635,20 +1760,47 @@ phoc_cursor_handle_touch_up (PhocCursor                *self,
 
 
 void
-phoc_cursor_handle_touch_motion (PhocCursor                    *self,
-                                 struct wlr_touch_motion_event *event)
+phoc_cursor_handle_touch_cancel (PhocCursor                    *self,
+                                 struct wlr_touch_cancel_event *event)
 {
-  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
-  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
   struct wlr_touch_point *point;
   PhocTouchPoint *touch_point;
-  double lx, ly;
 
-  touch_point = phoc_cursor_update_touch_point (self, event);
-  g_return_if_fail (touch_point);
-  lx = touch_point->lx;
-  ly = touch_point->ly;
-  handle_gestures_for_event_at (self, lx, ly, PHOC_EVENT_TOUCH_UPDATE, event, sizeof (*event));
+  g_assert (PHOC_IS_CURSOR (self));
+
+  touch_point = phoc_cursor_get_touch_point (self, event->touch_id);
+  /* Don't process unknown touch points */
+  if (!touch_point)
+    return;
+
+  /* Like touch up clients see the pending motion before the cancel */
+  flush_touch_motions (self);
+
+  handle_gestures_for_event_at (self, touch_point->lx, touch_point->ly,
+                                PHOC_EVENT_TOUCH_CANCEL, event, sizeof (*event));
+  phoc_cursor_remove_touch_point (self, event->touch_id);
+
+  if (self->seat->touch_id == event->touch_id)
+    self->seat->touch_id = -1;
+
+  point = wlr_seat_touch_get_point (self->seat->seat, event->touch_id);
+  /* If the gesture got canceled the client already knows */
+  if (!point)
+    return;
+
+  send_touch_cancel (self->seat, point->surface);
+}
+
+
+static void
+deliver_touch_motion (PhocCursor                    *self,
+                      struct wlr_touch_motion_event *event,
+                      double                         lx,
+                      double                         ly)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+  struct wlr_touch_point *point;
 
   point = wlr_seat_touch_get_point (self->seat->seat, event->touch_id);
   /* If the gesture got canceled don't notify any clients */
@@ -1746,18 +1898,123 @@ phoc_cursor_handle_touch_motion (PhocCursor                    *self,
 }
 
 
+static void
+flush_touch_motions (PhocCursor *self)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  for (guint i = 0; i < priv->touch_motions->len; i++) {
+    PhocPendingTouchMotion *motion = &g_array_index (priv->touch_motions,
+                                                     PhocPendingTouchMotion,
+                                                     i);
+    deliver_touch_motion (self, &motion->event, motion->lx, motion->ly);
+  }
+  g_array_set_size (priv->touch_motions, 0);
+}
+
+
+static void
+queue_touch_motion (PhocCursor                    *self,
+                    struct wlr_touch_motion_event *event,
+                    double                         lx,
+                    double                         ly)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+  PhocPendingTouchMotion *motion = NULL;
+
+  /* Only the latest position of each touch point matters to clients */
+  for (guint i = 0; i < priv->touch_motions->len; i++) {
+    PhocPendingTouchMotion *pending = &g_array_index (priv->touch_motions,
+                                                      PhocPendingTouchMotion,
+                                                      i);
+    if (pending->event.touch_id == event->touch_id) {
+      motion = pending;
+      break;
+    }
+  }
+
+  if (motion == NULL) {
+    g_array_set_size (priv->touch_motions, priv->touch_motions->len + 1);
+    motion = &g_array_index (priv->touch_motions,
+                             PhocPendingTouchMotion,
+                             priv->touch_motions->len - 1);
+  }
+
+  motion->event = *event;
+  motion->lx = lx;
+  motion->ly = ly;
+}
+
+
+void
+phoc_cursor_handle_touch_motion (PhocCursor                    *self,
+                                 struct wlr_touch_motion_event *event)
+{
+  PhocInputDevice *input_device = event->touch->base.data;
+  PhocTouchPoint *touch_point;
+  double lx, ly;
+
+  touch_point = phoc_cursor_update_touch_point (self, event);
+  g_return_if_fail (touch_point);
+  lx = touch_point->lx;
+  ly = touch_point->ly;
+  /* Gestures want every sample for accurate velocities */
+  handle_gestures_for_event_at (self, lx, ly, PHOC_EVENT_TOUCH_UPDATE, event, sizeof (*event));
+
+  if (input_device && phoc_input_device_get_coalesce_motion (input_device)) {
+    queue_touch_motion (self, event, lx, ly);
+    return;
+  }
+
+  deliver_touch_motion (self, event, lx, ly);
+}
+
+
 static void
 handle_touch_frame (struct wl_listener *listener, void *data)
 {
   PhocCursor *self = PHOC_CURSOR (wl_container_of (listener, self, touch_frame));
   struct wlr_seat *wlr_seat = self->seat->seat;
 
+  flush_touch_motions (self);
+
   wlr_seat_touch_notify_frame(wlr_seat);
 
   // make sure to always send frame events when necessary even when bypassing seat grabs
   wlr_seat_touch_send_frame (wlr_seat);
 }
 
+/**
+ * phoc_cursor_drop_pending_motion:
+ * @self: The cursor
+ * @device: The input device that goes away
+ *
+ * Drop motion of @device that was queued until the end of the current
+ * input frame so it doesn't outlive the device.
+ */
+void
+phoc_cursor_drop_pending_motion (PhocCursor *self, struct wlr_input_device *device)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  g_assert (PHOC_IS_CURSOR (self));
+
+  if (priv->pointer_motion.pending && priv->pointer_motion.device == device) {
+    priv->pointer_motion.pending = FALSE;
+    priv->pointer_motion.device = NULL;
+  }
+
+  for (guint i = 0; i < priv->touch_motions->len;) {
+    PhocPendingTouchMotion *motion = &g_array_index (priv->touch_motions,
+                                                     PhocPendingTouchMotion,
+                                                     i);
+    if (&motion->event.touch->base == device)
+      g_array_remove_index (priv->touch_motions, i);
+    else
+      i++;
+  }
+}
+
 
 void
 phoc_cursor_handle_tool_axis (PhocCursor                        *self,
@@ -83,6 +83,7 @@ typedef struct _PhocCursor {
   struct wl_listener                touch_down;
   struct wl_listener                touch_up;
   struct wl_listener                touch_motion;
+  struct wl_listener                touch_cancel;
   struct wl_listener                touch_frame;
 
   struct wl_listener                tool_axis;
@@ -106,6 +107,10 @@ void        phoc_cursor_handle_touch_up (PhocCursor
                                          struct wlr_touch_up_event                       *event);
 void        phoc_cursor_handle_touch_motion (PhocCursor                                  *self,
                                              struct wlr_touch_motion_event               *event);
+void        phoc_cursor_handle_touch_cancel (PhocCursor                                  *self,
+                                             struct wlr_touch_cancel_event               *event);
+void        phoc_cursor_drop_pending_motion (PhocCursor                                  *self,
+                                             struct wlr_input_device                     *device);
 void        phoc_cursor_handle_tool_axis (PhocCursor                                     *self,
                                           struct wlr_tablet_tool_axis_event              *event);
 void        phoc_cursor_handle_tool_tip (PhocCursor                                      *self,
@@ -11,6 +11,8 @@
 #include "phoc-config.h"
 #include "phoc-enums.h"
 #include "debug-control.h"
+#include "desktop.h"
+#include "output.h"
 #include "server.h"
 
 #include <gio/gio.h>
@@ -46,9 +48,62 @@ G_DEFINE_TYPE_WITH_CODE (PhocDebugControl, phoc_debug_control,
                          G_IMPLEMENT_INTERFACE (PHOC_DBUS_TYPE_DEBUG_CONTROL,
                                                 phoc_dbus_debug_control_iface_init))
 
+static gboolean
+handle_get_output_stats (PhocDBusDebugControl  *object,
+                         GDBusMethodInvocation *invocation)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  GVariantBuilder builder;
+  PhocOutput *output;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+  wl_list_for_each (output, &desktop->outputs, link) {
+    g_variant_builder_add (&builder, "{s@a{sv}}",
+                           output->wlr_output->name,
+                           phoc_output_stats_to_variant (phoc_output_get_stats (output)));
+  }
+
+  phoc_dbus_debug_control_complete_get_output_stats (object,
+                                                     invocation,
+                                                     g_variant_builder_end (&builder));
+  return TRUE;
+}
+
+
+static gboolean
+handle_reset_output_stats (PhocDBusDebugControl  *object,
+                           GDBusMethodInvocation *invocation)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    phoc_output_stats_reset (phoc_output_get_stats (output));
+
+  phoc_dbus_debug_control_complete_reset_output_stats (object, invocation);
+  return TRUE;
+}
+
+
+static gboolean
+handle_get_surface_stats (PhocDBusDebugControl  *object,
+                          GDBusMethodInvocation *invocation)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+
+  phoc_dbus_debug_control_complete_get_surface_stats (object,
+                                                      invocation,
+                                                      phoc_desktop_get_surface_stats (desktop));
+  return TRUE;
+}
+
+
 static void
 phoc_dbus_debug_control_iface_init (PhocDBusDebugControlIface *iface)
 {
+  iface->handle_get_output_stats = handle_get_output_stats;
+  iface->handle_reset_output_stats = handle_reset_output_stats;
+  iface->handle_get_surface_stats = handle_get_surface_stats;
 }
 
 
@@ -3,6 +3,7 @@
 #include "phoc-config.h"
 
 #include <assert.h>
+#include <time.h>
 #include <wlr/config.h>
 #include <wlr/types/wlr_alpha_modifier_v1.h>
 #include <wlr/types/wlr_compositor.h>
@@ -35,9 +36,12 @@
 #include "idle-inhibit.h"
 #include "layer-shell.h"
 #include "output.h"
+#include "phoc-priorities.h"
 #include "seat.h"
 #include "server.h"
 #include "shortcuts-inhibit.h"
+#include "spatial-index.h"
+#include "surface.h"
 #include "color-rect.h"
 #include "timed-animation.h"
 #include "outputs-states.h"
@@ -62,6 +66,8 @@
 #define PHOC_ANIM_ALWAYS_ON_TOP_COLOR_OFF (PhocColor){0.3f, 0.5f, 0.3f, 0.5f}
 #define PHOC_ANIM_ALWAYS_ON_TOP_WIDTH     10
 
+#define PHOC_DESKTOP_VIEW_INDEX_CELL_SIZE 256
+
 /**
  * PhocDesktop:
  *
@@ -104,6 +110,24 @@ typedef struct _PhocDesktopPrivate {
   PhocWorkspace         *active_workspace;
 
   PhocXxCutoutsManager  *xx_cutouts_manager;
+
+  /* Hit testing */
+  PhocSpatialIndex      *view_index;
+  GHashTable            *tracked_views;   /* views known to the index */
+  GHashTable            *dirty_views;     /* views whose input bounds need updating */
+  GHashTable            *view_ranks;      /* view → position in the active workspace + 1 */
+  PhocWorkspace         *ranks_workspace;
+  guint                  ranks_serial;
+
+  /* Visibility tracking */
+  gboolean               visibility_dirty;
+  gboolean               updating_visibility;
+  PhocWorkspace         *visibility_workspace;
+  guint                  visibility_serial;
+
+  /* Frame callbacks for surfaces not on any output */
+  GHashTable            *hidden_views;    /* mapped views not visible on any output */
+  guint                  hidden_frame_id;
 } PhocDesktopPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhocDesktop, phoc_desktop, G_TYPE_OBJECT);
@@ -181,6 +205,55 @@ view_at (PhocView *view, double lx, double ly, struct wlr_surface **surface, dou
   return false;
 }
 
+static void
+update_view_index (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  PhocWorkspace *workspace = priv->active_workspace;
+  guint serial = phoc_workspace_get_stack_serial (workspace);
+  GHashTableIter iter;
+  gpointer view;
+  guint rank = 1;
+
+  g_hash_table_iter_init (&iter, priv->dirty_views);
+  while (g_hash_table_iter_next (&iter, &view, NULL)) {
+    struct wlr_box box;
+
+    /* Add a pixel on each side to account for rounding */
+    if (phoc_view_get_input_bounds (PHOC_VIEW (view), &box)) {
+      box.x -= 1;
+      box.y -= 1;
+      box.width += 2;
+      box.height += 2;
+    }
+    phoc_spatial_index_update (priv->view_index, view, &box);
+    g_hash_table_iter_remove (&iter);
+  }
+
+  if (priv->ranks_workspace == workspace && priv->ranks_serial == serial)
+    return;
+
+  g_hash_table_remove_all (priv->view_ranks);
+  for (GList *l = phoc_workspace_get_views (workspace)->head; l; l = l->next)
+    g_hash_table_insert (priv->view_ranks, l->data, GUINT_TO_POINTER (rank++));
+
+  priv->ranks_workspace = workspace;
+  priv->ranks_serial = serial;
+}
+
+
+static int
+compare_view_rank (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  GHashTable *ranks = user_data;
+  /* Views not on the active workspace sort last */
+  guint rank_a = GPOINTER_TO_UINT (g_hash_table_lookup (ranks, *(gpointer *)a)) - 1;
+  guint rank_b = GPOINTER_TO_UINT (g_hash_table_lookup (ranks, *(gpointer *)b)) - 1;
+
+  return (rank_a > rank_b) - (rank_a < rank_b);
+}
+
+
 static PhocView *
 desktop_view_at (PhocDesktop         *self,
                  double               lx,
@@ -190,9 +263,22 @@ desktop_view_at (PhocDesktop         *self,
                  double              *sy)
 {
   PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  GPtrArray *candidates;
 
-  for (GList *l = phoc_workspace_get_views (priv->active_workspace)->head; l; l = l->next) {
-    PhocView *view = PHOC_VIEW (l->data);
+  update_view_index (self);
+
+  /* Only views whose input bounds contain the point can be hit, check
+   * them in render order */
+  candidates = phoc_spatial_index_query_point (priv->view_index, lx, ly);
+  if (candidates->len > 1)
+    g_ptr_array_sort_with_data (candidates, compare_view_rank, priv->view_ranks);
+
+  for (guint i = 0; i < candidates->len; i++) {
+    PhocView *view = PHOC_VIEW (g_ptr_array_index (candidates, i));
+
+    /* Not on the active workspace */
+    if (!g_hash_table_contains (priv->view_ranks, view))
+      break;
 
     if (phoc_desktop_view_check_visibility (self, view) && view_at (view, lx, ly, surface, sx, sy))
       return view;
@@ -342,81 +428,394 @@ phoc_desktop_wlr_surface_at (PhocDesktop *desktop,
   return NULL;
 }
 
+static gboolean
+output_is_covered (PhocOutput *output)
+{
+  GQueue *layer_surfaces;
+
+  layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
+  for (GList *l = layer_surfaces->head; l; l = l->next) {
+    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
+
+    if (phoc_layer_surface_covers_output (layer_surface))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+static gboolean
+is_shown_with_fullscreen_view (PhocOutput *output, PhocView *view)
+{
+  if (output->fullscreen_view == view)
+    return TRUE;
+
+  /* Like the render list we only show XWayland children */
+  if (PHOC_IS_XWAYLAND_SURFACE (output->fullscreen_view) && PHOC_IS_XWAYLAND_SURFACE (view)) {
+    return phoc_xwayland_surface_is_child (PHOC_XWAYLAND_SURFACE (view),
+                                           PHOC_XWAYLAND_SURFACE (output->fullscreen_view));
+  }
+
+  return FALSE;
+}
+
+
+static gboolean
+is_hidden_by_maximized_view (PhocView *top_view, PhocView *view)
+{
+  /* XWayland parent relations can be complicated and aren't described by PhocView
+   * relationships very well at the moment, so just make all XWayland windows visible
+   * when some XWayland window is active for now */
+  if (PHOC_IS_XWAYLAND_SURFACE (view) && PHOC_IS_XWAYLAND_SURFACE (top_view))
+    return FALSE;
+
+  for (PhocView *v = top_view; v; v = v->parent) {
+    if (v == view)
+      return FALSE;
+
+    if (phoc_view_is_maximized (v))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+static void
+add_opaque_region (PhocView *view, pixman_region32_t *opaque)
+{
+  struct wlr_surface *surface = view->wlr_surface;
+  pixman_region32_t region;
+
+  /* Scaled or translucent views don't hide what's below them */
+  if (phoc_view_get_scale (view) != 1.0f || phoc_view_get_alpha (view) < 1.0f)
+    return;
+
+  pixman_region32_init (&region);
+  pixman_region32_intersect_rect (&region, &surface->opaque_region,
+                                  0, 0, surface->current.width, surface->current.height);
+  pixman_region32_translate (&region, view->box.x, view->box.y);
+  pixman_region32_union (opaque, opaque, &region);
+  pixman_region32_fini (&region);
+}
+
+/*
+ * Find out on which output each view is visible. Views are checked
+ * top to bottom and end up hidden if they are fully covered by
+ * opaque regions of views above or hidden by overlay layer surfaces
+ * covering the output, a fullscreen view or a maximized view in
+ * auto-maximize mode.
+ */
+static void
+update_output_visibility (PhocDesktop *self, PhocOutput *output, GQueue *views, guint32 *masks)
+{
+  guint32 mask = phoc_output_get_visibility_mask (output);
+  struct wlr_box output_box;
+  pixman_region32_t opaque;
+  PhocView *top_view = NULL;
+  guint i = 0;
+
+  wlr_output_layout_get_box (self->layout, output->wlr_output, &output_box);
+  if (wlr_box_empty (&output_box))
+    return;
+
+  if (output_is_covered (output))
+    return;
+
+  pixman_region32_init (&opaque);
+  for (GList *l = views->head; l; l = l->next, i++) {
+    PhocView *view = PHOC_VIEW (l->data);
+    struct wlr_box bounds, intersection;
+
+    if (!phoc_view_is_mapped (view))
+      continue;
+
+    if (!phoc_view_get_input_bounds (view, &bounds)) {
+      /* Nothing to go by, be pessimistic */
+      masks[i] |= mask;
+      continue;
+    }
+
+    if (!wlr_box_intersection (&intersection, &bounds, &output_box))
+      continue;
+
+    if (top_view == NULL)
+      top_view = view;
+
+    if (output->fullscreen_view && !is_shown_with_fullscreen_view (output, view))
+      continue;
+
+    if (self->maximize && is_hidden_by_maximized_view (top_view, view))
+      continue;
+
+    if (pixman_region32_contains_rectangle (&opaque,
+                                            &(pixman_box32_t) {
+                                              intersection.x,
+                                              intersection.y,
+                                              intersection.x + intersection.width,
+                                              intersection.y + intersection.height,
+                                            }) == PIXMAN_REGION_IN) {
+      continue;
+    }
+
+    masks[i] |= mask;
+    add_opaque_region (view, &opaque);
+  }
+  pixman_region32_fini (&opaque);
+}
+
+
+static void
+apply_view_visibility (PhocDesktop *self, PhocView *view, guint32 visible_outputs)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  guint32 changed = phoc_view_get_visible_outputs (view) ^ visible_outputs;
+  PhocOutput *output;
+
+  phoc_view_set_visible_outputs (view, visible_outputs);
+  if (visible_outputs == 0 && phoc_view_is_mapped (view))
+    g_hash_table_add (priv->hidden_views, view);
+  else
+    g_hash_table_remove (priv->hidden_views, view);
+
+  if (!changed)
+    return;
+
+  wl_list_for_each (output, &self->outputs, link) {
+    guint32 mask = phoc_output_get_visibility_mask (output);
+
+    if (!(changed & mask))
+      continue;
+
+    phoc_output_invalidate_render_list (output);
+    /* Damage got dropped while the view was hidden */
+    if (visible_outputs & mask)
+      phoc_output_damage_from_view (output, view, true);
+  }
+}
+
+
+static void update_hidden_frames (PhocDesktop *self);
+
+
+static gboolean
+hide_view_iter (PhocWorkspace *workspace, PhocView *view, gpointer user_data)
+{
+  PhocDesktop *self = PHOC_DESKTOP (user_data);
+
+  apply_view_visibility (self, view, 0);
+  return TRUE;
+}
+
+/**
+ * phoc_desktop_update_visibility:
+ * @self: The desktop
+ *
+ * Update the visible outputs of all views if anything changed since
+ * the last update. Views that become visible on an output get damaged
+ * there, views that aren't visible anywhere get suspended.
+ */
+void
+phoc_desktop_update_visibility (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv;
+  PhocWorkspace *workspace;
+  g_autofree guint32 *masks = NULL;
+  GQueue *views;
+  PhocOutput *output;
+  guint n_workspaces, serial, i = 0;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  priv = phoc_desktop_get_instance_private (self);
+  workspace = priv->active_workspace;
+  serial = phoc_workspace_get_stack_serial (workspace);
+
+  /* Damaging newly visible views ends up here again */
+  if (priv->updating_visibility)
+    return;
+
+  if (!priv->visibility_dirty &&
+      priv->visibility_workspace == workspace &&
+      priv->visibility_serial == serial) {
+    return;
+  }
+
+  priv->updating_visibility = TRUE;
+
+  views = phoc_workspace_get_views (workspace);
+  masks = g_new0 (guint32, views->length);
+
+  if (wl_list_empty (&self->outputs)) {
+    /* Nothing to go by, be pessimistic */
+    for (guint j = 0; j < views->length; j++)
+      masks[j] = G_MAXUINT32;
+  } else {
+    wl_list_for_each (output, &self->outputs, link)
+      update_output_visibility (self, output, views, masks);
+  }
+
+  for (GList *l = views->head; l; l = l->next)
+    apply_view_visibility (self, PHOC_VIEW (l->data), masks[i++]);
+
+  n_workspaces = phoc_workspace_manager_get_n_workspaces (priv->workspace_manager);
+  for (guint j = 0; j < n_workspaces; j++) {
+    PhocWorkspace *other = phoc_workspace_manager_get_by_index (priv->workspace_manager, j);
+
+    if (other != workspace)
+      phoc_workspace_for_each_view (other, hide_view_iter, self);
+  }
+
+  priv->visibility_workspace = workspace;
+  priv->visibility_serial = serial;
+  priv->visibility_dirty = FALSE;
+  priv->updating_visibility = FALSE;
+
+  update_hidden_frames (self);
+}
+
+/**
+ * phoc_desktop_invalidate_visibility:
+ * @self: The desktop
+ *
+ * Notify the desktop that views might have become visible or
+ * hidden, e.g. because a view moved or an overlay layer surface got
+ * mapped. The visibility is updated on next use.
+ */
+void
+phoc_desktop_invalidate_visibility (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  priv = phoc_desktop_get_instance_private (self);
+
+  priv->visibility_dirty = TRUE;
+}
+
 /**
  * phoc_desktop_view_check_visibility:
  * @self: The desktop
  * @view: The view to check
  *
- * Checks if a view is currently visible. This is currently very
+ * Checks if a view is currently visible on any output. This is
  * pessimistic and only assumes that the view is not visible when
- * we're certain it is covered by other windows.
+ * we're certain it is covered by other surfaces.
  *
  * Returns: `FALSE` when it's certain that the view is not visible, otherwise `TRUE`
  */
 gboolean
 phoc_desktop_view_check_visibility (PhocDesktop *self, PhocView *view)
 {
-  PhocDesktopPrivate *priv;
-  PhocOutput *output;
-  PhocView *top_view;
-  GQueue *layer_surfaces;
-  gboolean visible = TRUE;
-
   g_assert (PHOC_IS_DESKTOP (self));
   g_assert (PHOC_IS_VIEW (view));
 
-  priv = phoc_desktop_get_instance_private (self);
-
   if (!phoc_view_is_mapped (view)) {
-    visible = FALSE;
-    goto out;
+    phoc_view_set_visible_outputs (view, 0);
+    return FALSE;
   }
 
-  if (!phoc_workspace_has_view (priv->active_workspace, view)) {
-    visible = FALSE;
-    goto out;
-  }
+  phoc_desktop_update_visibility (self);
 
-  /* current heuristics work well only for single output */
-  if (wl_list_length (&self->outputs) != 1)
-    goto out;
+  return !!phoc_view_get_visible_outputs (view);
+}
 
-  output = wl_container_of (self->outputs.next, output, link);
-  layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
-  for (GList *l = layer_surfaces->head; l; l = l->next) {
-    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
+/**
+ * phoc_desktop_view_check_output_visibility:
+ * @self: The desktop
+ * @view: The view to check
+ * @output: The output to check
+ *
+ * Checks if a view is currently visible on the given output. See
+ * [method@Desktop.view_check_visibility].
+ *
+ * Returns: `FALSE` when it's certain that the view is not visible on
+ *   `output`, otherwise `TRUE`
+ */
+gboolean
+phoc_desktop_view_check_output_visibility (PhocDesktop *self, PhocView *view, PhocOutput *output)
+{
+  if (!phoc_desktop_view_check_visibility (self, view))
+    return FALSE;
 
-    if (phoc_layer_surface_covers_output (layer_surface)) {
-      visible = FALSE;
-      goto out;
-    }
-  }
+  return !!(phoc_view_get_visible_outputs (view) & phoc_output_get_visibility_mask (output));
+}
 
-  if (!self->maximize)
-    goto out;
 
-  top_view = phoc_workspace_get_view_by_index (priv->active_workspace, 0);
-  /* XWayland parent relations can be complicated and aren't described by PhocView
-   * relationships very well at the moment, so just make all XWayland windows visible
-   * when some XWayland window is active for now */
-  if (PHOC_IS_XWAYLAND_SURFACE (view) && PHOC_IS_XWAYLAND_SURFACE (top_view))
-    goto out;
 
-  for (PhocView *v = top_view; v; v = v->parent) {
-    if (v == view)
-      goto out;
+typedef struct {
+  GVariantBuilder *builder;
+  const char      *app_id;
+  gboolean         visible;
+} PhocSurfaceStatsData;
 
-    if (phoc_view_is_maximized (v)) {
-      visible = FALSE;
-      goto out;
-    }
+
+static void
+add_surface_stats_iter (struct wlr_surface *wlr_surface, int sx, int sy, void *data)
+{
+  PhocSurfaceStatsData *stats_data = data;
+  PhocSurface *surface = wlr_surface->data;
+  g_autoptr (GVariant) stats = NULL;
+  GVariantIter iter;
+  const char *key;
+  GVariant *value;
+
+  if (!surface)
+    return;
+
+  g_variant_builder_open (stats_data->builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (stats_data->builder, "{sv}", "app-id",
+                         g_variant_new_string (stats_data->app_id ?: ""));
+  g_variant_builder_add (stats_data->builder, "{sv}", "visible",
+                         g_variant_new_boolean (stats_data->visible));
+
+  stats = g_variant_ref_sink (phoc_surface_get_stats (surface));
+  g_variant_iter_init (&iter, stats);
+  while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+    g_variant_builder_add (stats_data->builder, "{sv}", key, value);
+    g_variant_unref (value);
   }
 
- out:
-  phoc_view_set_visibility (view, visible);
-  return visible;
+  g_variant_builder_close (stats_data->builder);
 }
 
+/**
+ * phoc_desktop_get_surface_stats:
+ * @self: The desktop
+ *
+ * Get the statistics of all mapped views' surfaces. See
+ * [method@Surface.get_stats] for the per surface statistics. Each
+ * entry additionally has the view's `app-id` and whether it is
+ * currently `visible`.
+ *
+ * Returns: (transfer floating): The statistics as `aa{sv}`
+ */
+GVariant *
+phoc_desktop_get_surface_stats (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  PhocView *view;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  priv = phoc_desktop_get_instance_private (self);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+  g_hash_table_iter_init (&iter, priv->tracked_views);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&view, NULL)) {
+    PhocSurfaceStatsData data = { .builder = &builder };
+
+    if (!phoc_view_is_mapped (view))
+      continue;
+
+    data.app_id = phoc_view_get_app_id (view);
+    data.visible = phoc_desktop_view_check_visibility (self, view);
+    phoc_view_for_each_surface (view, add_surface_stats_iter, &data);
+  }
+
+  return g_variant_builder_end (&builder);
+}
 
 struct move_to_layout_space_data {
   double center_x;
@@ -796,6 +1195,12 @@ phoc_desktop_finalize (GObject *object)
   g_clear_pointer (&priv->gtk_shell, phoc_gtk_shell_destroy);
   g_clear_object (&priv->layer_shell_effects);
   g_clear_object (&priv->xx_cutouts_manager);
+  g_clear_handle_id (&priv->hidden_frame_id, g_source_remove);
+  g_clear_pointer (&priv->view_ranks, g_hash_table_destroy);
+  g_clear_pointer (&priv->dirty_views, g_hash_table_destroy);
+  g_clear_pointer (&priv->hidden_views, g_hash_table_destroy);
+  g_clear_pointer (&priv->tracked_views, g_hash_table_destroy);
+  g_clear_pointer (&priv->view_index, phoc_spatial_index_free);
   g_clear_pointer (&self->layout, wlr_output_layout_destroy);
 
   g_clear_object (&priv->outputs_states);
@@ -841,6 +1246,34 @@ workspace_damage_view_iter (PhocWorkspace *workspace, PhocView *view, gpointer u
   return TRUE;
 }
 
+
+/* Whether the view is affected by the usable area of output changing */
+static gboolean
+view_is_on_output (PhocDesktop *self, PhocView *view, PhocOutput *output)
+{
+  PhocOutput *fullscreen_output = phoc_view_get_fullscreen_output (view);
+  struct wlr_box box;
+
+  if (fullscreen_output)
+    return fullscreen_output == output;
+
+  phoc_view_get_box (view, &box);
+  return wlr_output_layout_intersects (self->layout, output->wlr_output, &box);
+}
+
+
+static gboolean
+workspace_arrange_view_iter (PhocWorkspace *workspace, PhocView *view, gpointer user_data)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output = user_data;
+
+  if (output == NULL || view_is_on_output (desktop, view, output))
+    phoc_view_arrange (view, NULL, desktop->maximize);
+
+  return TRUE;
+}
+
 #define INDICATOR_OFFSET 16
 #define INDICATOR_SIZE 64
 
@@ -893,8 +1326,18 @@ on_active_workspace_changed (PhocDesktop *self, GParamSpec *pspec, PhocWorkspace
     phoc_workspace_for_each_view (priv->active_workspace, workspace_damage_view_iter, NULL);
 
   priv->active_workspace = phoc_workspace_manager_get_active (priv->workspace_manager);
+  priv->ranks_workspace = NULL;
+  priv->visibility_workspace = NULL;
   index = phoc_workspace_manager_get_active_index (priv->workspace_manager);
   show_workspace_indicator (self, index + 1);
+  phoc_desktop_invalidate_render_lists (self);
+
+  /* Usable areas changed while the workspace wasn't shown */
+  if (phoc_workspace_get_arrange_pending (priv->active_workspace)) {
+    g_debug ("Arranging views of workspace %d", index + 1);
+    phoc_workspace_for_each_view (priv->active_workspace, workspace_arrange_view_iter, NULL);
+    phoc_workspace_set_arrange_pending (priv->active_workspace, FALSE);
+  }
 
   phoc_workspace_for_each_view (priv->active_workspace, workspace_damage_view_iter, NULL);
 }
@@ -911,6 +1354,13 @@ phoc_desktop_init (PhocDesktop *self)
 
   priv = phoc_desktop_get_instance_private (self);
   priv->enable_animations = TRUE;
+  priv->visibility_dirty = TRUE;
+
+  priv->view_index = phoc_spatial_index_new (PHOC_DESKTOP_VIEW_INDEX_CELL_SIZE);
+  priv->tracked_views = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->dirty_views = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->hidden_views = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->view_ranks = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   self->input_output_map = g_hash_table_new_full (g_str_hash,
                                                   g_str_equal,
@@ -1329,6 +1779,8 @@ phoc_desktop_move_view_to_top (PhocDesktop *self, PhocView *view)
 
   g_assert (PHOC_IS_DESKTOP (self));
 
+  phoc_desktop_invalidate_render_lists (self);
+
   /* Fast path: check active workspace */
   if (phoc_workspace_has_view (priv->active_workspace, view)) {
       phoc_workspace_move_view_to_top (priv->active_workspace, view);
@@ -1353,6 +1805,90 @@ phoc_desktop_move_view_to_top (PhocDesktop *self, PhocView *view)
   g_assert_not_reached ();
 }
 
+typedef struct {
+  struct timespec when;
+  gint64          now_us;
+  gint64          interval_us;
+} PhocHiddenFrameData;
+
+
+static void
+send_hidden_frame_done_iter (struct wlr_surface *wlr_surface, int sx, int sy, void *data)
+{
+  PhocHiddenFrameData *frame_data = data;
+  PhocSurface *surface = wlr_surface->data;
+
+  if (!surface)
+    return;
+
+  /* Surfaces that are shown got their frame done with the last output frame */
+  if (frame_data->now_us - phoc_surface_get_last_frame_done (surface) < frame_data->interval_us)
+    return;
+
+  phoc_surface_send_frame_done (surface, &frame_data->when, TRUE);
+}
+
+
+static gboolean
+on_hidden_frame (gpointer data)
+{
+  PhocDesktop *self = PHOC_DESKTOP (data);
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+  PhocHiddenFrameData frame_data;
+  GHashTableIter iter;
+  PhocView *view;
+
+  phoc_desktop_update_visibility (self);
+  /* Updating the visibility stopped us as there are no hidden views */
+  if (priv->hidden_frame_id == 0)
+    return G_SOURCE_REMOVE;
+
+  frame_data.now_us = g_get_monotonic_time ();
+  frame_data.interval_us = G_USEC_PER_SEC / config->hidden_frame_rate;
+  clock_gettime (CLOCK_MONOTONIC, &frame_data.when);
+
+  g_hash_table_iter_init (&iter, priv->hidden_views);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&view, NULL)) {
+    /* Unmapped since the last visibility update */
+    if (!phoc_view_is_mapped (view))
+      continue;
+
+    phoc_view_for_each_surface (view, send_hidden_frame_done_iter, &frame_data);
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+/*
+ * Surfaces that aren't visible on any output don't get frame
+ * callbacks from the outputs' render loops. Complete them at a
+ * reduced rate so clients don't stall completely. The timer only runs
+ * while there are such views.
+ */
+static void
+update_hidden_frames (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+
+  if (config->hidden_frame_rate <= 0 || g_hash_table_size (priv->hidden_views) == 0) {
+    g_clear_handle_id (&priv->hidden_frame_id, g_source_remove);
+    return;
+  }
+
+  if (priv->hidden_frame_id)
+    return;
+
+  priv->hidden_frame_id = g_timeout_add_full (PHOC_PRIORITY_BOOKKEEPING,
+                                              MAX (1000 / config->hidden_frame_rate, 1),
+                                              on_hidden_frame,
+                                              self,
+                                              NULL);
+  g_source_set_name_by_id (priv->hidden_frame_id, "[phoc] hidden frame callbacks");
+}
+
 /**
  * phoc_desktop_insert_view:
  * @self: the desktop
@@ -1370,6 +1906,10 @@ phoc_desktop_insert_view (PhocDesktop *self, PhocView *view)
   priv = phoc_desktop_get_instance_private (self);
 
   phoc_workspace_insert_view (priv->active_workspace, view);
+  phoc_desktop_invalidate_render_lists (self);
+
+  g_hash_table_add (priv->tracked_views, view);
+  g_hash_table_add (priv->dirty_views, view);
 }
 
 /**
@@ -1391,11 +1931,19 @@ phoc_desktop_remove_view (PhocDesktop *self, PhocView *view)
   priv = phoc_desktop_get_instance_private (self);
   n_workspaces = phoc_workspace_manager_get_n_workspaces (priv->workspace_manager);
 
+  g_hash_table_remove (priv->tracked_views, view);
+  g_hash_table_remove (priv->dirty_views, view);
+  g_hash_table_remove (priv->hidden_views, view);
+  phoc_spatial_index_remove (priv->view_index, view);
+  update_hidden_frames (self);
+
   for (guint i = 0; i < n_workspaces; i++) {
     PhocWorkspace *workspace = phoc_workspace_manager_get_by_index (priv->workspace_manager, i);
 
-    if (phoc_workspace_remove_view (workspace, view))
+    if (phoc_workspace_remove_view (workspace, view)) {
+      phoc_desktop_invalidate_render_lists (self);
       return TRUE;
+    }
   }
 
   return FALSE;
@@ -1432,6 +1980,37 @@ phoc_desktop_for_each_view (PhocDesktop *self, PhocDesktopViewIter view_iter, gp
   }
 }
 
+
+/**
+ * phoc_desktop_arrange_views:
+ * @self: The desktop
+ * @output: The output whose usable area changed
+ *
+ * Arrange the views on the given output on the active workspace
+ * e.g. when the usable area changed. Views on inactive workspaces get
+ * arranged once their workspace becomes active.
+ */
+void
+phoc_desktop_arrange_views (PhocDesktop *self, PhocOutput *output)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  guint n_workspaces;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  g_assert (PHOC_IS_OUTPUT (output));
+
+  n_workspaces = phoc_workspace_manager_get_n_workspaces (priv->workspace_manager);
+  for (guint i = 0; i < n_workspaces; i++) {
+    PhocWorkspace *workspace = phoc_workspace_manager_get_by_index (priv->workspace_manager, i);
+
+    if (workspace != priv->active_workspace)
+      phoc_workspace_set_arrange_pending (workspace, TRUE);
+  }
+
+  if (priv->active_workspace)
+    phoc_workspace_for_each_view (priv->active_workspace, workspace_arrange_view_iter, output);
+}
+
 /**
  * phoc_desktop_for_each_unmanaged:
  * @self: The desktop
@@ -1475,8 +2054,8 @@ phoc_desktop_for_each_unmanaged (PhocDesktop              *self,
  *
  * Checks if a unmanaged surface is currently visible. This is
  * currently very pessimistic and only assumes that the unmanaged
- * surface is not visible when covered by a fulls screen layer
- * surface.
+ * surface is not visible when all outputs it is on are covered by a
+ * full screen layer surface.
  *
  * Returns: `FALSE` when it's certain that the unmanaged is not visible, otherwise `TRUE`
  */
@@ -1487,7 +2066,8 @@ phoc_desktop_unmanaged_check_visibility (PhocDesktop *self, PhocXWaylandUnmanage
 #ifdef PHOC_XWAYLAND
   PhocDesktopPrivate *priv;
   PhocOutput *output;
-  GQueue *layer_surfaces;
+  struct wlr_surface *surface;
+  struct wlr_box box;
 
   g_assert (PHOC_IS_DESKTOP (self));
   g_assert (PHOC_IS_XWAYLAND_UNMANAGED (unmanaged));
@@ -1504,18 +2084,26 @@ phoc_desktop_unmanaged_check_visibility (PhocDesktop *self, PhocXWaylandUnmanage
     goto out;
   }
 
-  /* current heuristics work well only for single output */
-  if (wl_list_length (&self->outputs) != 1)
+  surface = phoc_xwayland_unmanaged_get_wlr_surface (unmanaged);
+  if (surface == NULL || wl_list_empty (&self->outputs))
     goto out;
 
-  output = wl_container_of (self->outputs.next, output, link);
-  layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
-  for (GList *l = layer_surfaces->head; l; l = l->next) {
-    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
+  box.width = surface->current.width;
+  box.height = surface->current.height;
+  phoc_xwayland_unmanaged_get_pos (unmanaged, &box.x, &box.y);
 
-    if (phoc_layer_surface_covers_output (layer_surface)) {
-      visible = FALSE;
-      goto out;
+  /* Visible unless all outputs it's on are covered */
+  visible = FALSE;
+  wl_list_for_each (output, &self->outputs, link) {
+    struct wlr_box output_box, intersection;
+
+    wlr_output_layout_get_box (self->layout, output->wlr_output, &output_box);
+    if (!wlr_box_intersection (&intersection, &box, &output_box))
+      continue;
+
+    if (!output_is_covered (output)) {
+      visible = TRUE;
+      break;
     }
   }
 
@@ -1625,6 +2213,7 @@ phoc_desktop_insert_unmanaged (PhocDesktop *self, PhocXWaylandUnmanaged *unmanag
   priv = phoc_desktop_get_instance_private (self);
 
   phoc_workspace_insert_unmanaged (priv->active_workspace, unmanaged);
+  phoc_desktop_invalidate_render_lists (self);
 }
 
 /**
@@ -1649,8 +2238,10 @@ phoc_desktop_remove_unmanaged (PhocDesktop *self, PhocXWaylandUnmanaged *unmanag
   for (guint i = 0; i < n_workspaces; i++) {
     PhocWorkspace *workspace = phoc_workspace_manager_get_by_index (priv->workspace_manager, i);
 
-    if (phoc_workspace_remove_unmanaged (workspace, unmanaged))
+    if (phoc_workspace_remove_unmanaged (workspace, unmanaged)) {
+      phoc_desktop_invalidate_render_lists (self);
       return TRUE;
+    }
   }
 
   return FALSE;
@@ -1838,3 +2429,45 @@ phoc_desktop_get_xx_cutouts_manager (PhocDesktop *self)
 
   return priv->xx_cutouts_manager;
 }
+
+/**
+ * phoc_desktop_invalidate_render_lists:
+ * @self: the desktop
+ *
+ * Invalidate the render lists of all outputs. Use this when a change
+ * can't easily be attributed to a single output, e.g. a surface
+ * changing size or a view moving between workspaces.
+ */
+void
+phoc_desktop_invalidate_render_lists (PhocDesktop *self)
+{
+  PhocOutput *output;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+
+  wl_list_for_each (output, &self->outputs, link)
+    phoc_output_invalidate_render_list (output);
+}
+
+/**
+ * phoc_desktop_invalidate_view_input:
+ * @self: the desktop
+ * @view: the view
+ *
+ * Notify the desktop that the area where @view accepts input might
+ * have changed, e.g. because it moved or one of its surfaces got
+ * resized. The view's entry in the hit testing index is updated on
+ * the next lookup.
+ */
+void
+phoc_desktop_invalidate_view_input (PhocDesktop *self, PhocView *view)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+
+  g_assert (PHOC_IS_DESKTOP (self));
+
+  if (!g_hash_table_contains (priv->tracked_views, view))
+    return;
+
+  g_hash_table_add (priv->dirty_views, view);
+}
@@ -125,6 +125,8 @@ gboolean                phoc_desktop_remove_view                  (PhocDesktop *
 void                    phoc_desktop_for_each_view                (PhocDesktop        *self,
                                                                    PhocDesktopViewIter view_iter,
                                                                    gpointer            user_data);
+void                    phoc_desktop_arrange_views                (PhocDesktop *self,
+                                                                   PhocOutput  *output);
 void                    phoc_desktop_insert_unmanaged             (PhocDesktop *self,
                                                                    PhocXWaylandUnmanaged *unmanaged);
 gboolean                phoc_desktop_remove_unmanaged             (PhocDesktop *self,
@@ -161,6 +163,12 @@ struct wlr_surface *    phoc_desktop_wlr_surface_at               (PhocDesktop *
                                                                   PhocView   **view);
 gboolean                phoc_desktop_view_check_visibility       (PhocDesktop *self,
                                                                   PhocView    *view);
+gboolean                phoc_desktop_view_check_output_visibility (PhocDesktop *self,
+                                                                   PhocView    *view,
+                                                                   PhocOutput  *output);
+void                    phoc_desktop_update_visibility           (PhocDesktop *self);
+void                    phoc_desktop_invalidate_visibility       (PhocDesktop *self);
+GVariant *              phoc_desktop_get_surface_stats           (PhocDesktop *self);
 void                    phoc_desktop_set_view_always_on_top      (PhocDesktop *self,
                                                                   PhocView    *view,
                                                                   gboolean     on_top);
@@ -192,3 +200,6 @@ PhocWorkspaceManager *phoc_desktop_get_workspace_manager         (PhocDesktop *s
 PhocWorkspace *       phoc_desktop_get_active_workspace          (PhocDesktop *self);
 
 PhocXxCutoutsManager *phoc_desktop_get_xx_cutouts_manager        (PhocDesktop *self);
+void                  phoc_desktop_invalidate_render_lists       (PhocDesktop *self);
+void                  phoc_desktop_invalidate_view_input         (PhocDesktop *self,
+                                                                  PhocView    *view);
@@ -59,20 +59,36 @@ G_DEFINE_BOXED_TYPE (PhocEventSequence, phoc_event_sequence,
 PhocEvent *
 phoc_event_new (PhocEventType type, gpointer wlr_event, gsize size)
 {
-  PhocEvent *new_event;
   PhocEventPrivate *priv;
 
-  g_assert (wlr_event == NULL || size >= sizeof (struct wlr_touch_cancel_event));
-
   priv = g_new0 (PhocEventPrivate, 1);
+  phoc_event_init ((PhocEvent *) priv, type, wlr_event, size);
 
-  new_event = (PhocEvent *) priv;
-  new_event->type = type;
+  return (PhocEvent *) priv;
+}
 
-  if (wlr_event)
-    memcpy (&new_event->button_press, wlr_event, size);
+/**
+ * phoc_event_init:
+ * @event: The event to initialize
+ * @type: The type of event.
+ * @wlr_event: (nullable): The wlroots event
+ * @size: The size of @wlr_event
+ *
+ * Initializes an event that wasn't created via [ctor@Event.new], e.g.
+ * one on the stack. Such events must not be freed with
+ * [method@Event.free].
+ */
+void
+phoc_event_init (PhocEvent *event, PhocEventType type, gconstpointer wlr_event, gsize size)
+{
+  g_assert (wlr_event == NULL || size >= sizeof (struct wlr_touch_cancel_event));
+  g_assert (size <= sizeof (*event) - G_STRUCT_OFFSET (PhocEvent, button_press));
 
-  return new_event;
+  memset (event, 0, sizeof (*event));
+  event->type = type;
+
+  if (wlr_event)
+    memcpy (&event->button_press, wlr_event, size);
 }
 
 /**
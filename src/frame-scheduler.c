@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-frame-scheduler"
+
+#include "phoc-config.h"
+
+#include "frame-scheduler.h"
+
+/* Number of render times to base the prediction on */
+#define HISTORY_LEN 16
+/* Delays shorter than that aren't worth a timer */
+#define MIN_DELAY_US 1000
+
+enum {
+  PROP_0,
+  PROP_MARGIN,
+  PROP_LAST_PROP
+};
+static GParamSpec *props[PROP_LAST_PROP];
+
+/**
+ * PhocFrameScheduler:
+ *
+ * Predicts how long compositing an output takes based on a rolling
+ * history of past render times. This allows to delay compositing
+ * towards the end of the refresh cycle so clients committing right
+ * after a frame event still make it into the next frame.
+ *
+ * The `margin` is the safety margin to the next vblank. It needs to
+ * cover what we can't measure like the time the GPU takes to finish
+ * the submitted work. A margin of `0` disables delaying.
+ *
+ * Whenever a frame misses its deadline the history is cleared so we
+ * use the immediate path until enough new render times got recorded.
+ */
+struct _PhocFrameScheduler {
+  GObject parent;
+
+  gint64  margin_us;
+
+  gint64  render_times[HISTORY_LEN];
+  guint   n_render_times;
+  guint   next;
+};
+G_DEFINE_TYPE (PhocFrameScheduler, phoc_frame_scheduler, G_TYPE_OBJECT)
+
+
+static void
+phoc_frame_scheduler_set_property (GObject      *object,
+                                   guint         property_id,
+                                   const GValue *value,
+                                   GParamSpec   *pspec)
+{
+  PhocFrameScheduler *self = PHOC_FRAME_SCHEDULER (object);
+
+  switch (property_id) {
+  case PROP_MARGIN:
+    phoc_frame_scheduler_set_margin (self, g_value_get_int64 (value));
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phoc_frame_scheduler_get_property (GObject    *object,
+                                   guint       property_id,
+                                   GValue     *value,
+                                   GParamSpec *pspec)
+{
+  PhocFrameScheduler *self = PHOC_FRAME_SCHEDULER (object);
+
+  switch (property_id) {
+  case PROP_MARGIN:
+    g_value_set_int64 (value, self->margin_us);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phoc_frame_scheduler_class_init (PhocFrameSchedulerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->get_property = phoc_frame_scheduler_get_property;
+  object_class->set_property = phoc_frame_scheduler_set_property;
+
+  /**
+   * PhocFrameScheduler:margin:
+   *
+   * The safety margin to the next vblank in microseconds. `0` disables
+   * delaying of compositing.
+   */
+  props[PROP_MARGIN] =
+    g_param_spec_int64 ("margin", "", "",
+                        0, G_MAXINT64, 0,
+                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_EXPLICIT_NOTIFY |
+                        G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+}
+
+
+static void
+phoc_frame_scheduler_init (PhocFrameScheduler *self)
+{
+}
+
+
+PhocFrameScheduler *
+phoc_frame_scheduler_new (gint64 margin_us)
+{
+  return g_object_new (PHOC_TYPE_FRAME_SCHEDULER, "margin", margin_us, NULL);
+}
+
+
+gint64
+phoc_frame_scheduler_get_margin (PhocFrameScheduler *self)
+{
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  return self->margin_us;
+}
+
+
+void
+phoc_frame_scheduler_set_margin (PhocFrameScheduler *self, gint64 margin_us)
+{
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  if (self->margin_us == margin_us)
+    return;
+
+  self->margin_us = margin_us;
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_MARGIN]);
+}
+
+/**
+ * phoc_frame_scheduler_add_render_time:
+ * @self: The frame scheduler
+ * @render_time_us: The time it took to composite a frame
+ *
+ * Adds a render time to the history.
+ */
+void
+phoc_frame_scheduler_add_render_time (PhocFrameScheduler *self, gint64 render_time_us)
+{
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  self->render_times[self->next] = render_time_us;
+  self->next = (self->next + 1) % HISTORY_LEN;
+  self->n_render_times = MIN (self->n_render_times + 1, HISTORY_LEN);
+}
+
+/**
+ * phoc_frame_scheduler_predict_render_time:
+ * @self: The frame scheduler
+ *
+ * Predicts the time the next frame will take to composite. As a frame
+ * missing its deadline is worse than a bit of extra latency we use
+ * the worst render time in the history.
+ *
+ * Returns: The predicted render time or `-1` if there's not enough
+ *   data to predict one.
+ */
+gint64
+phoc_frame_scheduler_predict_render_time (PhocFrameScheduler *self)
+{
+  gint64 max = 0;
+
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  if (self->n_render_times < HISTORY_LEN)
+    return -1;
+
+  for (int i = 0; i < HISTORY_LEN; i++)
+    max = MAX (max, self->render_times[i]);
+
+  return max;
+}
+
+/**
+ * phoc_frame_scheduler_get_delay:
+ * @self: The frame scheduler
+ * @refresh_us: The output's refresh period
+ *
+ * Get the time to wait after a frame event before starting to
+ * composite so compositing finishes just before the next vblank.
+ *
+ * Returns: The delay in microseconds, `0` if compositing should
+ *   happen right away
+ */
+gint64
+phoc_frame_scheduler_get_delay (PhocFrameScheduler *self, gint64 refresh_us)
+{
+  gint64 render_time_us, delay_us;
+
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  if (self->margin_us == 0 || refresh_us <= 0)
+    return 0;
+
+  render_time_us = phoc_frame_scheduler_predict_render_time (self);
+  if (render_time_us < 0)
+    return 0;
+
+  delay_us = refresh_us - render_time_us - self->margin_us;
+  if (delay_us < MIN_DELAY_US)
+    return 0;
+
+  return delay_us;
+}
+
+/**
+ * phoc_frame_scheduler_check_missed:
+ * @self: The frame scheduler
+ * @frame_us: When the frame event that started the cycle arrived
+ * @done_us: When compositing finished
+ * @refresh_us: The output's refresh period
+ *
+ * Checks whether a delayed frame missed its deadline. If so the
+ * history is cleared so compositing happens right away until we have
+ * enough data for a new prediction.
+ *
+ * Returns: %TRUE if the frame missed its deadline
+ */
+gboolean
+phoc_frame_scheduler_check_missed (PhocFrameScheduler *self,
+                                   gint64              frame_us,
+                                   gint64              done_us,
+                                   gint64              refresh_us)
+{
+  g_assert (PHOC_IS_FRAME_SCHEDULER (self));
+
+  if (done_us - frame_us <= refresh_us)
+    return FALSE;
+
+  g_debug ("Missed deadline by %" G_GINT64_FORMAT "us, predicted %" G_GINT64_FORMAT "us",
+           done_us - frame_us - refresh_us,
+           phoc_frame_scheduler_predict_render_time (self));
+
+  self->n_render_times = 0;
+  self->next = 0;
+
+  return TRUE;
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_FRAME_SCHEDULER (phoc_frame_scheduler_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocFrameScheduler, phoc_frame_scheduler, PHOC, FRAME_SCHEDULER, GObject)
+
+PhocFrameScheduler *phoc_frame_scheduler_new                    (gint64              margin_us);
+gint64              phoc_frame_scheduler_get_margin             (PhocFrameScheduler *self);
+void                phoc_frame_scheduler_set_margin             (PhocFrameScheduler *self,
+                                                                 gint64              margin_us);
+void                phoc_frame_scheduler_add_render_time        (PhocFrameScheduler *self,
+                                                                 gint64              render_time_us);
+gint64              phoc_frame_scheduler_predict_render_time    (PhocFrameScheduler *self);
+gint64              phoc_frame_scheduler_get_delay              (PhocFrameScheduler *self,
+                                                                 gint64              refresh_us);
+gboolean            phoc_frame_scheduler_check_missed           (PhocFrameScheduler *self,
+                                                                 gint64              frame_us,
+                                                                 gint64              done_us,
+                                                                 gint64              refresh_us);
+
+G_END_DECLS
@@ -19,6 +19,8 @@
 #include "phoc-marshalers.h"
 
 #define CAPTURE_THRESHOLD_MS 150
+/* Enough room for CAPTURE_THRESHOLD_MS worth of events at 240Hz */
+#define BACKLOG_PREALLOC     64
 
 /**
  * PhocGestureSwipe:
@@ -248,7 +250,7 @@ phoc_gesture_swipe_init (PhocGestureSwipe *self)
   PhocGestureSwipePrivate *priv;
 
   priv = phoc_gesture_swipe_get_instance_private (self);
-  priv->events = g_array_new (FALSE, FALSE, sizeof (EventData));
+  priv->events = g_array_sized_new (FALSE, FALSE, sizeof (EventData), BACKLOG_PREALLOC);
 }
 
 
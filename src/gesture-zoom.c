@@ -66,41 +66,39 @@ _phoc_gesture_zoom_get_distance (PhocGestureZoom *zoom,
   const PhocEvent *last_event;
   gdouble x1, y1, x2, y2;
   PhocGesture *gesture;
-  GList *sequences = NULL;
+  PhocEventSequence *sequences[2];
+  guint n_sequences;
   gdouble dx, dy;
-  gboolean retval = FALSE;
 
   gesture = PHOC_GESTURE (zoom);
 
   if (!phoc_gesture_is_recognized (gesture))
-    goto out;
+    return FALSE;
 
-  sequences = phoc_gesture_get_sequences (gesture);
-  if (!sequences)
-    goto out;
+  /* Runs on every update so avoid allocating a list of sequences */
+  n_sequences = phoc_gesture_peek_sequences (gesture, sequences, G_N_ELEMENTS (sequences));
+  if (n_sequences == 0)
+    return FALSE;
 
-  last_event = phoc_gesture_get_last_event (gesture, sequences->data);
+  last_event = phoc_gesture_get_last_event (gesture, sequences[0]);
 
   /* TODO: Handle PHOC_EVENT_TOUCHPAD_PINCH_{BEGIN,END} too
      (we don't have scale in the event struct atm */
   if (last_event->type == PHOC_EVENT_TOUCHPAD_PINCH_UPDATE) {
     *distance = last_event->touchpad_pinch_update.scale;
   } else {
-    if (!sequences->next)
-      goto out;
+    if (n_sequences < 2)
+      return FALSE;
 
-    phoc_gesture_get_point (gesture, sequences->data, &x1, &y1);
-    phoc_gesture_get_point (gesture, sequences->next->data, &x2, &y2);
+    phoc_gesture_get_point (gesture, sequences[0], &x1, &y1);
+    phoc_gesture_get_point (gesture, sequences[1], &x2, &y2);
 
     dx = x1 - x2;
     dy = y1 - y2;;
     *distance = sqrt ((dx * dx) + (dy * dy));
   }
 
-  retval = TRUE;
-out:
-  g_list_free (sequences);
-  return retval;
+  return TRUE;
 }
 
 static gboolean
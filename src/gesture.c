@@ -40,7 +40,8 @@ typedef struct _PointData PointData;
 
 
 struct _PointData {
-  PhocEvent *event;
+  /* Stored inline so updating a point doesn't need an allocation */
+  PhocEvent  event;
 
   double     lx;
   double     ly;
@@ -152,19 +153,19 @@ phoc_gesture_get_n_touchpad_points (PhocGesture *self,
 
   if (only_active &&
       (data->state == PHOC_EVENT_SEQUENCE_DENIED ||
-       data->event->type == PHOC_EVENT_TOUCHPAD_SWIPE_END ||
-       data->event->type == PHOC_EVENT_TOUCHPAD_PINCH_END))
+       data->event.type == PHOC_EVENT_TOUCHPAD_SWIPE_END ||
+       data->event.type == PHOC_EVENT_TOUCHPAD_PINCH_END))
     return 0;
 
-  switch (data->event->type) {
+  switch (data->event.type) {
   case PHOC_EVENT_TOUCHPAD_SWIPE_BEGIN:
-    return data->event->touchpad_swipe_begin.fingers;
+    return data->event.touchpad_swipe_begin.fingers;
   case PHOC_EVENT_TOUCHPAD_SWIPE_UPDATE:
-    return data->event->touchpad_swipe_begin.fingers;
+    return data->event.touchpad_swipe_begin.fingers;
   case PHOC_EVENT_TOUCHPAD_PINCH_BEGIN:
-    return data->event->touchpad_pinch_begin.fingers;
+    return data->event.touchpad_pinch_begin.fingers;
   case PHOC_EVENT_TOUCHPAD_PINCH_UPDATE:
-    return data->event->touchpad_pinch_begin.fingers;
+    return data->event.touchpad_pinch_begin.fingers;
   default:
     return 0;
   }
@@ -209,8 +210,8 @@ phoc_gesture_get_n_touch_points (PhocGesture *self,
   while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &data)) {
     if (only_active &&
         (data->state == PHOC_EVENT_SEQUENCE_DENIED ||
-         data->event->type == PHOC_EVENT_TOUCH_END ||
-         data->event->type == PHOC_EVENT_BUTTON_RELEASE))
+         data->event.type == PHOC_EVENT_TOUCH_END ||
+         data->event.type == PHOC_EVENT_BUTTON_RELEASE))
       continue;
 
     n_points++;
@@ -316,14 +317,11 @@ phoc_gesture_check_recognized (PhocGesture       *self,
 static void
 update_touchpad_deltas (PointData *data)
 {
-  PhocEvent *event = data->event;
+  PhocEvent *event = &data->event;
   PhocTouchpadGesturePhase phase;
   double dx;
   double dy;
 
-  if (!event)
-    return;
-
   if (!phoc_event_is_touchpad_gesture (event))
     return;
 
@@ -391,10 +389,7 @@ phoc_gesture_update_point (PhocGesture     *self,
     g_hash_table_insert (priv->points, sequence, data);
   }
 
-  if (data->event)
-    phoc_event_free (data->event);
-
-  data->event = phoc_event_copy (event);
+  data->event = *event;
   update_touchpad_deltas (data);
   data->lx = lx + data->accum_dx;
   data->ly = ly + data->accum_dy;
@@ -490,7 +485,7 @@ phoc_gesture_cancel_sequence (PhocGesture       *self,
     return FALSE;
 
   g_signal_emit (self, signals[CANCEL], 0, sequence);
-  phoc_gesture_remove_point (self, data->event);
+  phoc_gesture_remove_point (self, &data->event);
   phoc_gesture_check_recognized (self, sequence);
 
   return TRUE;
@@ -714,24 +709,13 @@ phoc_gesture_class_init (PhocGestureClass *klass)
 }
 
 
-static void
-free_point_data (gpointer data)
-{
-  PointData *point = data;
-
-  g_clear_pointer (&point->event, phoc_event_free);
-  g_free (point);
-}
-
-
 static void
 phoc_gesture_init (PhocGesture *self)
 {
   PhocGesturePrivate *priv = phoc_gesture_get_instance_private (self);
 
   priv->n_points = 1;
-  priv->points = g_hash_table_new_full (NULL, NULL, NULL,
-                                        (GDestroyNotify) free_point_data);
+  priv->points = g_hash_table_new_full (NULL, NULL, NULL, g_free);
   priv->group_link = g_list_prepend (NULL, self);
 }
 
@@ -974,8 +958,8 @@ phoc_gesture_get_sequences (PhocGesture *self)
   while (g_hash_table_iter_next (&iter, (gpointer *) &sequence, (gpointer *) &data)) {
     if (data->state == PHOC_EVENT_SEQUENCE_DENIED)
       continue;
-    if (data->event->type == PHOC_EVENT_TOUCH_END ||
-        data->event->type == PHOC_EVENT_BUTTON_RELEASE)
+    if (data->event.type == PHOC_EVENT_TOUCH_END ||
+        data->event.type == PHOC_EVENT_BUTTON_RELEASE)
       continue;
 
     sequences = g_list_prepend (sequences, sequence);
@@ -984,6 +968,49 @@ phoc_gesture_get_sequences (PhocGesture *self)
   return sequences;
 }
 
+/**
+ * phoc_gesture_peek_sequences:
+ * @self: a #PhocGesture
+ * @sequences: (out caller-allocates) (array length=n_sequences): Return
+ *   location for the sequences
+ * @n_sequences: The number of elements @sequences can hold
+ *
+ * Like [method@Gesture.get_sequences] but fills in at most @n_sequences
+ * sequences into a caller provided array so it can be used on every event
+ * without allocating.
+ *
+ * Returns: The number of sequences stored in @sequences
+ **/
+guint
+phoc_gesture_peek_sequences (PhocGesture        *self,
+                             PhocEventSequence **sequences,
+                             guint               n_sequences)
+{
+  PhocEventSequence *sequence;
+  PhocGesturePrivate *priv;
+  GHashTableIter iter;
+  PointData *data;
+  guint n = 0;
+
+  g_return_val_if_fail (PHOC_IS_GESTURE (self), 0);
+
+  priv = phoc_gesture_get_instance_private (self);
+  g_hash_table_iter_init (&iter, priv->points);
+
+  while (n < n_sequences &&
+         g_hash_table_iter_next (&iter, (gpointer *) &sequence, (gpointer *) &data)) {
+    if (data->state == PHOC_EVENT_SEQUENCE_DENIED)
+      continue;
+    if (data->event.type == PHOC_EVENT_TOUCH_END ||
+        data->event.type == PHOC_EVENT_BUTTON_RELEASE)
+      continue;
+
+    sequences[n++] = sequence;
+  }
+
+  return n;
+}
+
 /**
  * phoc_gesture_get_last_updated_sequence:
  * @self: a #PhocGesture
@@ -1031,7 +1058,7 @@ phoc_gesture_get_last_event (PhocGesture *self, PhocEventSequence *sequence)
   if (!data)
     return NULL;
 
-  return data->event;
+  return &data->event;
 }
 
 
@@ -1092,7 +1119,7 @@ phoc_gesture_get_last_update_time (PhocGesture       *self,
     return FALSE;
 
   if (evtime)
-    *evtime = phoc_event_get_time (data->event);
+    *evtime = phoc_event_get_time (&data->event);
 
   return TRUE;
 }
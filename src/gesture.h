@@ -62,6 +62,9 @@ gboolean         phoc_gesture_set_sequence_state     (PhocGesture            *se
 gboolean         phoc_gesture_set_state              (PhocGesture            *self,
                                                       PhocEventSequenceState  state);
 GList *          phoc_gesture_get_sequences          (PhocGesture            *self);
+guint            phoc_gesture_peek_sequences         (PhocGesture            *self,
+                                                      PhocEventSequence     **sequences,
+                                                      guint                   n_sequences);
 gboolean         phoc_gesture_is_recognized          (PhocGesture            *self);
 void             phoc_gesture_group                  (PhocGesture            *group_gesture,
                                                       PhocGesture            *gesture);
@@ -28,6 +28,7 @@ enum {
   PROP_0,
   PROP_SEAT,
   PROP_DEVICE,
+  PROP_COALESCE_MOTION,
   PROP_LAST_PROP
 };
 static GParamSpec *props[PROP_LAST_PROP];
@@ -53,29 +54,34 @@ typedef struct _PhocInputDevicePrivate {
   struct wl_listener       device_destroy;
 
   int                      is_keyboard;
+  gboolean                 coalesce_motion;
 } PhocInputDevicePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhocInputDevice, phoc_input_device, G_TYPE_OBJECT)
 
 
-static gboolean
-phoc_input_device_has_udev_property (PhocInputDevice *self, const char *prop_name)
+static char *
+phoc_input_device_get_udev_property (PhocInputDevice *self, const char *prop_name)
 {
   struct libinput_device *dev_handle;
   g_autoptr (udev_device) udev_dev = NULL;
-  const char *value;
 
   dev_handle = phoc_input_device_get_libinput_device_handle (self);
   udev_dev = libinput_device_get_udev_device (dev_handle);
 
   if (!udev_dev)
-    return FALSE;
+    return NULL;
+
+  return g_strdup (udev_device_get_property_value (udev_dev, prop_name));
+}
 
-  value = udev_device_get_property_value (udev_dev, prop_name);
-  if (g_strcmp0 (value, "1") == 0)
-    return TRUE;
 
-  return FALSE;
+static gboolean
+phoc_input_device_has_udev_property (PhocInputDevice *self, const char *prop_name)
+{
+  g_autofree char *value = phoc_input_device_get_udev_property (self, prop_name);
+
+  return g_strcmp0 (value, "1") == 0;
 }
 
 
@@ -98,6 +104,9 @@ phoc_input_device_set_property (GObject      *object,
     priv->seat = g_value_dup_object (value);
     g_object_notify_by_pspec (G_OBJECT (self), props[PROP_SEAT]);
     break;
+  case PROP_COALESCE_MOTION:
+    phoc_input_device_set_coalesce_motion (self, g_value_get_boolean (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -121,6 +130,9 @@ phoc_input_device_get_property (GObject    *object,
   case PROP_SEAT:
     g_value_set_pointer (value, priv->seat);
     break;
+  case PROP_COALESCE_MOTION:
+    g_value_set_boolean (value, priv->coalesce_motion);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -172,11 +184,20 @@ phoc_input_device_constructed (GObject *object)
   wl_signal_add (&priv->device->events.destroy, &priv->device_destroy);
 
   if (wlr_input_device_is_libinput (priv->device)) {
+    g_autofree char *coalesce = NULL;
     struct libinput_device *ldev;
 
     ldev = phoc_input_device_get_libinput_device_handle (self);
     priv->vendor = g_strdup_printf ("%.4x", libinput_device_get_id_vendor (ldev));
     priv->product = g_strdup_printf ("%.4x", libinput_device_get_id_product (ldev));
+
+    /* libinput sends a frame after almost every motion event so
+     * coalescing only pays off for devices known to batch events */
+    coalesce = phoc_input_device_get_udev_property (self, "PHOC_INPUT_COALESCE_MOTION");
+    if (g_strcmp0 (coalesce, "1") == 0) {
+      g_debug ("Coalescing motion events of %s", libinput_device_get_name (ldev));
+      priv->coalesce_motion = TRUE;
+    }
   }
 }
 
@@ -209,6 +230,19 @@ phoc_input_device_class_init (PhocInputDeviceClass *klass)
     g_param_spec_object ("seat", "", "",
                          PHOC_TYPE_SEAT,
                          G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * PhocInputDevice:coalesce-motion:
+   *
+   * Whether motion events of this device are merged into a single
+   * event per input frame before being sent to clients. Gestures
+   * and relative pointer clients always see every event. Off by
+   * default, libinput devices can enable it via udev.
+   */
+  props[PROP_COALESCE_MOTION] =
+    g_param_spec_boolean ("coalesce-motion", "", "",
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
 
   /**
@@ -447,3 +481,44 @@ phoc_input_device_get_product_id (PhocInputDevice *self)
 
   return priv->product;
 }
+
+/**
+ * phoc_input_device_get_coalesce_motion:
+ * @self: The %PhocInputDevice
+ *
+ * Returns: %TRUE if motion events of this device are coalesced per input frame
+ */
+gboolean
+phoc_input_device_get_coalesce_motion (PhocInputDevice *self)
+{
+  PhocInputDevicePrivate *priv;
+
+  g_assert (PHOC_IS_INPUT_DEVICE (self));
+  priv = phoc_input_device_get_instance_private (self);
+
+  return priv->coalesce_motion;
+}
+
+/**
+ * phoc_input_device_set_coalesce_motion:
+ * @self: The %PhocInputDevice
+ * @coalesce: Whether to coalesce motion events
+ *
+ * Sets whether motion events of this device are merged into a single
+ * event per input frame before being delivered to clients.
+ */
+void
+phoc_input_device_set_coalesce_motion (PhocInputDevice *self, gboolean coalesce)
+{
+  PhocInputDevicePrivate *priv;
+
+  g_assert (PHOC_IS_INPUT_DEVICE (self));
+  priv = phoc_input_device_get_instance_private (self);
+
+  coalesce = !!coalesce;
+  if (priv->coalesce_motion == coalesce)
+    return;
+
+  priv->coalesce_motion = coalesce;
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_COALESCE_MOTION]);
+}
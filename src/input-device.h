@@ -40,5 +40,8 @@ const char              *phoc_input_device_get_name                       (PhocI
 enum wlr_input_device_type phoc_input_device_get_device_type              (PhocInputDevice *self);
 const char              *phoc_input_device_get_vendor_id                  (PhocInputDevice *self);
 const char              *phoc_input_device_get_product_id                 (PhocInputDevice *self);
+gboolean                 phoc_input_device_get_coalesce_motion            (PhocInputDevice *self);
+void                     phoc_input_device_set_coalesce_motion            (PhocInputDevice *self,
+                                                                           gboolean         coalesce);
 
 G_END_DECLS
@@ -49,11 +49,12 @@ typedef struct {
 
 
 typedef struct _PhocKeybindings {
-  GObject    parent;
+  GObject     parent;
 
-  GSList    *bindings;
-  GSettings *settings;
-  GSettings *mutter_settings;
+  GSList     *bindings;
+  GHashTable *index;   /* PhocKeyCombo → PhocKeybinding */
+  GSettings  *settings;
+  GSettings  *mutter_settings;
 
   PhocKeybindingsContext *context;
 } PhocKeybindings;
@@ -607,10 +608,10 @@ phoc_keybinding_free (PhocKeybinding *keybinding)
 }
 
 
-static gboolean
-key_combo_eq (const PhocKeyCombo *sym1, const PhocKeyCombo *sym2)
+static int
+key_combo_cmp (const PhocKeyCombo *combo1, const PhocKeyCombo *combo2)
 {
-  return (sym1->modifiers == sym2->modifiers && sym1->keysym == sym2->keysym);
+  return !phoc_key_combo_equal (combo1, combo2);
 }
 
 
@@ -624,12 +625,30 @@ keybinding_by_name (const PhocKeybinding *keybinding, const char *name)
 static gboolean
 keybinding_by_key_combo (const PhocKeybinding *keybinding, const PhocKeyCombo *combo)
 {
-  for (GSList *elem = keybinding->combos; elem; elem = elem->next) {
-    if (key_combo_eq (elem->data, combo))
-      return FALSE;
+  return g_slist_find_custom (keybinding->combos, combo, (GCompareFunc)key_combo_cmp) == NULL;
+}
+
+/*
+ * Point the index entry for @combo at the first binding using it
+ * (or drop it). The index keys are owned by the bindings so this must
+ * be invoked for every combo a binding drops before freeing it.
+ */
+static void
+reindex_combo (PhocKeybindings *self, const PhocKeyCombo *combo)
+{
+  PhocKeybinding *keybinding;
+  GSList *elem;
+
+  elem = g_slist_find_custom (self->bindings, combo, (GCompareFunc)keybinding_by_key_combo);
+  if (elem == NULL) {
+    g_hash_table_remove (self->index, combo);
+    return;
   }
 
-  return TRUE;
+  keybinding = elem->data;
+  elem = g_slist_find_custom (keybinding->combos, combo, (GCompareFunc)key_combo_cmp);
+  g_assert (elem);
+  g_hash_table_replace (self->index, elem->data, keybinding);
 }
 
 
@@ -639,7 +658,7 @@ phoc_keybindings_update_accelerators (PhocKeybindings    *self,
                                       const char * const *accelerators)
 {
   PhocKeybinding *keybinding;
-  GSList *elem;
+  GSList *elem, *old_combos;
 
   elem = g_slist_find_custom (self->bindings,
                               name,
@@ -651,7 +670,7 @@ phoc_keybindings_update_accelerators (PhocKeybindings    *self,
 
   keybinding = elem->data;
 
-  g_slist_free_full (keybinding->combos, g_free);
+  old_combos = keybinding->combos;
   keybinding->combos = NULL;
 
   for (int i = 0; accelerators && accelerators[i]; i++) {
@@ -662,6 +681,14 @@ phoc_keybindings_update_accelerators (PhocKeybindings    *self,
     if (combo)
       keybinding->combos = g_slist_append (keybinding->combos, combo);
   }
+
+  /* Only touch the index entries of the combos that changed hands */
+  for (elem = old_combos; elem; elem = elem->next)
+    reindex_combo (self, elem->data);
+  for (elem = keybinding->combos; elem; elem = elem->next)
+    reindex_combo (self, elem->data);
+
+  g_slist_free_full (old_combos, g_free);
 }
 
 
@@ -713,6 +740,7 @@ phoc_keybindings_dispose (GObject *object)
 {
   PhocKeybindings *self = PHOC_KEYBINDINGS (object);
 
+  g_hash_table_remove_all (self->index);
   g_slist_free_full (self->bindings, (GDestroyNotify)phoc_keybinding_free);
   self->bindings = NULL;
 
@@ -726,6 +754,7 @@ phoc_keybindings_finalize (GObject *object)
   PhocKeybindings *self = PHOC_KEYBINDINGS (object);
 
   g_clear_pointer (&self->context, phoc_keybindings_context_free);
+  g_hash_table_destroy (self->index);
   g_clear_object (&self->settings);
   g_clear_object (&self->mutter_settings);
 
@@ -736,6 +765,9 @@ phoc_keybindings_finalize (GObject *object)
 void
 phoc_keybindings_load_settings (PhocKeybindings *self)
 {
+  g_signal_handlers_disconnect_by_data (self->settings, self);
+  g_signal_handlers_disconnect_by_data (self->mutter_settings, self);
+  g_hash_table_remove_all (self->index);
   g_slist_free_full (self->bindings, (GDestroyNotify)phoc_keybinding_free);
   self->bindings = NULL;
 
@@ -854,6 +886,7 @@ static void
 phoc_keybindings_init (PhocKeybindings *self)
 {
   self->bindings = NULL;
+  self->index = g_hash_table_new (phoc_key_combo_hash, phoc_key_combo_equal);
   self->settings = g_settings_new (KEYBINDINGS_SCHEMA_ID);
   self->mutter_settings = g_settings_new (MUTTER_KEYBINDINGS_SCHEMA_ID);
 }
@@ -885,7 +918,6 @@ phoc_keybindings_handle_pressed (PhocKeybindings *self,
                                  PhocSeat        *seat)
 {
   PhocKeybinding *keybinding;
-  GSList *elem;
   PhocKeyCombo combo;
 
   if (length != 1)
@@ -894,19 +926,35 @@ phoc_keybindings_handle_pressed (PhocKeybindings *self,
   combo.keysym = pressed_keysyms[0];
   combo.modifiers = modifiers;
 
-  elem = g_slist_find_custom (self->bindings,
-                              &combo,
-                              (GCompareFunc)keybinding_by_key_combo);
-  if (!elem)
+  keybinding = g_hash_table_lookup (self->index, &combo);
+  if (!keybinding)
     return FALSE;
 
-  g_return_val_if_fail (elem->data, FALSE);
-  keybinding = elem->data;
-
   (*keybinding->func) (seat, keybinding->param);
   return TRUE;
 }
 
+/**
+ * phoc_keybindings_lookup:
+ * @self: The keybindings
+ * @combo: The key combination to look up
+ *
+ * Look up the name of the keybinding triggered by @combo.
+ *
+ * Returns: (nullable): The keybinding's name
+ */
+const char *
+phoc_keybindings_lookup (PhocKeybindings *self, const PhocKeyCombo *combo)
+{
+  PhocKeybinding *keybinding;
+
+  g_assert (PHOC_IS_KEYBINDINGS (self));
+
+  keybinding = g_hash_table_lookup (self->index, combo);
+
+  return keybinding ? keybinding->name : NULL;
+}
+
 
 void
 phoc_keybindings_set_context (PhocKeybindings *self, PhocKeybindingsContext *context)
@@ -947,3 +995,23 @@ phoc_keybindings_context_copy (PhocKeybindingsContext *context)
 
   return g_steal_pointer (&copy);
 }
+
+
+guint
+phoc_key_combo_hash (gconstpointer key)
+{
+  const PhocKeyCombo *combo = key;
+
+  return combo->keysym ^ (combo->modifiers << 24) ^ (combo->modifiers >> 8);
+}
+
+
+gboolean
+phoc_key_combo_equal (gconstpointer a, gconstpointer b)
+{
+  const PhocKeyCombo *combo1 = a;
+  const PhocKeyCombo *combo2 = b;
+
+  return combo1->modifiers == combo2->modifiers && combo1->keysym == combo2->keysym;
+}
+
@@ -31,6 +31,9 @@ typedef struct {
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhocKeyCombo, g_free)
 
+guint    phoc_key_combo_hash  (gconstpointer key);
+gboolean phoc_key_combo_equal (gconstpointer a, gconstpointer b);
+
 /**
  * PhocKeybindingsContext:
  *
@@ -61,5 +64,7 @@ void                    phoc_keybindings_set_context (PhocKeybindings        *se
 PhocKeyCombo *          phoc_keybindings_parse_accelerator (const char             *accelerator,
                                                             PhocKeybindingsContext *context);
 void                    phoc_keybindings_load_settings (PhocKeybindings *self);
+const char *            phoc_keybindings_lookup (PhocKeybindings    *self,
+                                                 const PhocKeyCombo *combo);
 
 G_END_DECLS
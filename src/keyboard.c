@@ -22,6 +22,7 @@
 #include <wlr/types/wlr_pointer.h>
 #include <xkbcommon/xkbcommon.h>
 #include "keyboard.h"
+#include "keymap-cache.h"
 #include "phosh-private.h"
 #include "seat.h"
 
@@ -70,6 +71,7 @@ struct _PhocKeyboard {
   GSettings         *input_settings;
   GSettings         *keyboard_settings;
   struct xkb_keymap *keymap;
+  GCancellable      *keymap_cancel;
   GnomeXkbInfo      *xkbinfo;
   PhocKeybindings   *keybindings;
 
@@ -473,63 +475,22 @@ phoc_keyboard_handle_modifiers (PhocKeyboard *self)
 
 
 static void
-set_fallback_keymap (PhocKeyboard *self)
+set_keymap (PhocKeyboard *self, struct xkb_keymap *keymap)
 {
-  struct xkb_context *context;
-  PhocInputDevice *input_device = PHOC_INPUT_DEVICE (self);
-  struct wlr_input_device *device = phoc_input_device_get_device (input_device);
-  struct wlr_keyboard *wlr_keyboard = wlr_keyboard_from_input_device (device);
-
-  context = xkb_context_new (XKB_CONTEXT_NO_FLAGS);
-  if (context == NULL)
-    return;
-
-  xkb_keymap_unref (self->keymap);
-  self->keymap = xkb_keymap_new_from_names (context, NULL,
-                                            XKB_KEYMAP_COMPILE_NO_FLAGS);
-  xkb_context_unref (context);
-
-  wlr_keyboard_set_keymap (wlr_keyboard, self->keymap);
-}
-
-
-static void
-set_xkb_keymap (PhocKeyboard *self, const char *layout, const char *variant, const char *options)
-{
-  struct xkb_rule_names rules = { 0 };
-  struct xkb_context *context = NULL;
-  struct xkb_keymap *keymap = NULL;
   PhocInputDevice *input_device = PHOC_INPUT_DEVICE (self);
   struct wlr_input_device *device = phoc_input_device_get_device (input_device);
   struct wlr_keyboard *wlr_keyboard = wlr_keyboard_from_input_device (device);
 
   g_assert (wlr_keyboard);
 
-  rules.layout = layout;
-  rules.variant = variant;
-  rules.options = options;
-
-  context = xkb_context_new (XKB_CONTEXT_NO_FLAGS);
-  if (context == NULL) {
-    g_warning ("Cannot create XKB context");
-    goto out;
-  }
+  if (keymap == NULL && self->keymap == NULL)
+    keymap = phoc_keymap_cache_lookup (phoc_keymap_cache_get_default (), NULL);
 
-  keymap = xkb_map_new_from_names (context, &rules, XKB_KEYMAP_COMPILE_NO_FLAGS);
   if (keymap == NULL)
-    g_warning ("Cannot create XKB keymap");
-
- out:
-  if (context)
-    xkb_context_unref (context);
-
-  if (keymap) {
-    xkb_keymap_unref (self->keymap);
-    self->keymap = keymap;
-  } else if (self->keymap == NULL) {
-    set_fallback_keymap (self);
     return;
-  }
+
+  xkb_keymap_unref (self->keymap);
+  self->keymap = keymap;
 
   wlr_keyboard_set_keymap (wlr_keyboard, self->keymap);
 }
@@ -560,11 +521,41 @@ get_above_tab_keysym (PhocKeyboard *keyboard)
 
 
 static void
-on_input_setting_changed (PhocKeyboard *self,
-                          const char   *key,
-                          GSettings    *settings)
+update_keybindings_context (PhocKeyboard *self)
 {
   g_autoptr (PhocKeybindingsContext) context = phoc_keybindings_context_new ();
+
+  context->above_tab_keysym = get_above_tab_keysym (self);
+  phoc_keybindings_set_context (self->keybindings, context);
+  phoc_keybindings_load_settings (self->keybindings);
+}
+
+
+static void
+on_keymap_ready (GObject *object, GAsyncResult *res, gpointer data)
+{
+  PhocKeymapCache *keymap_cache = PHOC_KEYMAP_CACHE (object);
+  g_autoptr (GError) err = NULL;
+  struct xkb_keymap *keymap;
+  PhocKeyboard *self;
+
+  keymap = phoc_keymap_cache_lookup_finish (keymap_cache, res, &err);
+  if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = PHOC_KEYBOARD (data);
+  if (keymap == NULL)
+    g_warning ("Failed to switch keymap: %s", err->message);
+
+  set_keymap (self, keymap);
+  update_keybindings_context (self);
+}
+
+
+static void
+load_input_settings (PhocKeyboard *self, gboolean sync)
+{
+  PhocKeymapCache *keymap_cache = phoc_keymap_cache_get_default ();
   g_auto (GStrv) xkb_options = NULL;
   g_autoptr (GVariant) sources = NULL;
   GVariantIter iter;
@@ -573,12 +564,10 @@ on_input_setting_changed (PhocKeyboard *self,
   g_autofree char *xkb_options_string = NULL;
   const char *layout = NULL;
   const char *variant = NULL;
+  struct xkb_rule_names names = { 0 };
   PhocInputDevice *input_device;
   struct wlr_input_device *device;
 
-  g_return_if_fail (PHOC_IS_KEYBOARD (self));
-  g_return_if_fail (G_IS_SETTINGS (settings));
-
   input_device = PHOC_INPUT_DEVICE (self);
   device = phoc_input_device_get_device (input_device);
 
@@ -589,7 +578,7 @@ on_input_setting_changed (PhocKeyboard *self,
     return;
   }
 
-  sources = g_settings_get_value (settings, "sources");
+  sources = g_settings_get_value (self->input_settings, "sources");
 
   g_variant_iter_init (&iter, sources);
   g_variant_iter_next (&iter, "(&s&s)", &type, &id);
@@ -603,7 +592,7 @@ on_input_setting_changed (PhocKeyboard *self,
     id = "us";
   }
 
-  xkb_options = g_settings_get_strv (settings, "xkb-options");
+  xkb_options = g_settings_get_strv (self->input_settings, "xkb-options");
   if (xkb_options) {
     xkb_options_string = g_strjoinv (",", xkb_options);
     g_debug ("Setting options %s", xkb_options_string);
@@ -616,11 +605,39 @@ on_input_setting_changed (PhocKeyboard *self,
   }
   g_debug ("Switching to layout %s %s", layout, variant);
 
-  set_xkb_keymap (self, layout, variant, xkb_options_string);
+  names.layout = layout;
+  names.variant = variant;
+  names.options = xkb_options_string;
 
-  context->above_tab_keysym = get_above_tab_keysym (self);
-  phoc_keybindings_set_context (self->keybindings, context);
-  phoc_keybindings_load_settings (self->keybindings);
+  /* A newer switch supersedes any pending one */
+  g_cancellable_cancel (self->keymap_cancel);
+  g_clear_object (&self->keymap_cancel);
+
+  if (sync) {
+    set_keymap (self, phoc_keymap_cache_lookup (keymap_cache, &names));
+    update_keybindings_context (self);
+    return;
+  }
+
+  /* Keep the current keymap until the new one is compiled */
+  self->keymap_cancel = g_cancellable_new ();
+  phoc_keymap_cache_lookup_async (keymap_cache,
+                                  &names,
+                                  self->keymap_cancel,
+                                  on_keymap_ready,
+                                  self);
+}
+
+
+static void
+on_input_setting_changed (PhocKeyboard *self,
+                          const char   *key,
+                          GSettings    *settings)
+{
+  g_return_if_fail (PHOC_IS_KEYBOARD (self));
+  g_return_if_fail (G_IS_SETTINGS (settings));
+
+  load_input_settings (self, FALSE);
 }
 
 
@@ -691,6 +708,8 @@ phoc_keyboard_dispose (GObject *object)
 {
   PhocKeyboard *self = PHOC_KEYBOARD (object);
 
+  g_cancellable_cancel (self->keymap_cancel);
+  g_clear_object (&self->keymap_cancel);
   g_clear_object (&self->input_settings);
   g_clear_object (&self->keyboard_settings);
   g_clear_object (&self->xkbinfo);
@@ -826,14 +845,15 @@ phoc_keyboard_constructed (GObject *object)
   self->keyboard_settings = g_settings_new ("org.gnome.desktop.peripherals.keyboard");
   self->meta_key = WLR_MODIFIER_LOGO;
 
-  set_fallback_keymap (self);
   self->xkbinfo = gnome_xkb_info_new ();
 
   g_object_connect (self->input_settings,
                     "swapped-signal::changed::sources", on_input_setting_changed, self,
                     "swapped-signal::changed::xkb-options", on_input_setting_changed, self,
                     NULL);
-  on_input_setting_changed (self, NULL, self->input_settings);
+  load_input_settings (self, TRUE);
+  /* Virtual keyboards and unknown layouts keep the default keymap */
+  set_keymap (self, NULL);
 
   g_object_connect (self->keyboard_settings,
                     "swapped-signal::changed::repeat", on_keyboard_setting_changed, self,
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-keymap-cache"
+
+#include "phoc-config.h"
+
+#include "keymap-cache.h"
+#include "phoc-priorities.h"
+
+/* Dropping keymaps is cheap as keyboards hold their own reference */
+#define PHOC_KEYMAP_CACHE_MAX_KEYMAPS 16
+
+/**
+ * PhocKeymapCache:
+ *
+ * A process wide cache of compiled XKB keymaps keyed by their rule
+ * names. Keyboards using the same layout share a single keymap and
+ * switching back to a previously used layout doesn't need to compile
+ * the keymap again. Compiling can happen in a thread so layout switches
+ * don't block the main loop.
+ */
+struct _PhocKeymapCache {
+  GObject             parent;
+
+  struct xkb_context *context;  /* Only used from the main thread */
+  GHashTable         *keymaps;  /* key → struct xkb_keymap */
+  GHashTable         *pending;  /* key → GPtrArray of waiting GTasks */
+};
+G_DEFINE_TYPE (PhocKeymapCache, phoc_keymap_cache, G_TYPE_OBJECT)
+
+
+typedef struct {
+  char *key;
+  char *rules;
+  char *model;
+  char *layout;
+  char *variant;
+  char *options;
+} PhocKeymapNames;
+
+
+static PhocKeymapNames *
+phoc_keymap_names_new (const struct xkb_rule_names *names, const char *key)
+{
+  PhocKeymapNames *copy = g_new0 (PhocKeymapNames, 1);
+
+  copy->key = g_strdup (key);
+  if (names) {
+    copy->rules = g_strdup (names->rules);
+    copy->model = g_strdup (names->model);
+    copy->layout = g_strdup (names->layout);
+    copy->variant = g_strdup (names->variant);
+    copy->options = g_strdup (names->options);
+  }
+
+  return copy;
+}
+
+
+static void
+phoc_keymap_names_free (PhocKeymapNames *names)
+{
+  g_free (names->key);
+  g_free (names->rules);
+  g_free (names->model);
+  g_free (names->layout);
+  g_free (names->variant);
+  g_free (names->options);
+  g_free (names);
+}
+
+
+static char *
+get_key (const struct xkb_rule_names *names)
+{
+  if (names == NULL)
+    return g_strdup ("\n\n\n\n");
+
+  return g_strdup_printf ("%s\n%s\n%s\n%s\n%s",
+                          names->rules ?: "",
+                          names->model ?: "",
+                          names->layout ?: "",
+                          names->variant ?: "",
+                          names->options ?: "");
+}
+
+
+static struct xkb_keymap *
+compile_keymap (struct xkb_context *context, const PhocKeymapNames *names)
+{
+  struct xkb_rule_names rules = {
+    .rules = names->rules,
+    .model = names->model,
+    .layout = names->layout,
+    .variant = names->variant,
+    .options = names->options,
+  };
+
+  return xkb_keymap_new_from_names (context, &rules, XKB_KEYMAP_COMPILE_NO_FLAGS);
+}
+
+
+static struct xkb_keymap *
+store_keymap (PhocKeymapCache *self, const char *key, struct xkb_keymap *keymap)
+{
+  struct xkb_keymap *cached;
+
+  /* Prefer an already cached keymap so all users share the same one */
+  cached = g_hash_table_lookup (self->keymaps, key);
+  if (cached) {
+    xkb_keymap_unref (keymap);
+    return xkb_keymap_ref (cached);
+  }
+
+  if (g_hash_table_size (self->keymaps) >= PHOC_KEYMAP_CACHE_MAX_KEYMAPS) {
+    g_debug ("Keymap cache full, dropping cached keymaps");
+    g_hash_table_remove_all (self->keymaps);
+  }
+
+  g_hash_table_insert (self->keymaps, g_strdup (key), xkb_keymap_ref (keymap));
+  return keymap;
+}
+
+
+static void
+compile_keymap_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  PhocKeymapNames *names = task_data;
+  struct xkb_context *context;
+  struct xkb_keymap *keymap;
+
+  /* XKB contexts aren't thread safe so use a private one */
+  context = xkb_context_new (XKB_CONTEXT_NO_FLAGS);
+  if (context == NULL) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Cannot create XKB context");
+    return;
+  }
+
+  keymap = compile_keymap (context, names);
+  xkb_context_unref (context);
+
+  if (keymap == NULL) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Cannot create XKB keymap");
+    return;
+  }
+
+  g_task_return_pointer (task, keymap, (GDestroyNotify) xkb_keymap_unref);
+}
+
+
+static void
+on_compile_keymap_ready (GObject *object, GAsyncResult *res, gpointer data)
+{
+  PhocKeymapCache *self = PHOC_KEYMAP_CACHE (object);
+  PhocKeymapNames *names = g_task_get_task_data (G_TASK (res));
+  g_autoptr (GPtrArray) waiters = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autofree char *key = NULL;
+  struct xkb_keymap *keymap;
+
+  keymap = g_task_propagate_pointer (G_TASK (res), &err);
+  if (keymap)
+    keymap = store_keymap (self, names->key, keymap);
+  else
+    g_warning ("Failed to compile keymap: %s", err->message);
+
+  g_hash_table_steal_extended (self->pending, names->key, (gpointer *)&key, (gpointer *)&waiters);
+  g_assert (waiters);
+
+  for (guint i = 0; i < waiters->len; i++) {
+    GTask *task = g_ptr_array_index (waiters, i);
+
+    if (keymap)
+      g_task_return_pointer (task, xkb_keymap_ref (keymap), (GDestroyNotify) xkb_keymap_unref);
+    else
+      g_task_return_error (task, g_error_copy (err));
+  }
+
+  g_clear_pointer (&keymap, xkb_keymap_unref);
+}
+
+
+static void
+phoc_keymap_cache_finalize (GObject *object)
+{
+  PhocKeymapCache *self = PHOC_KEYMAP_CACHE (object);
+
+  g_assert (g_hash_table_size (self->pending) == 0);
+
+  g_hash_table_destroy (self->pending);
+  g_hash_table_destroy (self->keymaps);
+  g_clear_pointer (&self->context, xkb_context_unref);
+
+  G_OBJECT_CLASS (phoc_keymap_cache_parent_class)->finalize (object);
+}
+
+
+static void
+phoc_keymap_cache_class_init (PhocKeymapCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phoc_keymap_cache_finalize;
+}
+
+
+static void
+phoc_keymap_cache_init (PhocKeymapCache *self)
+{
+  self->context = xkb_context_new (XKB_CONTEXT_NO_FLAGS);
+  self->keymaps = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify) xkb_keymap_unref);
+  self->pending = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify) g_ptr_array_unref);
+}
+
+/**
+ * phoc_keymap_cache_get_default:
+ *
+ * Get the keymap cache singleton.
+ *
+ * Returns: (transfer none): The keymap cache singleton
+ */
+PhocKeymapCache *
+phoc_keymap_cache_get_default (void)
+{
+  static PhocKeymapCache *instance;
+
+  if (G_UNLIKELY (instance == NULL)) {
+    g_debug ("Creating keymap cache");
+    instance = g_object_new (PHOC_TYPE_KEYMAP_CACHE, NULL);
+
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+
+  return instance;
+}
+
+/**
+ * phoc_keymap_cache_lookup:
+ * @self: The keymap cache
+ * @names: (nullable): The rule names of the keymap
+ *
+ * Look up the keymap for the given rule names compiling it if it's not
+ * cached yet. `NULL` fields and `NULL` @names use the XKB defaults.
+ *
+ * Returns: (transfer full) (nullable): The keymap or `NULL` if it
+ *   couldn't be compiled
+ */
+struct xkb_keymap *
+phoc_keymap_cache_lookup (PhocKeymapCache *self, const struct xkb_rule_names *names)
+{
+  g_autofree char *key = get_key (names);
+  struct xkb_keymap *keymap;
+  PhocKeymapNames *copy;
+
+  g_assert (PHOC_IS_KEYMAP_CACHE (self));
+
+  keymap = g_hash_table_lookup (self->keymaps, key);
+  if (keymap)
+    return xkb_keymap_ref (keymap);
+
+  if (self->context == NULL) {
+    g_warning ("Cannot create XKB context");
+    return NULL;
+  }
+
+  copy = phoc_keymap_names_new (names, key);
+  keymap = compile_keymap (self->context, copy);
+  phoc_keymap_names_free (copy);
+
+  if (keymap == NULL) {
+    g_warning ("Cannot create XKB keymap");
+    return NULL;
+  }
+
+  return store_keymap (self, key, keymap);
+}
+
+/**
+ * phoc_keymap_cache_lookup_async:
+ * @self: The keymap cache
+ * @names: (nullable): The rule names of the keymap
+ * @cancellable: (nullable): A cancellable
+ * @callback: The callback to invoke once the keymap is available
+ * @user_data: The user data for the callback
+ *
+ * Like [method@KeymapCache.lookup] but compiles the keymap in a thread
+ * if it's not cached yet. Concurrent lookups of the same rule names
+ * share a single compile.
+ */
+void
+phoc_keymap_cache_lookup_async (PhocKeymapCache             *self,
+                                const struct xkb_rule_names *names,
+                                GCancellable                *cancellable,
+                                GAsyncReadyCallback          callback,
+                                gpointer                     user_data)
+{
+  g_autoptr (GTask) task = g_task_new (self, cancellable, callback, user_data);
+  g_autoptr (GTask) compile_task = NULL;
+  g_autofree char *key = get_key (names);
+  struct xkb_keymap *keymap;
+  GPtrArray *waiters;
+
+  g_assert (PHOC_IS_KEYMAP_CACHE (self));
+
+  g_task_set_source_tag (task, phoc_keymap_cache_lookup_async);
+
+  keymap = g_hash_table_lookup (self->keymaps, key);
+  if (keymap) {
+    g_task_return_pointer (task, xkb_keymap_ref (keymap), (GDestroyNotify) xkb_keymap_unref);
+    return;
+  }
+
+  waiters = g_hash_table_lookup (self->pending, key);
+  if (waiters) {
+    g_ptr_array_add (waiters, g_steal_pointer (&task));
+    return;
+  }
+
+  waiters = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (waiters, g_steal_pointer (&task));
+  g_hash_table_insert (self->pending, g_strdup (key), waiters);
+
+  /* Not cancellable as other lookups might wait for the result */
+  compile_task = g_task_new (self, NULL, on_compile_keymap_ready, NULL);
+  g_task_set_source_tag (compile_task, compile_keymap_thread);
+  /* Keep the result from delaying input and frame handling */
+  g_task_set_priority (compile_task, PHOC_PRIORITY_BOOKKEEPING);
+  g_task_set_task_data (compile_task,
+                        phoc_keymap_names_new (names, key),
+                        (GDestroyNotify) phoc_keymap_names_free);
+  g_task_run_in_thread (compile_task, compile_keymap_thread);
+}
+
+/**
+ * phoc_keymap_cache_lookup_finish:
+ * @self: The keymap cache
+ * @res: The result
+ * @error: The return location for an error
+ *
+ * Finish an async keymap lookup.
+ *
+ * Returns: (transfer full) (nullable): The keymap or `NULL` on error
+ */
+struct xkb_keymap *
+phoc_keymap_cache_lookup_finish (PhocKeymapCache *self, GAsyncResult *res, GError **error)
+{
+  g_assert (PHOC_IS_KEYMAP_CACHE (self));
+  g_assert (G_IS_TASK (res));
+  g_assert (!error || !*error);
+  g_assert (g_task_get_source_tag (G_TASK (res)) == phoc_keymap_cache_lookup_async);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * phoc_keymap_cache_get_n_keymaps:
+ * @self: The keymap cache
+ *
+ * Returns: The number of cached keymaps
+ */
+guint
+phoc_keymap_cache_get_n_keymaps (PhocKeymapCache *self)
+{
+  g_assert (PHOC_IS_KEYMAP_CACHE (self));
+
+  return g_hash_table_size (self->keymaps);
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <xkbcommon/xkbcommon.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_KEYMAP_CACHE (phoc_keymap_cache_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocKeymapCache, phoc_keymap_cache, PHOC, KEYMAP_CACHE, GObject)
+
+PhocKeymapCache   *phoc_keymap_cache_get_default   (void);
+struct xkb_keymap *phoc_keymap_cache_lookup        (PhocKeymapCache              *self,
+                                                    const struct xkb_rule_names  *names);
+void               phoc_keymap_cache_lookup_async  (PhocKeymapCache              *self,
+                                                    const struct xkb_rule_names  *names,
+                                                    GCancellable                 *cancellable,
+                                                    GAsyncReadyCallback           callback,
+                                                    gpointer                      user_data);
+struct xkb_keymap *phoc_keymap_cache_lookup_finish (PhocKeymapCache              *self,
+                                                    GAsyncResult                 *res,
+                                                    GError                      **error);
+guint              phoc_keymap_cache_get_n_keymaps (PhocKeymapCache              *self);
+
+G_END_DECLS
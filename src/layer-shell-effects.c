@@ -70,6 +70,7 @@ struct _PhocDraggableLayerSurface {
     /* Slide in/out animation */
     guint    anim_id;
     float    anim_t;
+    gint64   anim_last_us;
     int32_t  anim_duration;
     int32_t  anim_start;
     int32_t  anim_end;
@@ -1027,7 +1028,6 @@ static void
 apply_margin (PhocDraggableLayerSurface *drag_surface, double margin)
 {
   struct wlr_layer_surface_v1 *wlr_layer_surface = drag_surface->layer_surface->layer_surface;
-  int exclusive = wlr_layer_surface->current.exclusive_zone;
 
   /* The client is not supposed to update margin or exclusive zone so
    * keep current and pending in sync */
@@ -1056,14 +1056,6 @@ apply_margin (PhocDraggableLayerSurface *drag_surface, double margin)
   wlr_layer_surface->pending.margin.left = wlr_layer_surface->current.margin.left;
   wlr_layer_surface->pending.margin.right = wlr_layer_surface->current.margin.right;
   wlr_layer_surface->pending.exclusive_zone = wlr_layer_surface->current.exclusive_zone;
-
-  /* Exclusive zone changes affect the surface ordering in a layer but not if both of them
-     are positive */
-  if (wlr_layer_surface->current.exclusive_zone != exclusive &&
-      (wlr_layer_surface->current.exclusive_zone <= 0 || exclusive <= 0)) {
-    PhocOutput *output = phoc_layer_surface_get_output (drag_surface->layer_surface);
-    phoc_output_set_layer_dirty (output, phoc_layer_surface_get_layer (drag_surface->layer_surface));
-  }
 }
 
 
@@ -1082,8 +1074,29 @@ apply_state (PhocDraggableLayerSurface *drag_surface, PhocDraggableSurfaceState
 }
 
 
+static void
+arrange_drag_surface (PhocDraggableLayerSurface *drag_surface,
+                      PhocOutput                *output,
+                      int32_t                    old_exclusive)
+{
+  struct wlr_layer_surface_v1 *wlr_layer_surface = drag_surface->layer_surface->layer_surface;
+  int32_t exclusive = wlr_layer_surface->current.exclusive_zone;
+
+  /* Exclusive zone changes affect the surface ordering in a layer but not if both of them
+     are positive */
+  if (exclusive != old_exclusive && (exclusive <= 0 || old_exclusive <= 0))
+    phoc_output_set_layer_dirty (output, phoc_layer_surface_get_layer (drag_surface->layer_surface));
+
+  /* Only exclusive zones affect the placement of other surfaces and views */
+  if (old_exclusive > 0 || wlr_layer_surface->current.exclusive_zone > 0)
+    phoc_layer_shell_arrange (output);
+  else
+    phoc_layer_shell_arrange_surface (output, drag_surface->layer_surface);
+}
+
+
 static gboolean
-on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpointer user_data)
+on_output_frame_callback (PhocAnimatable *animatable, guint64 frame_time, gpointer user_data)
 
 {
   PhocDraggableLayerSurface *drag_surface = user_data;
@@ -1091,6 +1104,7 @@ on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpoint
   PhocOutput *output;
   struct wlr_layer_surface_v1 *wlr_layer_surface;
   double margin, distance;
+  int32_t exclusive;
   bool done;
 
   g_assert (drag_surface);
@@ -1145,9 +1159,10 @@ on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpoint
     apply_state (drag_surface, PHOC_DRAGGABLE_SURFACE_STATE_NONE);
     drag_surface->drag.anim_id = 0;
   } else {
-    gint64 now = g_get_monotonic_time ();
+    gint64 delta_us = MAX ((gint64)frame_time - drag_surface->drag.anim_last_us, 0);
 
-    drag_surface->drag.anim_t += ((float)(now - last_frame)) / drag_surface->drag.anim_duration;
+    drag_surface->drag.anim_last_us = frame_time;
+    drag_surface->drag.anim_t += ((float)delta_us) / drag_surface->drag.anim_duration;
     if (drag_surface->drag.anim_t > 1.0)
       drag_surface->drag.anim_t = 1.0;
 
@@ -1164,10 +1179,9 @@ on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpoint
     zphoc_draggable_layer_surface_v1_send_dragged (drag_surface->resource, (int32_t)margin);
   }
 
+  exclusive = wlr_layer_surface->current.exclusive_zone;
   apply_margin (drag_surface, margin);
-  phoc_layer_shell_arrange (output);
-  /* FIXME: way too much damage */
-  phoc_output_damage_whole (output);
+  arrange_drag_surface (drag_surface, output, exclusive);
 
   return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
 }
@@ -1208,6 +1222,7 @@ phoc_draggable_layer_surface_slide (PhocDraggableLayerSurface *drag_surface, Pho
   }
 
   drag_surface->drag.anim_t = 0;
+  drag_surface->drag.anim_last_us = g_get_monotonic_time ();
   drag_surface->drag.anim_start = margin;
   drag_surface->drag.anim_dir = anim_dir;
   drag_surface->drag.anim_end = (anim_dir == ANIM_DIR_OUT) ?
@@ -1282,6 +1297,7 @@ accept_drag (PhocDraggableLayerSurface *drag_surface,
   PhocOutput *output;
   int32_t *target;
   int32_t margin = 0;
+  int32_t exclusive;
 
   output = PHOC_OUTPUT (wlr_output->data);
   g_assert (PHOC_IS_OUTPUT (output));
@@ -1316,6 +1332,7 @@ accept_drag (PhocDraggableLayerSurface *drag_surface,
   if (margin <= drag_surface->current.folded)
     margin = drag_surface->current.folded;
 
+  exclusive = wlr_layer_surface->current.exclusive_zone;
   *target = margin;
   wlr_layer_surface->current.exclusive_zone = -margin + drag_surface->current.exclusive;
 
@@ -1326,10 +1343,7 @@ accept_drag (PhocDraggableLayerSurface *drag_surface,
   wlr_layer_surface->pending.exclusive_zone = wlr_layer_surface->current.exclusive_zone;
 
   zphoc_draggable_layer_surface_v1_send_dragged (drag_surface->resource, margin);
-  phoc_layer_shell_arrange (output);
-
-  /* FIXME: way too much damage */
-  phoc_output_damage_whole (output);
+  arrange_drag_surface (drag_surface, output, exclusive);
 
   apply_state (drag_surface, PHOC_DRAGGABLE_SURFACE_STATE_DRAGGING);
 }
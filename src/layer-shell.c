@@ -14,6 +14,7 @@
 #include "desktop.h"
 #include "layer-shell.h"
 #include "layer-shell-private.h"
+#include "layout-transaction.h"
 #include "output.h"
 #include "seat.h"
 #include "server.h"
@@ -121,111 +122,183 @@ phoc_layer_shell_update_cursors (PhocLayerSurface *layer_surface)
 
 
 static gboolean
-arrange_layer (PhocOutput                     *output,
-               GSList                         *seats, /* PhocSeat */
-               enum zwlr_layer_shell_v1_layer  layer,
-               struct wlr_box                 *usable_area,
-               bool                            exclusive)
+arrange_inputs_changed (PhocLayerSurface     *layer_surface,
+                        const struct wlr_box *bounds)
 {
-  PhocLayerSurface *layer_surface;
-  struct wlr_box full_area = { 0 };
-  gboolean sent_configure = FALSE;
-  PhocInput *input = phoc_server_get_input (phoc_server_get_default ());
-
-  g_assert (PHOC_IS_OUTPUT (output));
-  wlr_output_effective_resolution (output->wlr_output, &full_area.width, &full_area.height);
-  wl_list_for_each_reverse (layer_surface, &output->layer_surfaces, link) {
-    struct wlr_layer_surface_v1 *wlr_layer_surface = layer_surface->layer_surface;
-    struct wlr_layer_surface_v1_state *state = &wlr_layer_surface->current;
+  const struct wlr_layer_surface_v1_state *state = &layer_surface->layer_surface->current;
+  const struct wlr_layer_surface_v1_state *arranged = &layer_surface->arranged_state;
+
+  if (!layer_surface->arranged)
+    return TRUE;
+
+  return !wlr_box_equal (bounds, &layer_surface->arranged_bounds) ||
+    state->anchor != arranged->anchor ||
+    state->exclusive_zone != arranged->exclusive_zone ||
+    state->desired_width != arranged->desired_width ||
+    state->desired_height != arranged->desired_height ||
+    state->margin.top != arranged->margin.top ||
+    state->margin.right != arranged->margin.right ||
+    state->margin.bottom != arranged->margin.bottom ||
+    state->margin.left != arranged->margin.left;
+}
 
-    if (layer_surface->layer != layer)
-      continue;
+/**
+ * arrange_layer_surface:
+ * @output: The output the layer surface is on
+ * @layer_surface: The layer surface to arrange
+ * @full_area: The output's full area
+ * @usable_area: (inout): The area not yet taken by exclusive zones
+ *
+ * Positions a single layer surface and shrinks @usable_area by its
+ * exclusive zone. Damages the old and new position if the surface
+ * moved.
+ *
+ * Returns: `TRUE` if the surface needs to change size and hence a
+ * configure event was sent to the client.
+ */
+static gboolean
+arrange_layer_surface (PhocOutput           *output,
+                       PhocLayerSurface     *layer_surface,
+                       const struct wlr_box *full_area,
+                       struct wlr_box       *usable_area)
+{
+  struct wlr_layer_surface_v1 *wlr_layer_surface = layer_surface->layer_surface;
+  struct wlr_layer_surface_v1_state *state = &wlr_layer_surface->current;
+  PhocInput *input = phoc_server_get_input (phoc_server_get_default ());
+  gboolean sent_configure = FALSE;
 
-    if (exclusive != (state->exclusive_zone > 0))
-      continue;
+  struct wlr_box bounds;
+  if (state->exclusive_zone == -1)
+    bounds = *full_area;
+  else
+    bounds = *usable_area;
 
-    struct wlr_box bounds;
-    if (state->exclusive_zone == -1)
-      bounds = full_area;
-    else
-      bounds = *usable_area;
-
-    struct wlr_box box = {
-      .width = state->desired_width,
-      .height = state->desired_height
-    };
-    /* Horizontal axis */
-    const uint32_t both_horiz = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
-      | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
-    if ((state->anchor & both_horiz) && box.width == 0) {
-      box.x = bounds.x;
-      box.width = bounds.width;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
-      box.x = bounds.x;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
-      box.x = bounds.x + (bounds.width - box.width);
-    } else {
-      box.x = bounds.x + ((bounds.width / 2) - (box.width / 2));
-    }
-    /* Vertical axis */
-    const uint32_t both_vert = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
-      | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
-    if ((state->anchor & both_vert) && box.height == 0) {
-      box.y = bounds.y;
-      box.height = bounds.height;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
-      box.y = bounds.y;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
-      box.y = bounds.y + (bounds.height - box.height);
-    } else {
-      box.y = bounds.y + ((bounds.height / 2) - (box.height / 2));
-    }
-    /* Margin */
-    if ((state->anchor & both_horiz) == both_horiz) {
-      box.x += state->margin.left;
-      box.width -= state->margin.left + state->margin.right;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
-      box.x += state->margin.left;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
-      box.x -= state->margin.right;
-    }
-    if ((state->anchor & both_vert) == both_vert) {
-      box.y += state->margin.top;
-      box.height -= state->margin.top + state->margin.bottom;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
-      box.y += state->margin.top;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
-      box.y -= state->margin.bottom;
-    }
-    if (box.width < 0 || box.height < 0) {
-      g_warning_once ("Layer surface '%s' has negative bounds %dx%d - ignoring",
-                      layer_surface->layer_surface->namespace ?: "<unknown>",
-                      box.width, box.height);
-      /* The layer surface never gets configured, hence the client sees a protocol error */
-      continue;
-    }
-
-    /* Apply */
-    struct wlr_box old_geo = layer_surface->geo;
-    layer_surface->geo = box;
+  /* Same inputs give the same geometry so only the exclusive zone needs applying */
+  if (!arrange_inputs_changed (layer_surface, &bounds)) {
     if (wlr_layer_surface->surface->mapped) {
       apply_exclusive (usable_area, state->anchor, state->exclusive_zone,
                        state->margin.top, state->margin.right,
                        state->margin.bottom, state->margin.left);
     }
+    return FALSE;
+  }
 
-    if (box.width != old_geo.width || box.height != old_geo.height) {
-      phoc_layer_surface_send_configure (layer_surface);
-      sent_configure = TRUE;
-    }
+  struct wlr_box box = {
+    .width = state->desired_width,
+    .height = state->desired_height
+  };
+  /* Horizontal axis */
+  const uint32_t both_horiz = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
+    | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
+  if ((state->anchor & both_horiz) && box.width == 0) {
+    box.x = bounds.x;
+    box.width = bounds.width;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
+    box.x = bounds.x;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
+    box.x = bounds.x + (bounds.width - box.width);
+  } else {
+    box.x = bounds.x + ((bounds.width / 2) - (box.width / 2));
+  }
+  /* Vertical axis */
+  const uint32_t both_vert = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
+    | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
+  if ((state->anchor & both_vert) && box.height == 0) {
+    box.y = bounds.y;
+    box.height = bounds.height;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
+    box.y = bounds.y;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
+    box.y = bounds.y + (bounds.height - box.height);
+  } else {
+    box.y = bounds.y + ((bounds.height / 2) - (box.height / 2));
+  }
+  /* Margin */
+  if ((state->anchor & both_horiz) == both_horiz) {
+    box.x += state->margin.left;
+    box.width -= state->margin.left + state->margin.right;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
+    box.x += state->margin.left;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
+    box.x -= state->margin.right;
+  }
+  if ((state->anchor & both_vert) == both_vert) {
+    box.y += state->margin.top;
+    box.height -= state->margin.top + state->margin.bottom;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
+    box.y += state->margin.top;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
+    box.y -= state->margin.bottom;
+  }
+  if (box.width < 0 || box.height < 0) {
+    g_warning_once ("Layer surface '%s' has negative bounds %dx%d - ignoring",
+                    layer_surface->layer_surface->namespace ?: "<unknown>",
+                    box.width, box.height);
+    /* The layer surface never gets configured, hence the client sees a protocol error */
+    return FALSE;
+  }
 
-    /* Having a cursor newly end up over the moved layer will not
-     * automatically send a motion event to the surface. The event needs to
-     * be synthesized.
-     * Only update layer surfaces which kept their size (and so buffers) the
-     * same, because those with resized buffers will be handled separately. */
-    if (layer_surface->geo.x != old_geo.x || layer_surface->geo.y != old_geo.y)
-      phoc_input_update_cursor_focus (input);
+  /* Apply */
+  struct wlr_box old_geo = layer_surface->geo;
+  gboolean moved = !wlr_box_equal (&box, &old_geo) && wlr_layer_surface->surface->mapped;
+
+  layer_surface->arranged = TRUE;
+  layer_surface->arranged_bounds = bounds;
+  layer_surface->arranged_state = *state;
+
+  /* Damage the old and the new position only */
+  if (moved)
+    phoc_output_damage_from_layer_surface (output, layer_surface, TRUE);
+  layer_surface->geo = box;
+  if (moved)
+    phoc_output_damage_from_layer_surface (output, layer_surface, TRUE);
+
+  if (wlr_layer_surface->surface->mapped) {
+    apply_exclusive (usable_area, state->anchor, state->exclusive_zone,
+                     state->margin.top, state->margin.right,
+                     state->margin.bottom, state->margin.left);
+  }
+
+  if (box.width != old_geo.width || box.height != old_geo.height) {
+    phoc_layer_surface_send_configure (layer_surface);
+    sent_configure = TRUE;
+  }
+
+  /* Having a cursor newly end up over the moved layer will not
+   * automatically send a motion event to the surface. The event needs to
+   * be synthesized.
+   * Only update layer surfaces which kept their size (and so buffers) the
+   * same, because those with resized buffers will be handled separately. */
+  if (layer_surface->geo.x != old_geo.x || layer_surface->geo.y != old_geo.y)
+    phoc_input_update_cursor_focus (input);
+
+  return sent_configure;
+}
+
+
+static gboolean
+arrange_layer (PhocOutput                     *output,
+               enum zwlr_layer_shell_v1_layer  layer,
+               const struct wlr_box           *full_area,
+               struct wlr_box                 *usable_area,
+               bool                            exclusive)
+{
+  g_autoptr (GPtrArray) layer_surfaces = NULL;
+  gboolean sent_configure = FALSE;
+  guint n_exclusive, start, end;
+
+  g_assert (PHOC_IS_OUTPUT (output));
+
+  /* Keep a ref as arranging might mark the layer dirty */
+  layer_surfaces = phoc_output_get_layer_surfaces_for_arrange (output, layer, &n_exclusive);
+  g_ptr_array_ref (layer_surfaces);
+  start = exclusive ? 0 : n_exclusive;
+  end = exclusive ? n_exclusive : layer_surfaces->len;
+
+  for (guint i = start; i < end; i++) {
+    PhocLayerSurface *layer_surface = g_ptr_array_index (layer_surfaces, i);
+
+    sent_configure |= arrange_layer_surface (output, layer_surface, full_area, usable_area);
   }
 
   return sent_configure;
@@ -254,13 +327,6 @@ phoc_layer_shell_find_osk (PhocOutput *output)
 }
 
 
-static gboolean
-view_arrange_iter (PhocDesktop *desktop, PhocView *view, gpointer unused)
-{
-  phoc_view_arrange (view, NULL, desktop->maximize);
-  return TRUE;
-}
-
 /**
  * phoc_layer_shell_arrange:
  * @output: The output to arrange
@@ -275,9 +341,8 @@ phoc_layer_shell_arrange (PhocOutput *output)
 {
   PhocServer *server = phoc_server_get_default ();
   PhocDesktop *desktop = phoc_server_get_desktop (server);
-  PhocInput *input = phoc_server_get_input (server);
-  struct wlr_box usable_area = { 0 };
-  GSList *seats = phoc_input_get_seats (input);
+  PhocLayoutTransaction *transaction = phoc_layout_transaction_get_default ();
+  struct wlr_box full_area = { 0 }, usable_area;
   gboolean usable_area_changed, sent_configure = FALSE;
   enum zwlr_layer_shell_v1_layer layers[] = {
     ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY,
@@ -292,21 +357,28 @@ phoc_layer_shell_arrange (PhocOutput *output)
    */
   phoc_layer_shell_update_osk (output, FALSE);
 
-  wlr_output_effective_resolution (output->wlr_output, &usable_area.width, &usable_area.height);
+  /* Views resized for the new layout are part of the transaction too */
+  phoc_layout_transaction_begin (transaction);
+
+  wlr_output_effective_resolution (output->wlr_output, &full_area.width, &full_area.height);
+  usable_area = full_area;
   /* Arrange exclusive surfaces from top->bottom */
   for (size_t i = 0; i < G_N_ELEMENTS (layers); i++)
-    sent_configure |= arrange_layer (output, seats, layers[i], &usable_area, true);
+    sent_configure |= arrange_layer (output, layers[i], &full_area, &usable_area, true);
 
   usable_area_changed = memcmp (&output->usable_area, &usable_area, sizeof (output->usable_area));
   if (usable_area_changed) {
     g_debug ("Usable area changed, rearranging views");
     output->usable_area = usable_area;
-    phoc_desktop_for_each_view (desktop, view_arrange_iter, NULL);
+    phoc_desktop_arrange_views (desktop, output);
   }
 
   /* Arrange non-exlusive surfaces from top->bottom */
   for (size_t i = 0; i < G_N_ELEMENTS (layers); i++)
-    sent_configure |= arrange_layer (output, seats, layers[i], &usable_area, false);
+    sent_configure |= arrange_layer (output, layers[i], &full_area, &usable_area, false);
+
+  if (phoc_layout_transaction_end (transaction))
+    phoc_output_freeze (output);
 
   phoc_output_update_shell_reveal (output);
 
@@ -329,6 +401,38 @@ phoc_layer_shell_arrange (PhocOutput *output)
   return sent_configure;
 }
 
+/**
+ * phoc_layer_shell_arrange_surface:
+ * @output: The output the layer surface is on
+ * @layer_surface: A layer surface without an exclusive zone
+ *
+ * Arrange a single layer surface on the given output. As surfaces
+ * without an exclusive zone don't affect the position of any other
+ * surface this is sufficient when e.g. only such a surface's margin
+ * changed. Use [func@layer_shell_arrange] for all other cases.
+ *
+ * Returns: `TRUE` if the layer surface needs to change size
+ * and hence a configure event was sent to the client.
+ */
+gboolean
+phoc_layer_shell_arrange_surface (PhocOutput *output, PhocLayerSurface *layer_surface)
+{
+  struct wlr_box full_area = { 0 };
+  struct wlr_box usable_area = output->usable_area;
+  gboolean sent_configure;
+
+  g_assert (PHOC_IS_OUTPUT (output));
+  g_assert (PHOC_IS_LAYER_SURFACE (layer_surface));
+  g_return_val_if_fail (layer_surface->layer_surface->current.exclusive_zone <= 0, FALSE);
+
+  wlr_output_effective_resolution (output->wlr_output, &full_area.width, &full_area.height);
+  sent_configure = arrange_layer_surface (output, layer_surface, &full_area, &usable_area);
+
+  phoc_output_update_shell_reveal (output);
+
+  return sent_configure;
+}
+
 
 void
 phoc_layer_shell_update_focus (void)
@@ -424,11 +528,13 @@ phoc_handle_layer_shell_surface (struct wl_listener *listener, void *data)
   struct wlr_layer_surface_v1_state old_state = wlr_layer_surface->current;
   wlr_layer_surface->current = wlr_layer_surface->pending;
 
-  phoc_layer_shell_arrange (output);
   phoc_output_set_layer_dirty (output, wlr_layer_surface->pending.layer);
+  phoc_layer_shell_arrange (output);
   phoc_layer_shell_update_focus ();
 
   wlr_layer_surface->current = old_state;
+  /* Arrange order used the pending exclusive zone */
+  phoc_output_set_layer_dirty (output, wlr_layer_surface->pending.layer);
 
   g_debug ("New layer surface %p: namespace %s layer %d anchor %d size %dx%d margin %d,%d,%d,%d",
            self,
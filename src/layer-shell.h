@@ -18,6 +18,8 @@ enum layer_parent {
 
 
 gboolean                phoc_layer_shell_arrange                 (PhocOutput *output);
+gboolean                phoc_layer_shell_arrange_surface         (PhocOutput       *output,
+                                                                  PhocLayerSurface *layer_surface);
 void                    phoc_layer_shell_update_focus            (void);
 void                    phoc_layer_shell_update_osk              (PhocOutput *output,
                                                                   gboolean    arrange);
@@ -88,6 +88,29 @@ phoc_layer_surface_child_root_apply_damage (PhocChildRoot *root)
 }
 
 
+static void
+phoc_layer_surface_child_root_apply_surface_damage (PhocChildRoot      *root,
+                                                    struct wlr_surface *surface,
+                                                    int                 sx,
+                                                    int                 sy)
+{
+  PhocLayerSurface *self = PHOC_LAYER_SURFACE (root);
+  struct wlr_output *wlr_output;
+
+  g_assert (PHOC_IS_LAYER_SURFACE (self));
+
+  wlr_output = self->layer_surface->output;
+  if (!wlr_output)
+    return;
+
+  phoc_output_damage_from_single_surface (PHOC_OUTPUT (wlr_output->data),
+                                          surface,
+                                          self->geo.x + sx,
+                                          self->geo.y + sy,
+                                          1.0);
+}
+
+
 static void
 phoc_layer_surface_child_root_add_child (PhocChildRoot *root, PhocViewChild *child)
 {
@@ -140,6 +163,7 @@ phoc_layer_surface_child_root_iface_init (PhocChildRootInterface *iface)
   iface->get_box = phoc_layer_surface_child_root_get_box;
   iface->is_mapped = phoc_layer_surface_child_root_is_mapped;
   iface->apply_damage = phoc_layer_surface_child_root_apply_damage;
+  iface->apply_surface_damage = phoc_layer_surface_child_root_apply_surface_damage;
   iface->add_child = phoc_layer_surface_child_root_add_child;
   iface->remove_child = phoc_layer_surface_child_root_remove_child;
   iface->unconstrain_popup = phoc_layer_surface_child_root_unconstrain_box;
@@ -160,6 +184,10 @@ phoc_layer_surface_apply_damage (PhocLayerSurface *self)
   if (!wlr_output)
     return;
 
+  /* Children might have moved relative to us */
+  for (GSList *l = self->child_surfaces; l; l = l->next)
+    phoc_view_child_invalidate_pos (PHOC_VIEW_CHILD (l->data));
+
   phoc_output_damage_from_layer_surface (PHOC_OUTPUT (wlr_output->data),
                                          self,
                                          FALSE);
@@ -216,7 +244,7 @@ handle_surface_commit (struct wl_listener *listener, void *data)
   PhocLayerSurface *self = wl_container_of (listener, self, surface_commit);
   struct wlr_layer_surface_v1 *wlr_layer_surface = self->layer_surface;
   struct wlr_output *wlr_output = wlr_layer_surface->output;
-  gboolean exclusive_zone_changed;
+  gboolean exclusive_zone_changed = FALSE;
 
   if (!wlr_output)
     return;
@@ -233,6 +261,13 @@ handle_surface_commit (struct wl_listener *listener, void *data)
       phoc_output_set_layer_dirty (output, self->layer);
 
     self->layer = wlr_layer_surface->current.layer;
+
+    /* Exclusive zone changes affect the surface ordering in a layer */
+    exclusive_zone_changed = !!(wlr_layer_surface->current.committed &
+                                WLR_LAYER_SURFACE_V1_STATE_EXCLUSIVE_ZONE);
+    if (layer_changed || exclusive_zone_changed)
+      phoc_output_set_layer_dirty (output, self->layer);
+
     phoc_layer_shell_arrange (output);
     phoc_layer_shell_update_focus ();
   }
@@ -269,12 +304,6 @@ handle_surface_commit (struct wl_listener *listener, void *data)
                                      FALSE);
   }
 
-  /* Exclusive zone changes affect the surface ordering in a layer */
-  exclusive_zone_changed = !!(wlr_layer_surface->current.committed &
-                              WLR_LAYER_SURFACE_V1_STATE_EXCLUSIVE_ZONE);
-  if (layer_changed || exclusive_zone_changed)
-    phoc_output_set_layer_dirty (output, self->layer);
-
   if (self->pending_serial &&
       self->layer_surface->current.configure_serial >= self->pending_serial) {
     g_debug ("layer-surface ack'ed serial %d", self->layer_surface->current.configure_serial);
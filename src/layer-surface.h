@@ -43,6 +43,11 @@ struct _PhocLayerSurface {
   GSList            *child_surfaces;
   /* Last not yet ACKed serial */
   uint32_t           pending_serial;
+
+  /* Inputs of the last arrangement, see phoc_layer_shell_arrange () */
+  gboolean           arranged;
+  struct wlr_box     arranged_bounds;
+  struct wlr_layer_surface_v1_state arranged_state;
 };
 
 PhocLayerSurface *phoc_layer_surface_new (struct wlr_layer_surface_v1 *layer_surface);
@@ -10,13 +10,23 @@
 
 #include "phoc-config.h"
 
+#include "layer-surface.h"
 #include "layout-transaction.h"
+#include "output.h"
+#include "server.h"
 
 /**
  * PhocLayoutTransaction:
  *
- * Track configures from layer surfaces and emit a signal when all of
- * them have committed new matching buffers.
+ * Track configures sent for a layout change and emit a signal when all
+ * of them have committed new matching buffers.
+ *
+ * Layer surfaces always take part. Views take part when they get
+ * configured between [method@LayoutTransaction.begin] and
+ * [method@LayoutTransaction.end]. Outputs affected by the layout change
+ * keep presenting their last frame until their clients caught up so
+ * intermediate layouts where only some clients resized aren't shown,
+ * see [method@LayoutTransaction.is_pending_on_output].
  */
 
 #define TIMEOUT_LAYER_MS 3000
@@ -33,7 +43,11 @@ struct _PhocLayoutTransaction {
 
   gint64                starttime;
   guint                 pending_layer_configures;
+  GHashTable           *pending_views;
   guint                 layer_timer_id;
+
+  guint                 collecting;
+  guint                 n_collected;
 };
 G_DEFINE_TYPE (PhocLayoutTransaction, phoc_layout_transaction, G_TYPE_OBJECT)
 
@@ -41,19 +55,22 @@ G_DEFINE_TYPE (PhocLayoutTransaction, phoc_layout_transaction, G_TYPE_OBJECT)
 static void
 apply_transaction (PhocLayoutTransaction *self)
 {
-  g_debug ("Would apply layout transaction");
+  g_debug ("Applying layout transaction");
+
+  /* Affected outputs present the new layout once notified */
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
 }
 
 
 static void
 abort_transaction (PhocLayoutTransaction *self)
 {
-  g_return_if_fail (self->pending_layer_configures);
-
-  apply_transaction (self);
+  g_return_if_fail (phoc_layout_transaction_is_active (self));
 
   self->pending_layer_configures = 0;
-  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+  g_hash_table_remove_all (self->pending_views);
+
+  apply_transaction (self);
 }
 
 
@@ -63,12 +80,40 @@ on_timeout_expired (gpointer user_data)
   PhocLayoutTransaction *self = PHOC_LAYOUT_TRANSACTION (user_data);
 
   self->layer_timer_id = 0;
-  g_warning ("Timeout (%dms) expired with %u configures pending",
-             TIMEOUT_LAYER_MS, self->pending_layer_configures);
+  g_warning ("Timeout (%dms) expired with %u layer and %u view configures pending",
+             TIMEOUT_LAYER_MS, self->pending_layer_configures,
+             g_hash_table_size (self->pending_views));
   abort_transaction (self);
 }
 
 
+static void
+start_transaction (PhocLayoutTransaction *self)
+{
+  /* Outstanding configures. Transaction started */
+  g_debug ("Starting new layout transaction");
+  self->starttime = g_get_monotonic_time ();
+  self->layer_timer_id = g_timeout_add_once (TIMEOUT_LAYER_MS, on_timeout_expired, self);
+  g_source_set_name_by_id (self->layer_timer_id, "[phoc] layout transaction timer");
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+}
+
+
+static void
+finish_transaction (PhocLayoutTransaction *self)
+{
+  gint64 now;
+
+  /* All outstanding configures committed buffers */
+  now = g_get_monotonic_time ();
+  g_debug ("Layout transaction finished after %" G_GINT64_FORMAT "ms",
+           (now - self->starttime) / 1000);
+  g_clear_handle_id (&self->layer_timer_id, g_source_remove);
+
+  apply_transaction (self);
+}
+
+
 static void
 phoc_layout_transaction_get_property (GObject    *object,
                                       guint       property_id,
@@ -94,6 +139,8 @@ phoc_layout_transaction_dispose (GObject *object)
   PhocLayoutTransaction *self = PHOC_LAYOUT_TRANSACTION (object);
 
   g_clear_handle_id (&self->layer_timer_id, g_source_remove);
+  if (self->pending_views)
+    g_hash_table_remove_all (self->pending_views);
 
   G_OBJECT_CLASS (phoc_layout_transaction_parent_class)->dispose (object);
 }
@@ -104,7 +151,7 @@ phoc_layout_transaction_finalize (GObject *object)
 {
   PhocLayoutTransaction *self = PHOC_LAYOUT_TRANSACTION (object);
 
-  apply_transaction (self);
+  g_clear_pointer (&self->pending_views, g_hash_table_destroy);
 
   G_OBJECT_CLASS (phoc_layout_transaction_parent_class)->finalize (object);
 }
@@ -131,6 +178,7 @@ phoc_layout_transaction_class_init (PhocLayoutTransactionClass *klass)
 static void
 phoc_layout_transaction_init (PhocLayoutTransaction *self)
 {
+  self->pending_views = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 /**
@@ -159,7 +207,48 @@ phoc_layout_transaction_is_active (PhocLayoutTransaction *self)
 {
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
-  return self->pending_layer_configures > 0;
+  return self->pending_layer_configures > 0 || g_hash_table_size (self->pending_views) > 0;
+}
+
+/**
+ * phoc_layout_transaction_is_pending_on_output:
+ * @self: The transaction
+ * @output: The output
+ *
+ * Check whether clients shown on @output still need to commit for
+ * the transaction.
+ *
+ * Returns: `TRUE` if a layer surface on @output or a view intersecting
+ *   it didn't commit yet
+ */
+gboolean
+phoc_layout_transaction_is_pending_on_output (PhocLayoutTransaction *self, PhocOutput *output)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocLayerSurface *layer_surface;
+  GHashTableIter iter;
+  PhocView *view;
+
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_assert (PHOC_IS_OUTPUT (output));
+
+  if (self->pending_layer_configures) {
+    wl_list_for_each (layer_surface, &output->layer_surfaces, link) {
+      if (layer_surface->pending_serial)
+        return TRUE;
+    }
+  }
+
+  g_hash_table_iter_init (&iter, self->pending_views);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&view, NULL)) {
+    struct wlr_box box;
+
+    phoc_view_get_box (view, &box);
+    if (wlr_output_layout_intersects (desktop->layout, output->wlr_output, &box))
+      return TRUE;
+  }
+
+  return FALSE;
 }
 
 /**
@@ -173,20 +262,19 @@ phoc_layout_transaction_is_active (PhocLayoutTransaction *self)
 void
 phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self)
 {
+  gboolean was_active;
+
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
+  was_active = phoc_layout_transaction_is_active (self);
   self->pending_layer_configures++;
-  if (self->pending_layer_configures > 1) {
+  self->n_collected++;
+  if (was_active) {
     g_debug ("Layout transaction, adding %dth pending configure", self->pending_layer_configures);
     return;
   }
 
-  /* Outstanding configures. Transaction started */
-  g_debug ("Starting new layout transaction");
-  self->starttime = g_get_monotonic_time ();
-  self->layer_timer_id = g_timeout_add_once (TIMEOUT_LAYER_MS, on_timeout_expired, self);
-  g_source_set_name_by_id (self->layer_timer_id, "[phoc] layout transaction timer");
-  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+  start_transaction (self);
 }
 
 /**
@@ -200,24 +288,116 @@ phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self)
 void
 phoc_layout_transaction_notify_layer_configured (PhocLayoutTransaction *self)
 {
-  gint64 now;
-
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
   g_return_if_fail (self->pending_layer_configures > 0);
 
   self->pending_layer_configures--;
-  if (self->pending_layer_configures) {
-    g_debug ("Layout transaction has %u configures pending", self->pending_layer_configures);
+  if (phoc_layout_transaction_is_active (self)) {
+    g_debug ("Layout transaction has %u layer configures pending",
+             self->pending_layer_configures);
     return;
   }
 
-  /* All outstanding configures committed buffers */
-  now = g_get_monotonic_time ();
-  g_debug ("Layout transaction finished after %" G_GINT64_FORMAT "ms",
-           (now - self->starttime) / 1000);
-  g_clear_handle_id (&self->layer_timer_id, g_source_remove);
-  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+  finish_transaction (self);
+}
 
-  apply_transaction (self);
+/**
+ * phoc_layout_transaction_add_view_dirty:
+ * @self: The transaction
+ * @view: The view that got configured
+ *
+ * Invoked by views when they sent a configure. The view only becomes
+ * part of the transaction if configures are currently being collected
+ * as otherwise the configure isn't part of a layout change.
+ */
+void
+phoc_layout_transaction_add_view_dirty (PhocLayoutTransaction *self, PhocView *view)
+{
+  gboolean was_active;
+
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_assert (PHOC_IS_VIEW (view));
+
+  if (!self->collecting)
+    return;
+
+  if (g_hash_table_contains (self->pending_views, view))
+    return;
+
+  was_active = phoc_layout_transaction_is_active (self);
+  g_hash_table_add (self->pending_views, view);
+  self->n_collected++;
+  if (was_active) {
+    g_debug ("Layout transaction, adding view %p", view);
+    return;
+  }
+
+  start_transaction (self);
+}
+
+/**
+ * phoc_layout_transaction_notify_view_configured:
+ * @self: The transaction
+ * @view: The view
+ *
+ * Invoked by views when they committed a buffer matching the last
+ * configure or when they go away. Does nothing if the view isn't part
+ * of the transaction.
+ */
+void
+phoc_layout_transaction_notify_view_configured (PhocLayoutTransaction *self, PhocView *view)
+{
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+
+  if (!g_hash_table_remove (self->pending_views, view))
+    return;
+
+  if (phoc_layout_transaction_is_active (self)) {
+    g_debug ("Layout transaction has %u view configures pending",
+             g_hash_table_size (self->pending_views));
+    return;
+  }
+
+  finish_transaction (self);
+}
+
+/**
+ * phoc_layout_transaction_begin:
+ * @self: The transaction
+ *
+ * Start collecting configures for a layout change. Views configured
+ * until the matching [method@LayoutTransaction.end] become part of
+ * the transaction. Calls can be nested.
+ */
+void
+phoc_layout_transaction_begin (PhocLayoutTransaction *self)
+{
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+
+  if (self->collecting == 0)
+    self->n_collected = 0;
+
+  self->collecting++;
+}
+
+/**
+ * phoc_layout_transaction_end:
+ * @self: The transaction
+ *
+ * Stop collecting configures for a layout change.
+ *
+ * Returns: `TRUE` if configures were sent since the outermost
+ *   [method@LayoutTransaction.begin] and the transaction is still
+ *   waiting for them.
+ */
+gboolean
+phoc_layout_transaction_end (PhocLayoutTransaction *self)
+{
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_return_val_if_fail (self->collecting > 0, FALSE);
+
+  self->collecting--;
+
+  return self->n_collected > 0 && phoc_layout_transaction_is_active (self);
 }
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "view.h"
+
 #include <glib-object.h>
 
 G_BEGIN_DECLS
@@ -18,7 +20,15 @@ G_DECLARE_FINAL_TYPE (PhocLayoutTransaction, phoc_layout_transaction, PHOC, LAYO
 PhocLayoutTransaction *
                   phoc_layout_transaction_get_default (void);
 gboolean          phoc_layout_transaction_is_active (PhocLayoutTransaction *self);
+gboolean          phoc_layout_transaction_is_pending_on_output (PhocLayoutTransaction *self,
+                                                                PhocOutput            *output);
 void              phoc_layout_transaction_notify_layer_configured (PhocLayoutTransaction *self);
 void              phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self);
+void              phoc_layout_transaction_add_view_dirty (PhocLayoutTransaction *self,
+                                                          PhocView              *view);
+void              phoc_layout_transaction_notify_view_configured (PhocLayoutTransaction *self,
+                                                                  PhocView              *view);
+void              phoc_layout_transaction_begin (PhocLayoutTransaction *self);
+gboolean          phoc_layout_transaction_end (PhocLayoutTransaction *self);
 
 G_END_DECLS
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-loop-monitor"
+
+#include "phoc-config.h"
+#include "phoc-tracing.h"
+
+#include "loop-monitor.h"
+
+#define PHOC_LOOP_MONITOR_MAX_SAMPLES 8
+
+/**
+ * PhocLoopMonitor:
+ *
+ * Measures how long the main loop is busy between two polls. When an
+ * iteration exceeds the budget it's reported together with the time
+ * the sources that added samples via [method@LoopMonitor.add_sample]
+ * took.
+ *
+ * Only phoc's own sources attribute their time, currently the Wayland
+ * event dispatch and delayed output repaints. GLib has no hook to time
+ * individual dispatches so everything else, like D-Bus or GSettings
+ * handlers, is reported as "other".
+ *
+ * The time spent blocking in poll isn't accounted so idle periods
+ * don't count as latency.
+ */
+struct _PhocLoopMonitor {
+  GObject       parent;
+
+  GMainContext *context;
+  GPollFunc     poll_func;
+  gint64        wakeup_us;
+
+  struct {
+    const char *name;  /* interned */
+    gint64      duration_us;
+  } samples[PHOC_LOOP_MONITOR_MAX_SAMPLES];
+  guint         n_samples;
+
+  guint64       n_iterations;
+  guint64       n_overruns;
+  gint64        max_latency_us;
+  char         *last_overrun;
+};
+G_DEFINE_TYPE (PhocLoopMonitor, phoc_loop_monitor, G_TYPE_OBJECT)
+
+/* Poll functions don't take user data */
+static PhocLoopMonitor *instance;
+
+
+static void
+report_iteration (PhocLoopMonitor *self, gint64 now_us)
+{
+  gint64 latency_us = now_us - self->wakeup_us;
+  g_autoptr (GString) culprits = NULL;
+  gint64 other_us = latency_us;
+
+  self->n_iterations++;
+  self->max_latency_us = MAX (self->max_latency_us, latency_us);
+
+  if (G_LIKELY (latency_us <= PHOC_LOOP_MONITOR_BUDGET_US))
+    return;
+
+  self->n_overruns++;
+
+  culprits = g_string_new (NULL);
+  for (guint i = 0; i < self->n_samples; i++) {
+    g_string_append_printf (culprits, "%s: %" G_GINT64_FORMAT "us, ",
+                            self->samples[i].name, self->samples[i].duration_us);
+    other_us -= self->samples[i].duration_us;
+  }
+  g_string_append_printf (culprits, "other: %" G_GINT64_FORMAT "us", MAX (other_us, 0));
+
+  g_debug ("Main loop iteration took %" G_GINT64_FORMAT "us (budget %dus): %s",
+           latency_us, PHOC_LOOP_MONITOR_BUDGET_US, culprits->str);
+  phoc_trace_mark (self->wakeup_us * 1000, latency_us * 1000, "phoc", __func__,
+                   "Main loop overrun: %s", culprits->str);
+
+  g_free (self->last_overrun);
+  self->last_overrun = g_string_free (g_steal_pointer (&culprits), FALSE);
+}
+
+
+static int
+phoc_loop_monitor_poll (GPollFD *fds, guint nfds, int timeout)
+{
+  PhocLoopMonitor *self = instance;
+  int ret;
+
+  if (self->wakeup_us)
+    report_iteration (self, g_get_monotonic_time ());
+  self->n_samples = 0;
+
+  ret = self->poll_func (fds, nfds, timeout);
+
+  self->wakeup_us = g_get_monotonic_time ();
+
+  return ret;
+}
+
+
+static void
+phoc_loop_monitor_finalize (GObject *object)
+{
+  PhocLoopMonitor *self = PHOC_LOOP_MONITOR (object);
+
+  g_main_context_set_poll_func (self->context, self->poll_func);
+  g_clear_pointer (&self->context, g_main_context_unref);
+  g_clear_pointer (&self->last_overrun, g_free);
+
+  G_OBJECT_CLASS (phoc_loop_monitor_parent_class)->finalize (object);
+}
+
+
+static void
+phoc_loop_monitor_class_init (PhocLoopMonitorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phoc_loop_monitor_finalize;
+}
+
+
+static void
+phoc_loop_monitor_init (PhocLoopMonitor *self)
+{
+  self->context = g_main_context_ref (g_main_context_default ());
+  self->poll_func = g_main_context_get_poll_func (self->context);
+  g_main_context_set_poll_func (self->context, phoc_loop_monitor_poll);
+}
+
+/**
+ * phoc_loop_monitor_get_default:
+ *
+ * Get the loop monitor singleton. It monitors the default main context.
+ *
+ * Returns: (transfer none): The loop monitor singleton
+ */
+PhocLoopMonitor *
+phoc_loop_monitor_get_default (void)
+{
+  if (G_UNLIKELY (instance == NULL)) {
+    g_debug ("Creating loop monitor");
+    instance = g_object_new (PHOC_TYPE_LOOP_MONITOR, NULL);
+
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+
+  return instance;
+}
+
+/**
+ * phoc_loop_monitor_add_sample:
+ * @self: The loop monitor
+ * @name: (nullable): The interned name to account the time to
+ * @duration_us: The time spent in usecs
+ *
+ * Account time spent in the current main loop iteration so it shows
+ * up when the iteration overruns. If @name is `NULL` the name of the
+ * currently dispatched source is used.
+ *
+ * Frequent callers should intern @name once via
+ * [func@GLib.intern_static_string] and pass it on every call.
+ */
+void
+phoc_loop_monitor_add_sample (PhocLoopMonitor *self, const char *name, gint64 duration_us)
+{
+  GSource *source;
+
+  g_assert (PHOC_IS_LOOP_MONITOR (self));
+
+  if (name == NULL) {
+    source = g_main_current_source ();
+    name = source ? g_source_get_name (source) : NULL;
+    name = g_intern_string (name ?: "unnamed source");
+  }
+
+  for (guint i = 0; i < self->n_samples; i++) {
+    if (self->samples[i].name == name) {
+      self->samples[i].duration_us += duration_us;
+      return;
+    }
+  }
+
+  /* Accounted as "other" */
+  if (self->n_samples == PHOC_LOOP_MONITOR_MAX_SAMPLES)
+    return;
+
+  self->samples[self->n_samples].name = name;
+  self->samples[self->n_samples].duration_us = duration_us;
+  self->n_samples++;
+}
+
+/**
+ * phoc_loop_monitor_get_n_iterations:
+ * @self: The loop monitor
+ *
+ * Returns: The number of main loop iterations seen so far
+ */
+guint64
+phoc_loop_monitor_get_n_iterations (PhocLoopMonitor *self)
+{
+  g_assert (PHOC_IS_LOOP_MONITOR (self));
+
+  return self->n_iterations;
+}
+
+/**
+ * phoc_loop_monitor_get_n_overruns:
+ * @self: The loop monitor
+ *
+ * Returns: The number of main loop iterations that exceeded the budget
+ */
+guint64
+phoc_loop_monitor_get_n_overruns (PhocLoopMonitor *self)
+{
+  g_assert (PHOC_IS_LOOP_MONITOR (self));
+
+  return self->n_overruns;
+}
+
+/**
+ * phoc_loop_monitor_get_max_latency:
+ * @self: The loop monitor
+ *
+ * Returns: The longest main loop iteration seen so far in usecs
+ */
+gint64
+phoc_loop_monitor_get_max_latency (PhocLoopMonitor *self)
+{
+  g_assert (PHOC_IS_LOOP_MONITOR (self));
+
+  return self->max_latency_us;
+}
+
+/**
+ * phoc_loop_monitor_get_last_overrun:
+ * @self: The loop monitor
+ *
+ * Returns: (nullable): Where the time went in the last iteration that
+ *   exceeded the budget
+ */
+const char *
+phoc_loop_monitor_get_last_overrun (PhocLoopMonitor *self)
+{
+  g_assert (PHOC_IS_LOOP_MONITOR (self));
+
+  return self->last_overrun;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* An iteration taking longer than this can make us miss a frame at 120Hz */
+#define PHOC_LOOP_MONITOR_BUDGET_US 8000
+
+#define PHOC_TYPE_LOOP_MONITOR (phoc_loop_monitor_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocLoopMonitor, phoc_loop_monitor, PHOC, LOOP_MONITOR, GObject)
+
+PhocLoopMonitor *phoc_loop_monitor_get_default       (void);
+void             phoc_loop_monitor_add_sample        (PhocLoopMonitor *self,
+                                                      const char      *name,
+                                                      gint64           duration_us);
+guint64          phoc_loop_monitor_get_n_iterations  (PhocLoopMonitor *self);
+guint64          phoc_loop_monitor_get_n_overruns    (PhocLoopMonitor *self);
+gint64           phoc_loop_monitor_get_max_latency   (PhocLoopMonitor *self);
+const char      *phoc_loop_monitor_get_last_overrun  (PhocLoopMonitor *self);
+
+G_END_DECLS
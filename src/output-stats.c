@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-output-stats"
+
+#include "phoc-config.h"
+
+#include "output-stats.h"
+
+/* Upper limit of the first bucket, each further bucket doubles it */
+#define FIRST_BUCKET_LIMIT_US 500
+
+/**
+ * phoc_output_stats_reset:
+ * @stats: The stats
+ *
+ * Clear all statistics and restart collecting.
+ */
+void
+phoc_output_stats_reset (PhocOutputStats *stats)
+{
+  *stats = (PhocOutputStats) {
+    .since_us = g_get_monotonic_time (),
+  };
+}
+
+/**
+ * phoc_output_stats_get_bucket_limit:
+ * @bucket: The bucket
+ *
+ * Get the exclusive upper limit of a histogram bucket. The last
+ * bucket is unbounded.
+ *
+ * Returns: The limit in microseconds or `G_MAXINT64` for the last bucket.
+ */
+gint64
+phoc_output_stats_get_bucket_limit (guint bucket)
+{
+  g_assert (bucket < PHOC_OUTPUT_STATS_N_BUCKETS);
+
+  if (bucket == PHOC_OUTPUT_STATS_N_BUCKETS - 1)
+    return G_MAXINT64;
+
+  return (gint64)FIRST_BUCKET_LIMIT_US << bucket;
+}
+
+
+void
+phoc_output_stats_add_sample (PhocStatsHistogram *histogram, gint64 duration_us)
+{
+  guint bucket = 0;
+
+  duration_us = MAX (duration_us, 0);
+
+  while (duration_us >= phoc_output_stats_get_bucket_limit (bucket))
+    bucket++;
+
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->sum_us += duration_us;
+  histogram->max_us = MAX (histogram->max_us, (guint64)duration_us);
+}
+
+/**
+ * phoc_output_stats_surface_committed:
+ * @stats: The stats
+ *
+ * Record that a client commit damaged the output. Only the first commit
+ * since the last frame counts.
+ */
+void
+phoc_output_stats_surface_committed (PhocOutputStats *stats)
+{
+  if (stats->first_commit_us == 0)
+    stats->first_commit_us = g_get_monotonic_time ();
+}
+
+/**
+ * phoc_output_stats_frame_committed:
+ * @stats: The stats
+ *
+ * Record that a frame got committed to the output. Client commits
+ * that happened so far will be part of it.
+ */
+void
+phoc_output_stats_frame_committed (PhocOutputStats *stats)
+{
+  stats->pending_commit_us = stats->first_commit_us;
+  stats->first_commit_us = 0;
+  stats->frame_commit_us = g_get_monotonic_time ();
+}
+
+/**
+ * phoc_output_stats_frame_presented:
+ * @stats: The stats
+ * @when_us: When the frame got presented
+ * @refresh_us: The output's refresh period or `0` if unknown
+ *
+ * Record that the last committed frame got presented. A frame
+ * committed after the last presentation is expected on the first
+ * vblank following its commit, every refresh cycle it got presented
+ * later counts as a missed vblank. Idle periods don't count as the
+ * commit starts the expectation.
+ */
+void
+phoc_output_stats_frame_presented (PhocOutputStats *stats, gint64 when_us, gint64 refresh_us)
+{
+  gint64 last_present_us = stats->last_present_us;
+  gint64 commit_us = stats->frame_commit_us;
+
+  stats->last_present_us = when_us;
+  stats->frame_commit_us = 0;
+
+  if (refresh_us > 0 && last_present_us && commit_us > last_present_us) {
+    gint64 expected_us = last_present_us +
+      ((commit_us - last_present_us) / refresh_us + 1) * refresh_us;
+    gint64 late_us = when_us - expected_us;
+
+    /* Allow for jitter in the timestamps */
+    if (late_us > refresh_us / 2)
+      stats->missed_vblanks += (late_us + refresh_us / 2) / refresh_us;
+  }
+
+  if (stats->pending_commit_us == 0)
+    return;
+
+  phoc_output_stats_add_sample (&stats->commit_to_present, when_us - stats->pending_commit_us);
+  stats->pending_commit_us = 0;
+}
+
+
+void
+phoc_output_stats_add_damage (PhocOutputStats *stats, guint64 area)
+{
+  stats->damage_area_sum += area;
+  stats->damage_area_max = MAX (stats->damage_area_max, area);
+}
+
+
+static GVariant *
+histogram_to_variant (PhocStatsHistogram *histogram)
+{
+  g_auto (GVariantDict) dict = G_VARIANT_DICT_INIT (NULL);
+
+  g_variant_dict_insert (&dict, "count", "t", histogram->count);
+  g_variant_dict_insert (&dict, "sum-us", "t", histogram->sum_us);
+  g_variant_dict_insert (&dict, "max-us", "t", histogram->max_us);
+  g_variant_dict_insert_value (&dict, "buckets",
+                               g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64,
+                                                          histogram->buckets,
+                                                          PHOC_OUTPUT_STATS_N_BUCKETS,
+                                                          sizeof (guint64)));
+  return g_variant_dict_end (&dict);
+}
+
+/**
+ * phoc_output_stats_to_variant:
+ * @stats: The stats
+ *
+ * Serialize the statistics, e.g. for sending them via DBus.
+ *
+ * Returns: (transfer floating): The stats as `a{sv}`
+ */
+GVariant *
+phoc_output_stats_to_variant (PhocOutputStats *stats)
+{
+  g_auto (GVariantDict) dict = G_VARIANT_DICT_INIT (NULL);
+  gint64 limits[PHOC_OUTPUT_STATS_N_BUCKETS - 1];
+
+  for (guint i = 0; i < G_N_ELEMENTS (limits); i++)
+    limits[i] = phoc_output_stats_get_bucket_limit (i);
+
+  g_variant_dict_insert (&dict, "since-us", "x", stats->since_us);
+  g_variant_dict_insert_value (&dict, "bucket-limits-us",
+                               g_variant_new_fixed_array (G_VARIANT_TYPE_INT64,
+                                                          limits,
+                                                          G_N_ELEMENTS (limits),
+                                                          sizeof (gint64)));
+  g_variant_dict_insert_value (&dict, "render-time", histogram_to_variant (&stats->render_time));
+  g_variant_dict_insert_value (&dict, "commit-to-present",
+                               histogram_to_variant (&stats->commit_to_present));
+  g_variant_dict_insert_value (&dict, "frame-callback-latency",
+                               histogram_to_variant (&stats->frame_callback_latency));
+  g_variant_dict_insert (&dict, "composited-frames", "t", stats->composited_frames);
+  g_variant_dict_insert (&dict, "scanned-out-frames", "t", stats->scanned_out_frames);
+  g_variant_dict_insert (&dict, "offloaded-frames", "t", stats->offloaded_frames);
+  g_variant_dict_insert (&dict, "missed-vblanks", "t", stats->missed_vblanks);
+  g_variant_dict_insert (&dict, "damage-area-sum", "t", stats->damage_area_sum);
+  g_variant_dict_insert (&dict, "damage-area-max", "t", stats->damage_area_max);
+  g_variant_dict_insert (&dict, "damage-rects-in", "t", stats->damage_rects_in);
+  g_variant_dict_insert (&dict, "damage-rects-out", "t", stats->damage_rects_out);
+
+  return g_variant_dict_end (&dict);
+}
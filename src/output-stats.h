@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_OUTPUT_STATS_N_BUCKETS 8
+
+/**
+ * PhocStatsHistogram:
+ * @count: Number of samples
+ * @sum_us: Sum of all samples
+ * @max_us: Largest sample
+ * @buckets: Number of samples per bucket, see
+ *    [func@output_stats_get_bucket_limit]
+ *
+ * A histogram of durations
+ */
+typedef struct {
+  guint64 count;
+  guint64 sum_us;
+  guint64 max_us;
+  guint64 buckets[PHOC_OUTPUT_STATS_N_BUCKETS];
+} PhocStatsHistogram;
+
+/**
+ * PhocOutputStats:
+ * @since_us: Monotonic time when collecting started
+ * @render_time: CPU time spent compositing a frame
+ * @commit_to_present: Time from a client commit damaging the
+ *    output until the frame containing it got presented
+ * @frame_callback_latency: Time from the frame event until frame
+ *    done was sent to clients
+ * @composited_frames: Number of frames composited by phoc
+ * @scanned_out_frames: Number of frames that used direct scanout
+ * @offloaded_frames: Number of frames that used output layers
+ * @missed_vblanks: Number of refresh cycles frames got presented
+ *    later than the first vblank after their commit
+ * @damage_area_sum: Sum of the damaged area of all composited frames
+ *    in buffer pixels
+ * @damage_area_max: Largest damaged area of a composited frame
+ * @damage_rects_in: Number of damage rectangles submitted by surfaces
+ * @damage_rects_out: Number of damage rectangles left after merging
+ *
+ * Statistics about an output's frames. These are cheap to collect
+ * so they're always on.
+ */
+typedef struct _PhocOutputStats {
+  gint64             since_us;
+
+  PhocStatsHistogram render_time;
+  PhocStatsHistogram commit_to_present;
+  PhocStatsHistogram frame_callback_latency;
+
+  guint64            composited_frames;
+  guint64            scanned_out_frames;
+  guint64            offloaded_frames;
+  guint64            missed_vblanks;
+
+  guint64            damage_area_sum;
+  guint64            damage_area_max;
+  guint64            damage_rects_in;
+  guint64            damage_rects_out;
+
+  /*< private >*/
+  gint64             first_commit_us;
+  gint64             pending_commit_us;
+  gint64             frame_commit_us;
+  gint64             last_present_us;
+} PhocOutputStats;
+
+void      phoc_output_stats_reset                 (PhocOutputStats    *stats);
+void      phoc_output_stats_add_sample            (PhocStatsHistogram *histogram,
+                                                   gint64              duration_us);
+void      phoc_output_stats_surface_committed     (PhocOutputStats    *stats);
+void      phoc_output_stats_frame_committed       (PhocOutputStats    *stats);
+void      phoc_output_stats_frame_presented       (PhocOutputStats    *stats,
+                                                   gint64              when_us,
+                                                   gint64              refresh_us);
+void      phoc_output_stats_add_damage            (PhocOutputStats    *stats,
+                                                   guint64             area);
+gint64    phoc_output_stats_get_bucket_limit      (guint               bucket);
+GVariant *phoc_output_stats_to_variant            (PhocOutputStats    *stats);
+
+G_END_DECLS
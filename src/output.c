@@ -6,13 +6,17 @@
 #include "anim/animatable.h"
 #include "bling.h"
 #include "cursor.h"
+#include "frame-scheduler.h"
 #include "input-method-relay.h"
 #include "layer-shell-effects.h"
 #include "layer-shell.h"
 #include "layout-transaction.h"
+#include "loop-monitor.h"
 #include "output-cutouts.h"
 #include "output-shield.h"
+#include "output-stats.h"
 #include "output.h"
+#include "phoc-priorities.h"
 #include "render-private.h"
 #include "render.h"
 #include "seat.h"
@@ -29,7 +33,9 @@
 #include <wlr/config.h>
 #include <wlr/render/swapchain.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_alpha_modifier_v1.h>
 #include <wlr/types/wlr_gamma_control_v1.h>
+#include <wlr/types/wlr_output_layer.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_output_power_management_v1.h>
 #include <wlr/types/wlr_xdg_shell.h>
@@ -49,12 +55,21 @@ enum {
 };
 static guint signals[N_SIGNALS];
 
+/* Number of output layers we try to put surfaces on */
+#define PHOC_OUTPUT_MAX_LAYERS 3
+/* Longest time we keep showing the old layout when clients are slow */
+#define PHOC_OUTPUT_FREEZE_TIMEOUT_MS 500
+
 typedef struct _PhocOutputPrivate {
   PhocOutputShield *shield;
 
   GSList *frame_callbacks; /* (element-type: PhocOutputFrameCallbackInfo) */
   gint    frame_callback_next_id;
   gint64  last_frame_us;
+  /* Presentation timeline driving the frame callbacks */
+  gint64  frame_time_us;
+  gint64  last_present_us;
+  gint64  present_refresh_us;
 
   PhocOutputCutouts  *cutouts;
   struct wlr_texture *cutouts_texture;
@@ -66,11 +81,15 @@ typedef struct _PhocOutputPrivate {
   struct wl_listener    frame;
   struct wl_listener    needs_frame;
   struct wl_listener    request_state;
+  struct wl_listener    present;
 
   PhocOutputScaleFilter scale_filter;
   gboolean gamma_lut_changed;
 
   GQueue  *layer_surfaces[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY + 1];
+  /* Arrange order per layer, surfaces with an exclusive zone first */
+  GPtrArray *arrange_surfaces[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY + 1];
+  guint      arrange_n_exclusive[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY + 1];
 
   PhocLayoutTransaction *transaction;
   gboolean modeset_shield;
@@ -78,6 +97,28 @@ typedef struct _PhocOutputPrivate {
   GSList  *blings;          /* (element-type: PhocBling) */
   GSList  *debug_damage;    /* (element-type: PhocDebugDamageRegion) */
 
+  GArray  *render_list;     /* (element-type: PhocRenderEntry) */
+  gboolean render_list_dirty;
+
+  guint32  visibility_mask; /* This output's bit in PhocView's visible outputs */
+
+  gboolean use_output_layers;
+  gboolean output_layers_failed;
+  struct wlr_output_layer       *output_layers[PHOC_OUTPUT_MAX_LAYERS];
+  struct wlr_output_layer_state  layer_states[PHOC_OUTPUT_MAX_LAYERS];
+  GPtrArray *offloaded;     /* (element-type: struct wlr_surface) */
+  gboolean   offloaded_committed;
+  gboolean   render_list_offloaded; /* render list entries are marked */
+
+  PhocFrameScheduler *frame_scheduler;
+  guint               delayed_repaint_id;
+  guint               freeze_timeout_id;
+
+  PhocOutputStats     stats;
+
+  guint               damage_max_rects;
+  float               damage_fill_ratio;
+
   struct wlr_damage_ring damage_ring;
 } PhocOutputPrivate;
 
@@ -117,6 +158,40 @@ typedef struct {
 } PhocOutputSurfaceIteratorData;
 
 
+typedef struct {
+  GArray           *render_list;
+  PhocView         *view;
+  PhocLayerSurface *layer_surface;
+} PhocRenderListBuilder;
+
+
+static void
+phoc_output_thaw (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (!priv->freeze_timeout_id)
+    return;
+
+  g_clear_handle_id (&priv->freeze_timeout_id, g_source_remove);
+  /* Present the new layout at once */
+  phoc_output_damage_whole (self);
+}
+
+
+static void
+on_freeze_timeout (gpointer user_data)
+{
+  PhocOutput *self = PHOC_OUTPUT (user_data);
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  priv->freeze_timeout_id = 0;
+  g_debug ("Clients of %s too slow for layout change, presenting anyway",
+           self->wlr_output->name);
+  phoc_output_damage_whole (self);
+}
+
+
 static void
 on_transaction_active_changed (PhocOutput            *self,
                                GParamSpec            *pspec,
@@ -124,10 +199,12 @@ on_transaction_active_changed (PhocOutput            *self,
 {
   PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
 
-  if (!priv->modeset_shield)
+  if (phoc_layout_transaction_is_active (transaction))
     return;
 
-  if (phoc_layout_transaction_is_active (transaction))
+  phoc_output_thaw (self);
+
+  if (!priv->modeset_shield)
     return;
 
   priv->modeset_shield = FALSE;
@@ -296,11 +373,21 @@ phoc_output_init (PhocOutput *self)
   wl_list_init (&priv->frame.link);
   wl_list_init (&priv->needs_frame.link);
   wl_list_init (&priv->request_state.link);
+  wl_list_init (&priv->present.link);
   wl_list_init (&self->commit.link);
   wl_list_init (&self->output_destroy.link);
 
   priv->scale_filter = PHOC_OUTPUT_SCALE_FILTER_AUTO;
 
+  priv->render_list = g_array_new (FALSE, FALSE, sizeof (PhocRenderEntry));
+  priv->render_list_dirty = TRUE;
+
+  priv->offloaded = g_ptr_array_new ();
+  priv->frame_scheduler = phoc_frame_scheduler_new (0);
+  phoc_output_stats_reset (&priv->stats);
+  priv->damage_max_rects = PHOC_OUTPUT_CONFIG_DAMAGE_MAX_RECTS;
+  priv->damage_fill_ratio = PHOC_OUTPUT_CONFIG_DAMAGE_FILL_RATIO;
+
   g_signal_connect_object (phoc_layout_transaction_get_default (),
                            "notify::active",
                            G_CALLBACK (on_transaction_active_changed),
@@ -339,6 +426,53 @@ update_output_manager_config (PhocDesktop *desktop)
 }
 
 
+/* Make the renderer composite all surfaces again */
+static void
+reset_offloaded (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (priv->render_list_offloaded) {
+    for (guint i = 0; i < priv->render_list->len; i++)
+      g_array_index (priv->render_list, PhocRenderEntry, i).offloaded = FALSE;
+    priv->render_list_offloaded = FALSE;
+  }
+
+  priv->offloaded_committed = FALSE;
+  if (priv->offloaded->len == 0)
+    return;
+
+  g_ptr_array_set_size (priv->offloaded, 0);
+  wlr_damage_ring_add_whole (&priv->damage_ring);
+}
+
+
+static void
+destroy_output_layers (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  for (int i = 0; i < PHOC_OUTPUT_MAX_LAYERS; i++)
+    g_clear_pointer (&priv->output_layers[i], wlr_output_layer_destroy);
+
+  reset_offloaded (self);
+}
+
+/* Take everything off the output layers with the next commit */
+static void
+disable_output_layers (PhocOutput *self, struct wlr_output_state *pending)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (priv->output_layers[0] == NULL)
+    return;
+
+  for (int i = 0; i < PHOC_OUTPUT_MAX_LAYERS; i++)
+    priv->layer_states[i] = (struct wlr_output_layer_state) { .layer = priv->output_layers[i] };
+  wlr_output_state_set_layers (pending, priv->layer_states, PHOC_OUTPUT_MAX_LAYERS);
+}
+
+
 static void
 phoc_output_handle_destroy (struct wl_listener *listener, void *data)
 {
@@ -348,7 +482,12 @@ phoc_output_handle_destroy (struct wl_listener *listener, void *data)
   if (self->fullscreen_view)
     phoc_view_set_fullscreen (self->fullscreen_view, false, NULL);
 
+  destroy_output_layers (self);
+  g_clear_handle_id (&priv->delayed_repaint_id, g_source_remove);
+  g_clear_handle_id (&priv->freeze_timeout_id, g_source_remove);
+
   wl_list_remove (&priv->request_state.link);
+  wl_list_remove (&priv->present.link);
   wl_list_remove (&priv->damage.link);
   wl_list_remove (&priv->frame.link);
   wl_list_remove (&priv->needs_frame.link);
@@ -394,15 +533,24 @@ phoc_output_set_gamma_lut (PhocOutput *self, struct wlr_output_state *pending)
 
 
 static void
-surface_send_frame_done_iterator (PhocOutput         *output,
-                                  struct wlr_surface *wlr_surface,
-                                  struct wlr_box     *box,
-                                  float               scale,
-                                  void               *data)
+send_frame_done (PhocOutput *self, struct timespec *when)
 {
-  struct timespec *when = data;
+  GArray *render_list = phoc_output_get_render_list (self);
+
+  for (guint i = 0; i < render_list->len; i++) {
+    PhocRenderEntry *entry = &g_array_index (render_list, PhocRenderEntry, i);
+
+    PhocSurface *surface;
 
-  wlr_surface_send_frame_done (wlr_surface, when);
+    if (!entry->surface)
+      continue;
+
+    surface = entry->surface->data;
+    if (surface)
+      phoc_surface_send_frame_done (surface, when, FALSE);
+    else
+      wlr_surface_send_frame_done (entry->surface, when);
+  }
 }
 
 
@@ -479,13 +627,214 @@ scan_out_fullscreen_view (PhocOutput *self, PhocView *view, struct wlr_output_st
   if (!wlr_output_is_direct_scanout_allowed (wlr_output))
     return false;
 
+  /* The fullscreen surface covers whatever was on the output layers */
+  disable_output_layers (self, pending);
   wlr_output_state_set_buffer (pending, &wlr_surface->buffer->base);
   if (!wlr_output_test_state (wlr_output, pending))
     return false;
 
   wlr_presentation_surface_scanned_out_on_output (wlr_surface, wlr_output);
 
-  return wlr_output_commit_state (wlr_output, pending);
+  if (!wlr_output_commit_state (wlr_output, pending))
+    return false;
+
+  reset_offloaded (self);
+  return true;
+}
+
+
+static gboolean
+can_use_output_layers (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  PhocServer *server = phoc_server_get_default ();
+  struct wlr_output_cursor *cursor;
+
+  if (priv->output_layers_failed)
+    return FALSE;
+
+  /* Output blings (like the shield) and cutouts are composited on top of everything */
+  if (priv->blings || priv->cutouts_texture)
+    return FALSE;
+
+  if (G_UNLIKELY (phoc_server_check_debug_flags (server,
+                                                 PHOC_SERVER_DEBUG_FLAG_TOUCH_POINTS |
+                                                 PHOC_SERVER_DEBUG_FLAG_DAMAGE_TRACKING))) {
+    return FALSE;
+  }
+
+  /* Software cursors would end up below the layers */
+  wl_list_for_each (cursor, &self->wlr_output->cursors, link) {
+    if (cursor->enabled && cursor->visible && cursor != self->wlr_output->hardware_cursor)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+static gboolean
+can_offload_entry (PhocOutput *self, PhocRenderEntry *entry)
+{
+  struct wlr_surface *surface = entry->surface;
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+
+  if (surface == NULL || surface->buffer == NULL)
+    return FALSE;
+
+  if (entry->view && phoc_view_get_alpha (entry->view) < 1.0)
+    return FALSE;
+
+  if (entry->layer_surface && phoc_layer_surface_get_alpha (entry->layer_surface) < 1.0)
+    return FALSE;
+
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state && alpha_modifier_state->multiplier < 1.0)
+    return FALSE;
+
+  /* Output layers can't rotate so the buffer needs to match the output */
+  if (surface->current.transform != self->wlr_output->transform)
+    return FALSE;
+
+  return TRUE;
+}
+
+
+static gboolean
+offloaded_changed (PhocOutput *self, GPtrArray *offloaded)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (offloaded->len != priv->offloaded->len)
+    return TRUE;
+
+  for (guint i = 0; i < offloaded->len; i++) {
+    if (g_ptr_array_index (offloaded, i) != g_ptr_array_index (priv->offloaded, i))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * offload_to_output_layers:
+ * @self: The output
+ * @pending: The pending output state
+ *
+ * Try to put the topmost surfaces of the render list onto output
+ * layers so they don't need to be composited. As anything we
+ * composite ends up below the output layers only a contiguous range
+ * of surfaces at the top of the stack can be offloaded. Offloaded
+ * render list entries are marked so the renderer skips them.
+ *
+ * Returns: The number of offloaded surfaces
+ */
+PHOC_TRACE_NO_INLINE static guint
+offload_to_output_layers (PhocOutput *self, struct wlr_output_state *pending)
+{
+  gint64 begin_time_nsec G_GNUC_UNUSED = PHOC_TRACE_CURRENT_TIME;
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  PhocRenderEntry *candidates[PHOC_OUTPUT_MAX_LAYERS] = { NULL };
+  g_autoptr (GPtrArray) offloaded = g_ptr_array_new ();
+  guint n_candidates = 0, n_offloaded = 0;
+  GArray *render_list;
+
+  if (!priv->use_output_layers) {
+    reset_offloaded (self);
+    return 0;
+  }
+
+  render_list = phoc_output_get_render_list (self);
+  if (priv->render_list_offloaded) {
+    for (guint i = 0; i < render_list->len; i++)
+      g_array_index (render_list, PhocRenderEntry, i).offloaded = FALSE;
+    priv->render_list_offloaded = FALSE;
+  }
+
+  if (priv->output_layers[0] == NULL) {
+    for (int i = 0; i < PHOC_OUTPUT_MAX_LAYERS; i++)
+      priv->output_layers[i] = wlr_output_layer_create (self->wlr_output);
+  }
+
+  if (can_use_output_layers (self)) {
+    for (int i = render_list->len - 1; i >= 0 && n_candidates < PHOC_OUTPUT_MAX_LAYERS; i--) {
+      PhocRenderEntry *entry = &g_array_index (render_list, PhocRenderEntry, i);
+
+      /* Views without blings don't add anything to the stack */
+      if (entry->surface == NULL && phoc_view_get_blings (entry->view) == NULL)
+        continue;
+
+      if (!can_offload_entry (self, entry))
+        break;
+
+      candidates[n_candidates++] = entry;
+    }
+  }
+  priv->output_layers_failed = FALSE;
+
+  /* Layers are ordered bottom to top, unused layers get disabled */
+  for (guint i = 0; i < PHOC_OUTPUT_MAX_LAYERS; i++) {
+    struct wlr_output_layer_state *state = &priv->layer_states[i];
+    PhocRenderEntry *entry = i < n_candidates ? candidates[n_candidates - 1 - i] : NULL;
+
+    *state = (struct wlr_output_layer_state) { .layer = priv->output_layers[i] };
+    if (entry == NULL)
+      continue;
+
+    state->buffer = &entry->surface->buffer->base;
+    wlr_surface_get_buffer_source_box (entry->surface, &state->src_box);
+    state->dst_box = entry->dst_box;
+  }
+  wlr_output_state_set_layers (pending, priv->layer_states, PHOC_OUTPUT_MAX_LAYERS);
+
+  if (n_candidates && wlr_output_test_state (self->wlr_output, pending)) {
+    for (int i = n_candidates - 1; i >= 0 && priv->layer_states[i].accepted; i--)
+      n_offloaded++;
+  }
+
+  /* Everything below a rejected layer gets composited */
+  for (guint i = 0; i < n_candidates - n_offloaded; i++)
+    priv->layer_states[i].buffer = NULL;
+
+  for (guint i = n_candidates - n_offloaded; i < n_candidates; i++) {
+    PhocRenderEntry *entry = candidates[n_candidates - 1 - i];
+
+    entry->offloaded = TRUE;
+    priv->render_list_offloaded = TRUE;
+    g_ptr_array_add (offloaded, entry->surface);
+    wlr_presentation_surface_scanned_out_on_output (entry->surface, self->wlr_output);
+  }
+
+  /* Composited content below formerly offloaded surfaces needs a repaint */
+  if (offloaded_changed (self, offloaded))
+    wlr_damage_ring_add_whole (&priv->damage_ring);
+
+  g_ptr_array_unref (priv->offloaded);
+  priv->offloaded = g_steal_pointer (&offloaded);
+
+#ifdef PHOC_USE_SYSPROF
+  {
+    g_autoptr (GString) names = g_string_new (NULL);
+
+    for (guint i = 0; i < n_offloaded; i++) {
+      PhocRenderEntry *entry = candidates[i];
+      const char *name = NULL;
+
+      if (entry->view)
+        name = phoc_view_get_app_id (entry->view);
+      else if (entry->layer_surface)
+        name = phoc_layer_surface_get_namespace (entry->layer_surface);
+
+      g_string_append_printf (names, "%s%s", i ? ", " : "", name ?: "unknown");
+    }
+
+    phoc_trace_mark (begin_time_nsec, PHOC_TRACE_CURRENT_TIME - begin_time_nsec, "phoc", __func__,
+                     "Offloaded %u of %u surfaces on %s: %s", n_offloaded, n_candidates,
+                     self->wlr_output->name, names->str);
+  }
+#endif
+
+  return n_offloaded;
 }
 
 
@@ -553,13 +902,38 @@ render_cutouts (PhocOutput *self, PhocRenderContext *ctx)
 }
 
 
-PHOC_TRACE_NO_INLINE static void
+static void
+handle_output_layers_failed (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  g_debug ("Committing output layers on %s failed, compositing next frame",
+           self->wlr_output->name);
+  /* Composite everything on the next frame */
+  priv->output_layers_failed = TRUE;
+  reset_offloaded (self);
+  wlr_damage_ring_add_whole (&priv->damage_ring);
+  wlr_output_schedule_frame (self->wlr_output);
+}
+
+
+/**
+ * phoc_output_draw:
+ * @self: The output
+ *
+ * Repaints the output if needed.
+ *
+ * Returns: %TRUE if the output contents got composited
+ */
+PHOC_TRACE_NO_INLINE static gboolean
 phoc_output_draw (PhocOutput *self)
 {
   PhocServer *server = phoc_server_get_default ();
   PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
   struct wlr_output *wlr_output = self->wlr_output;
   bool needs_frame, scanned_out = false;
+  gboolean composited = FALSE;
+  gint64 render_start_us = 0;
   pixman_region32_t buffer_damage;
   PhocRenderContext render_context;
   struct wlr_buffer *buffer;
@@ -568,14 +942,21 @@ phoc_output_draw (PhocOutput *self)
   PhocServerDebugFlags flags;
 
   if (!wlr_output->enabled)
-    return;
+    return FALSE;
+
+  /* Views that became visible add their damage so do this before
+   * looking at the damage ring */
+  phoc_desktop_update_visibility (phoc_server_get_desktop (server));
 
   needs_frame = wlr_output->needs_frame;
   needs_frame |= pixman_region32_not_empty (&priv->damage_ring.current);
   needs_frame |= priv->gamma_lut_changed;
+  needs_frame |= priv->offloaded_committed;
 
   if (!needs_frame)
-    return;
+    return FALSE;
+
+  priv->offloaded_committed = FALSE;
 
   if (G_UNLIKELY (priv->gamma_lut_changed))
     phoc_output_set_gamma_lut (self, &pending);
@@ -586,12 +967,34 @@ phoc_output_draw (PhocOutput *self)
   if (self->fullscreen_view)
     scanned_out = scan_out_fullscreen_view (self, self->fullscreen_view, &pending);
 
-  if (scanned_out)
+  if (scanned_out) {
+    priv->stats.scanned_out_frames++;
+    phoc_output_stats_frame_committed (&priv->stats);
     goto out;
+  }
+
+  /* Check if we can put surfaces on output layers */
+  if (offload_to_output_layers (self, &pending)) {
+    priv->stats.offloaded_frames++;
+    if (pixman_region32_empty (&priv->damage_ring.current) && !wlr_output->needs_frame) {
+      /* Only the output layers changed, keep the current primary buffer */
+      if (wlr_output_commit_state (wlr_output, &pending))
+        phoc_output_stats_frame_committed (&priv->stats);
+      else
+        handle_output_layers_failed (self);
+      goto out;
+    }
+  }
+  /* Changes in the set of offloaded surfaces can add damage */
+  wlr_output_state_set_damage (&pending, &priv->damage_ring.current);
 
+  render_start_us = g_get_monotonic_time ();
   if (!wlr_output_configure_primary_swapchain (wlr_output, &pending, &wlr_output->swapchain))
     goto out;
 
+  /* Offscreen rendering must not happen within the output's render pass */
+  phoc_renderer_update_view_caches (phoc_server_get_renderer (server), self);
+
   buffer = wlr_swapchain_acquire (wlr_output->swapchain);
   if (!buffer)
     goto out;
@@ -604,6 +1007,7 @@ phoc_output_draw (PhocOutput *self)
 
   pixman_region32_init (&buffer_damage);
   wlr_damage_ring_rotate_buffer (&priv->damage_ring, buffer, &buffer_damage);
+  phoc_output_stats_add_damage (&priv->stats, phoc_utils_region_area (&buffer_damage));
 
   render_context = (PhocRenderContext){
     .output = self,
@@ -623,11 +1027,21 @@ phoc_output_draw (PhocOutput *self)
     goto out;
   }
 
+  phoc_output_stats_add_sample (&priv->stats.render_time,
+                                g_get_monotonic_time () - render_start_us);
+
   wlr_output_state_set_buffer (&pending, buffer);
   wlr_buffer_unlock (buffer);
 
-  if (!wlr_output_commit_state (wlr_output, &pending))
+  if (!wlr_output_commit_state (wlr_output, &pending)) {
+    if (priv->offloaded->len)
+      handle_output_layers_failed (self);
     goto out;
+  }
+
+  composited = TRUE;
+  priv->stats.composited_frames++;
+  phoc_output_stats_frame_committed (&priv->stats);
 
  out:
   wlr_output_state_finish (&pending);
@@ -635,6 +1049,112 @@ phoc_output_draw (PhocOutput *self)
   flags = phoc_server_get_debug_flags (server);
   if (G_UNLIKELY (flags & PHOC_SERVER_DEBUG_FLAG_DAMAGE_WHOLE))
     phoc_output_damage_whole (self);
+
+  return composited;
+}
+
+
+static gint64
+get_refresh_us (PhocOutput *self)
+{
+  struct wlr_output *wlr_output = self->wlr_output;
+
+  /* No fixed deadline with VRR */
+  if (wlr_output->refresh <= 0 ||
+      wlr_output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED) {
+    return 0;
+  }
+
+  /* refresh is in mHz */
+  return 1000000000 / wlr_output->refresh;
+}
+
+
+static void
+schedule_next_frame (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  /* Want frame clock ticking as long as we have frame callbacks */
+  if (priv->frame_callbacks)
+    wlr_output_schedule_frame (self->wlr_output);
+
+  /* Need to redraw until all debug damage faded out */
+  if (priv->debug_damage)
+    wlr_output_schedule_frame (self->wlr_output);
+}
+
+
+static gboolean
+on_delayed_repaint (gpointer data)
+{
+  PhocOutput *self = PHOC_OUTPUT (data);
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  gint64 start_us, done_us;
+
+  priv->delayed_repaint_id = 0;
+
+  /* Frame done was already sent to clients when scheduling the repaint */
+  if (G_UNLIKELY (priv->freeze_timeout_id)) {
+    schedule_next_frame (self);
+    return G_SOURCE_REMOVE;
+  }
+
+  start_us = g_get_monotonic_time ();
+  if (phoc_output_draw (self)) {
+    done_us = g_get_monotonic_time ();
+
+    phoc_loop_monitor_add_sample (phoc_loop_monitor_get_default (), NULL, done_us - start_us);
+    phoc_trace_mark (start_us * 1000, (done_us - start_us) * 1000, "phoc", __func__,
+                     "Delayed repaint of %s, %" G_GINT64_FORMAT "us after frame event",
+                     self->wlr_output->name, start_us - priv->last_frame_us);
+
+    /* Fall back to immediate repaints when we were too late */
+    if (!phoc_frame_scheduler_check_missed (priv->frame_scheduler, priv->last_frame_us, done_us,
+                                            get_refresh_us (self))) {
+      phoc_frame_scheduler_add_render_time (priv->frame_scheduler, done_us - start_us);
+    }
+  }
+
+  schedule_next_frame (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+/**
+ * predict_presentation_time:
+ * @self: The output
+ *
+ * Predicts when the frame that is about to be rendered will show up
+ * on screen. This is the next vblank after now based on the last
+ * presentation feedback and the refresh period. Without a fixed
+ * refresh rate (e.g. VRR) the frame is shown as soon as it's ready.
+ *
+ * Returns: The predicted presentation time in monotonic microseconds
+ */
+static gint64
+predict_presentation_time (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  gint64 now_us = g_get_monotonic_time ();
+  gint64 refresh_us, target_us;
+
+  refresh_us = get_refresh_us (self);
+  if (refresh_us > 0 && priv->present_refresh_us > 0)
+    refresh_us = priv->present_refresh_us;
+
+  if (refresh_us <= 0 || priv->last_present_us == 0 || priv->last_present_us > now_us)
+    return MAX (now_us, priv->frame_time_us);
+
+  target_us = priv->last_present_us +
+    ((now_us - priv->last_present_us) / refresh_us + 1) * refresh_us;
+
+  /* Two frame events within one refresh cycle target different vblanks */
+  if (target_us <= priv->frame_time_us)
+    target_us = priv->frame_time_us + refresh_us;
+
+  return target_us;
 }
 
 
@@ -644,15 +1164,21 @@ phoc_output_handle_frame (struct wl_listener *listener, void *data)
   PhocOutputPrivate *priv = wl_container_of (listener, priv, frame);
   PhocOutput *self = PHOC_OUTPUT_SELF (priv);
   struct timespec now;
+  gint64 delay_us, start_us;
+
+  /* Client updates are picked up by the already scheduled repaint */
+  if (priv->delayed_repaint_id)
+    return;
 
   /* Process all registered frame callbacks */
+  priv->frame_time_us = predict_presentation_time (self);
   GSList *l = priv->frame_callbacks;
   while (l != NULL) {
     GSList *next = l->next;
     PhocOutputFrameCallbackInfo *cb_info = l->data;
     gboolean ret;
 
-    ret = cb_info->callback (cb_info->animatable, priv->last_frame_us, cb_info->user_data);
+    ret = cb_info->callback (cb_info->animatable, priv->frame_time_us, cb_info->user_data);
     if (ret == G_SOURCE_REMOVE) {
       phoc_output_frame_callback_info_free (cb_info);
       priv->frame_callbacks = g_slist_delete_link (priv->frame_callbacks, l);
@@ -667,22 +1193,73 @@ phoc_output_handle_frame (struct wl_listener *listener, void *data)
     phoc_output_damage_box (self, &box);
   }
 
+  /* Keep the last consistent frame on screen but let clients catch up
+   * with the layout change. Clients on other outputs don't hold us back. */
+  if (G_UNLIKELY (priv->freeze_timeout_id)) {
+    if (phoc_layout_transaction_is_pending_on_output (phoc_layout_transaction_get_default (),
+                                                      self)) {
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      send_frame_done (self, &now);
+      schedule_next_frame (self);
+      return;
+    }
+    phoc_output_thaw (self);
+  }
+
   build_debug_damage_tracking (self);
 
+  delay_us = phoc_frame_scheduler_get_delay (priv->frame_scheduler, get_refresh_us (self));
+  if (delay_us > 0) {
+    /* Let clients render while we wait so their updates make it into this frame */
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    send_frame_done (self, &now);
+    phoc_output_stats_add_sample (&priv->stats.frame_callback_latency,
+                                  g_get_monotonic_time () - priv->last_frame_us);
+
+    priv->delayed_repaint_id = g_timeout_add_full (PHOC_PRIORITY_INTERACTIVE,
+                                                   delay_us / 1000,
+                                                   on_delayed_repaint,
+                                                   self,
+                                                   NULL);
+    g_source_set_name_by_id (priv->delayed_repaint_id, "[phoc] delayed repaint");
+    return;
+  }
+
   /* Repaint the output */
-  phoc_output_draw (self);
+  start_us = g_get_monotonic_time ();
+  if (phoc_output_draw (self)) {
+    phoc_frame_scheduler_add_render_time (priv->frame_scheduler,
+                                          g_get_monotonic_time () - start_us);
+  }
 
   /* Send frame done events to all visible surfaces */
   clock_gettime (CLOCK_MONOTONIC, &now);
-  phoc_output_for_each_surface (self, surface_send_frame_done_iterator, &now, true);
+  send_frame_done (self, &now);
+  phoc_output_stats_add_sample (&priv->stats.frame_callback_latency,
+                                g_get_monotonic_time () - priv->last_frame_us);
 
-  /* Want frame clock ticking as long as we have frame callbacks */
-  if (priv->frame_callbacks)
-    wlr_output_schedule_frame (self->wlr_output);
+  schedule_next_frame (self);
+}
 
-  /* Need to redraw until all debug damage faded out */
-  if (priv->debug_damage)
-    wlr_output_schedule_frame (self->wlr_output);
+
+static void
+phoc_output_handle_present (struct wl_listener *listener, void *data)
+{
+  PhocOutputPrivate *priv = wl_container_of (listener, priv, present);
+  PhocOutput *self = PHOC_OUTPUT_SELF (priv);
+  struct wlr_output_event_present *event = data;
+  gint64 when_us, refresh_us;
+
+  if (!event->presented || event->when.tv_sec == 0)
+    return;
+
+  when_us = event->when.tv_sec * G_USEC_PER_SEC + event->when.tv_nsec / 1000;
+  refresh_us = event->refresh ? event->refresh / 1000 : get_refresh_us (self);
+  phoc_output_stats_frame_presented (&priv->stats, when_us, refresh_us);
+
+  /* Anchor the frame callback timeline to the actual vblanks */
+  priv->last_present_us = when_us;
+  priv->present_refresh_us = event->refresh / 1000;
 }
 
 
@@ -913,6 +1490,14 @@ phoc_output_fill_state (PhocOutput              *self,
     wlr_output_state_set_transform (pending, transform);
     priv->scale_filter = output_config->scale_filter;
 
+    priv->use_output_layers = output_config->output_layers;
+    if (!priv->use_output_layers)
+      destroy_output_layers (self);
+
+    phoc_frame_scheduler_set_margin (priv->frame_scheduler, output_config->render_margin * 1000);
+    priv->damage_max_rects = output_config->damage_max_rects;
+    priv->damage_fill_ratio = output_config->damage_fill_ratio;
+
     if (output_config->adaptive_sync != PHOC_OUTPUT_ADAPTIVE_SYNC_NONE &&
         self->wlr_output->adaptive_sync_supported) {
       bool enabled = output_config->adaptive_sync == PHOC_OUTPUT_ADAPTIVE_SYNC_ENABLED;
@@ -1008,6 +1593,26 @@ on_server_debug_flags_changed (PhocOutput *self, GParamSpec *pspec, PhocServer *
 }
 
 
+static guint32
+allocate_visibility_mask (PhocDesktop *desktop)
+{
+  PhocOutput *output;
+  guint32 used = 0;
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    used |= phoc_output_get_visibility_mask (output);
+
+  for (guint i = 0; i < 32; i++) {
+    if (!(used & (1u << i)))
+      return 1u << i;
+  }
+
+  /* Sharing a bit only makes the visibility tracking more pessimistic */
+  g_warning ("Too many outputs, sharing visibility mask");
+  return 1u << 31;
+}
+
+
 static gboolean
 phoc_output_initable_init (GInitable    *initable,
                            GCancellable *cancellable,
@@ -1024,7 +1629,9 @@ phoc_output_initable_init (GInitable    *initable,
   struct wlr_output_state pending;
 
   self->wlr_output->data = self;
+  priv->visibility_mask = allocate_visibility_mask (desktop);
   wl_list_insert (&desktop->outputs, &self->link);
+  phoc_desktop_invalidate_visibility (desktop);
 
   if (!wlr_output_init_render (self->wlr_output,
                                phoc_renderer_get_wlr_allocator (renderer),
@@ -1056,6 +1663,9 @@ phoc_output_initable_init (GInitable    *initable,
   priv->request_state.notify = handle_request_state;
   wl_signal_add (&self->wlr_output->events.request_state, &priv->request_state);
 
+  priv->present.notify = phoc_output_handle_present;
+  wl_signal_add (&self->wlr_output->events.present, &priv->present);
+
   output_config = phoc_config_get_output (config, self);
   /* Restore old output state if any */
   if (output_config) {
@@ -1123,6 +1733,7 @@ phoc_output_finalize (GObject *object)
   self->wlr_output = NULL;
 
   wl_list_remove (&self->link);
+  phoc_desktop_invalidate_visibility (desktop);
 
   update_output_manager_config (desktop);
 
@@ -1133,8 +1744,14 @@ phoc_output_finalize (GObject *object)
                  (GDestroyNotify)phoc_output_frame_callback_info_free);
 
   wl_list_init (&self->layer_surfaces);
-  for (int i = 0; i < G_N_ELEMENTS (priv->layer_surfaces); i++)
+  for (int i = 0; i < G_N_ELEMENTS (priv->layer_surfaces); i++) {
     g_clear_pointer (&priv->layer_surfaces[i], g_queue_free);
+    g_clear_pointer (&priv->arrange_surfaces[i], g_ptr_array_unref);
+  }
+
+  g_clear_pointer (&priv->render_list, g_array_unref);
+  g_clear_pointer (&priv->offloaded, g_ptr_array_unref);
+  g_clear_object (&priv->frame_scheduler);
 
   phoc_output_enable_render_cutouts (self, FALSE);
 
@@ -1546,6 +2163,314 @@ phoc_output_set_layer_dirty (PhocOutput *self, enum zwlr_layer_shell_v1_layer la
   priv = phoc_output_get_instance_private (self);
 
   g_clear_pointer (&priv->layer_surfaces[layer], g_queue_free);
+  g_clear_pointer (&priv->arrange_surfaces[layer], g_ptr_array_unref);
+  priv->render_list_dirty = TRUE;
+}
+
+/**
+ * phoc_output_freeze:
+ * @self: the output
+ *
+ * Keep presenting the current frame while clients on this output
+ * take part in the layout transaction so clients that already resized
+ * for a layout change aren't shown next to ones that didn't. Once
+ * they all committed, or after a timeout, the new layout is presented
+ * at once.
+ */
+void
+phoc_output_freeze (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  if (priv->freeze_timeout_id || !self->wlr_output->enabled)
+    return;
+
+  if (!phoc_layout_transaction_is_pending_on_output (phoc_layout_transaction_get_default (), self))
+    return;
+
+  g_debug ("Freezing %s for layout change", self->wlr_output->name);
+  priv->freeze_timeout_id = g_timeout_add_once (PHOC_OUTPUT_FREEZE_TIMEOUT_MS,
+                                                on_freeze_timeout,
+                                                self);
+  g_source_set_name_by_id (priv->freeze_timeout_id, "[phoc] output freeze timeout");
+}
+
+/**
+ * phoc_output_get_layer_surfaces_for_arrange:
+ * @self: the output
+ * @layer: The layer to get the surfaces for
+ * @n_exclusive: (out): Return location for the number of surfaces with
+ *   an exclusive zone
+ *
+ * Get the [type@PhocLayerSurface]s on this output in the given `layer`
+ * in the order they need to be arranged. The first `n_exclusive`
+ * surfaces have an exclusive zone, the others don't. Like
+ * [method@Output.get_layer_surfaces_for_layer] the result is cached
+ * until the layer is marked dirty.
+ *
+ * Returns:(transfer none)(element-type PhocLayerSurface): The layer surfaces
+ */
+GPtrArray *
+phoc_output_get_layer_surfaces_for_arrange (PhocOutput                     *self,
+                                            enum zwlr_layer_shell_v1_layer  layer,
+                                            guint                          *n_exclusive)
+{
+  PhocLayerSurface *layer_surface;
+  PhocOutputPrivate *priv;
+  GPtrArray *surfaces;
+  guint n = 0;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  g_assert (n_exclusive);
+  priv = phoc_output_get_instance_private (self);
+
+  if (priv->arrange_surfaces[layer]) {
+    *n_exclusive = priv->arrange_n_exclusive[layer];
+    return priv->arrange_surfaces[layer];
+  }
+
+  surfaces = g_ptr_array_new ();
+  wl_list_for_each_reverse (layer_surface, &self->layer_surfaces, link) {
+    if (layer_surface->layer != layer)
+      continue;
+
+    if (layer_surface->layer_surface->current.exclusive_zone > 0)
+      g_ptr_array_insert (surfaces, n++, layer_surface);
+    else
+      g_ptr_array_add (surfaces, layer_surface);
+  }
+
+  priv->arrange_surfaces[layer] = surfaces;
+  priv->arrange_n_exclusive[layer] = n;
+  *n_exclusive = n;
+  return surfaces;
+}
+
+
+static void
+add_render_entry_iterator (PhocOutput         *self,
+                           struct wlr_surface *wlr_surface,
+                           struct wlr_box     *box,
+                           float               scale,
+                           void               *user_data)
+{
+  PhocRenderListBuilder *builder = user_data;
+  PhocRenderEntry entry = {
+    .surface = wlr_surface,
+    .view = builder->view,
+    .layer_surface = builder->layer_surface,
+    .box = *box,
+    .dst_box = *box,
+    .scale = scale,
+  };
+
+  phoc_utils_scale_box (&entry.dst_box, scale);
+  phoc_utils_scale_box (&entry.dst_box, self->wlr_output->scale);
+  phoc_output_transform_box (self, &entry.dst_box);
+
+  g_array_append_val (builder->render_list, entry);
+}
+
+
+static void
+add_view_to_render_list (PhocOutput *self, PhocView *view, PhocRenderListBuilder *builder)
+{
+  /*  Do not render views fullscreened on other outputs */
+  if (phoc_view_is_fullscreen (view) && phoc_view_get_fullscreen_output (view) != self)
+    return;
+
+  if (!phoc_view_is_fullscreen (view)) {
+    PhocRenderEntry blings = { .view = view };
+
+    g_array_append_val (builder->render_list, blings);
+  }
+
+  builder->view = view;
+  phoc_output_view_for_each_surface (self, view, add_render_entry_iterator, builder);
+  builder->view = NULL;
+}
+
+
+static void
+add_layer_to_render_list (PhocOutput                     *self,
+                          enum zwlr_layer_shell_v1_layer  layer,
+                          PhocRenderListBuilder          *builder)
+{
+  GQueue *layer_surfaces = phoc_output_get_layer_surfaces_for_layer (self, layer);
+
+  for (GList *l = layer_surfaces->head; l; l = l->next) {
+    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
+
+    builder->layer_surface = layer_surface;
+    phoc_output_layer_surface_for_each_surface (self,
+                                                layer_surface,
+                                                add_render_entry_iterator,
+                                                builder);
+  }
+  builder->layer_surface = NULL;
+}
+
+
+PHOC_TRACE_NO_INLINE static void
+build_render_list (PhocOutput *self)
+{
+  PhocServer *server = phoc_server_get_default ();
+  PhocDesktop *desktop = phoc_server_get_desktop (server);
+  PhocWorkspace *workspace = phoc_desktop_get_active_workspace (desktop);
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  PhocRenderListBuilder builder = { .render_list = priv->render_list };
+
+  g_array_set_size (priv->render_list, 0);
+
+  if (self->fullscreen_view && phoc_workspace_has_view (workspace, self->fullscreen_view)) {
+    PhocView *view = self->fullscreen_view;
+
+    add_view_to_render_list (self, view, &builder);
+
+    /* During normal rendering the xwayland window tree isn't traversed
+     * because all windows are rendered. Here we only want to render
+     * the fullscreen window's children so we have to traverse the tree. */
+#ifdef PHOC_XWAYLAND
+    if (PHOC_IS_XWAYLAND_SURFACE (view)) {
+      struct wlr_xwayland_surface *xsurface =
+        phoc_xwayland_surface_get_wlr_surface (PHOC_XWAYLAND_SURFACE (view));
+
+      builder.view = view;
+      phoc_output_xwayland_children_for_each_surface (self,
+                                                      xsurface,
+                                                      add_render_entry_iterator,
+                                                      &builder);
+      builder.view = NULL;
+    }
+#endif
+
+    /* Top layer above fullscreen view when requested */
+    if (phoc_output_has_shell_revealed (self))
+      add_layer_to_render_list (self, ZWLR_LAYER_SHELL_V1_LAYER_TOP, &builder);
+  } else {
+    /* Background and bottom layers under views */
+    add_layer_to_render_list (self, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, &builder);
+    add_layer_to_render_list (self, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, &builder);
+
+    for (GList *l = phoc_workspace_get_views (workspace)->tail; l; l = l->prev) {
+      PhocView *view = PHOC_VIEW (l->data);
+
+      if (phoc_desktop_view_check_output_visibility (desktop, view, self))
+        add_view_to_render_list (self, view, &builder);
+    }
+
+    /* Unmanaged XWayland surfaces */
+    for (GList *l = phoc_workspace_get_unmanaged (workspace)->tail; l; l = l->prev) {
+      PhocXWaylandUnmanaged *unmanaged = PHOC_XWAYLAND_UNMANAGED (l->data);
+
+      phoc_output_unmanaged_for_each_surface (self,
+                                              unmanaged,
+                                              add_render_entry_iterator,
+                                              &builder);
+    }
+
+    /* Top layer above views */
+    add_layer_to_render_list (self, ZWLR_LAYER_SHELL_V1_LAYER_TOP, &builder);
+  }
+
+  phoc_output_drag_icons_for_each_surface (self,
+                                           phoc_server_get_input (server),
+                                           add_render_entry_iterator,
+                                           &builder);
+
+  add_layer_to_render_list (self, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, &builder);
+
+  priv->render_list_dirty = FALSE;
+}
+
+/**
+ * phoc_output_get_stats:
+ * @self: The output
+ *
+ * Get statistics about the output's frames.
+ *
+ * Returns: (transfer none): The output's stats
+ */
+PhocOutputStats *
+phoc_output_get_stats (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  return &priv->stats;
+}
+
+/**
+ * phoc_output_get_render_list:
+ * @self: the output
+ *
+ * Get the flat list of surfaces visible on this output in paint
+ * order (bottom most first). The list is cached and only rebuilt
+ * after it got invalidated via [method@Output.invalidate_render_list]
+ * so walking it is cheap and doesn't depend on the depth of the
+ * surface trees.
+ *
+ * Returns:(transfer none)(element-type PhocRenderEntry): The render list
+ */
+GArray *
+phoc_output_get_render_list (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  if (priv->render_list_dirty)
+    build_render_list (self);
+
+  return priv->render_list;
+}
+
+/**
+ * phoc_output_invalidate_render_list:
+ * @self: the output
+ *
+ * Invalidate the output's render list. This needs to be invoked
+ * whenever surfaces get (un)mapped, restacked, moved or resized. The
+ * list is rebuilt on next access.
+ */
+void
+phoc_output_invalidate_render_list (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  priv->render_list_dirty = TRUE;
+
+  /* Whatever changed the stack might also change what's occluded */
+  phoc_desktop_invalidate_visibility (phoc_server_get_desktop (phoc_server_get_default ()));
+}
+
+/**
+ * phoc_output_get_visibility_mask:
+ * @self: the output
+ *
+ * Get the bit representing this output in a view's visible outputs.
+ * See [method@View.get_visible_outputs].
+ *
+ * Returns: The output's visibility mask
+ */
+guint32
+phoc_output_get_visibility_mask (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  return priv->visibility_mask;
 }
 
 /**
@@ -1598,7 +2523,7 @@ for_each_view_surface_iter (PhocDesktop *desktop, PhocView *view, gpointer user_
 {
   struct for_each_surface_data *data = user_data;
 
-  if (!data->visible_only || phoc_desktop_view_check_visibility (desktop, view))
+  if (!data->visible_only || phoc_desktop_view_check_output_visibility (desktop, view, data->output))
     phoc_output_view_for_each_surface (data->output, view, data->iterator, data->user_data);
 
   return TRUE;
@@ -1685,6 +2610,8 @@ phoc_output_damage_whole (PhocOutput *self)
   if (self == NULL || self->wlr_output == NULL)
     return;
 
+  phoc_output_invalidate_render_list (self);
+
   wlr_output_transformed_resolution (self->wlr_output, &width, &height);
   pixman_region32_init_rect (&damage, 0, 0, width, height);
   phoc_output_damage_region (self, &damage);
@@ -1699,7 +2626,7 @@ phoc_view_accept_damage (PhocOutput *self, PhocView  *view)
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
 
-  if (!phoc_desktop_view_check_visibility (desktop, view))
+  if (!phoc_desktop_view_check_output_visibility (desktop, view, self))
     return false;
 
   if (self->fullscreen_view == NULL)
@@ -1726,6 +2653,7 @@ damage_surface_iterator (PhocOutput         *self,
                          float               scale,
                          void               *data)
 {
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
   bool *whole = data;
   PhocSurface *surface = wlr_surface->data;
 
@@ -1740,6 +2668,11 @@ damage_surface_iterator (PhocOutput         *self,
   pixman_region32_union (&damage, &damage, phoc_surface_get_damage (surface));
   phoc_surface_clear_damage (surface);
 
+  /* Bound the cost of clients sending lots of tiny damage rects */
+  priv->stats.damage_rects_in += pixman_region32_n_rects (&damage);
+  phoc_utils_region_simplify (&damage, priv->damage_max_rects, priv->damage_fill_ratio);
+  priv->stats.damage_rects_out += pixman_region32_n_rects (&damage);
+
   wlr_region_scale (&damage, &damage, scale);
   wlr_region_scale (&damage, &damage, self->wlr_output->scale);
   if (ceil (self->wlr_output->scale) > wlr_surface->current.scale) {
@@ -1749,7 +2682,17 @@ damage_surface_iterator (PhocOutput         *self,
   }
 
   pixman_region32_translate (&damage, box.x, box.y);
-  phoc_output_damage_region (self, &damage);
+  if (pixman_region32_not_empty (&damage))
+    phoc_output_stats_surface_committed (&priv->stats);
+
+  /* Content updates of offloaded surfaces don't need compositing */
+  if (G_LIKELY (!g_ptr_array_find (priv->offloaded, wlr_surface, NULL))) {
+    phoc_output_damage_region (self, &damage);
+  } else if (pixman_region32_not_empty (&damage)) {
+    /* The output layer needs to pick up the new buffer */
+    priv->offloaded_committed = TRUE;
+    wlr_output_schedule_frame (self->wlr_output);
+  }
   pixman_region32_fini (&damage);
 
   if (*whole)
@@ -1798,6 +2741,9 @@ damage_view_blings (PhocOutput *self, PhocView  *view)
 void
 phoc_output_damage_from_view (PhocOutput *self, PhocView *view, bool whole)
 {
+  if (whole)
+    phoc_output_invalidate_render_list (self);
+
   if (!phoc_view_accept_damage (self, view))
     return;
 
@@ -1807,6 +2753,42 @@ phoc_output_damage_from_view (PhocOutput *self, PhocView *view, bool whole)
   phoc_output_view_for_each_surface (self, view, damage_surface_iterator, &whole);
 }
 
+/**
+ * phoc_output_damage_from_view_surface:
+ * @self: The output to add damage to
+ * @view: The view the surface belongs to
+ * @wlr_surface: A surface in the view's surface tree
+ * @sx: x coordinate of the surface relative to the view
+ * @sy: y coordinate of the surface relative to the view
+ *
+ * Adds the damage of a single surface of a [type@PhocView] to the
+ * damaged area of @self. This is cheaper than
+ * [method@Output.damage_from_view] when only one surface committed.
+ */
+void
+phoc_output_damage_from_view_surface (PhocOutput         *self,
+                                      PhocView           *view,
+                                      struct wlr_surface *wlr_surface,
+                                      int                 sx,
+                                      int                 sy)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  struct wlr_box output_box;
+
+  if (!phoc_view_accept_damage (self, view))
+    return;
+
+  wlr_output_layout_get_box (desktop->layout, self->wlr_output, &output_box);
+  if (wlr_box_empty (&output_box))
+    return;
+
+  phoc_output_damage_from_single_surface (self,
+                                          wlr_surface,
+                                          view->box.x - output_box.x + sx,
+                                          view->box.y - output_box.y + sy,
+                                          phoc_view_get_scale (view));
+}
+
 /**
  * phoc_output_damage_from_layer_surface:
  * @self: The output to add damage to
@@ -1822,6 +2804,9 @@ phoc_output_damage_from_layer_surface (PhocOutput       *self,
                                        PhocLayerSurface *layer_surface,
                                        gboolean          whole)
 {
+  if (whole)
+    phoc_output_invalidate_render_list (self);
+
   phoc_output_layer_surface_for_each_surface (self, layer_surface, damage_surface_iterator, &whole);
 }
 
@@ -1838,6 +2823,8 @@ phoc_output_damage_from_drag_icon (PhocOutput *self, PhocDragIcon *icon)
 {
   bool whole = true;
 
+  phoc_output_invalidate_render_list (self);
+
   phoc_output_surface_for_each_surface (self,
                                         phoc_drag_icon_get_wlr_surface (icon),
                                         phoc_drag_icon_get_x (icon),
@@ -1865,10 +2852,48 @@ phoc_output_damage_from_surface (PhocOutput         *self,
                                  gboolean            whole)
 
 {
+  if (whole)
+    phoc_output_invalidate_render_list (self);
+
   phoc_output_surface_for_each_surface (self, wlr_surface, ox, oy,
                                         damage_surface_iterator, &whole);
 }
 
+/**
+ * phoc_output_damage_from_single_surface:
+ * @self: The output to add damage to
+ * @wlr_surface: The wlr_surface providing the damage
+ * @ox: x coordinate of the surface in output local coordinates
+ * @oy: y coordinate of the surface in output local coordinates
+ * @scale: The scale of the surface's root (e.g. the view's scale)
+ *
+ * Adds a surface's damage to the damaged area of @self. Unlike
+ * [method@Output.damage_from_surface] this doesn't look at the
+ * surface's subsurfaces so the cost doesn't depend on the size of the
+ * surface tree. Used when a single surface of a tree committed.
+ */
+void
+phoc_output_damage_from_single_surface (PhocOutput         *self,
+                                        struct wlr_surface *wlr_surface,
+                                        double              ox,
+                                        double              oy,
+                                        float               scale)
+{
+  PhocOutputSurfaceIteratorData data = {
+    .output = self,
+    .ox = ox,
+    .oy = oy,
+    .scale = scale,
+  };
+  struct wlr_box box;
+  bool whole = false;
+
+  if (!get_surface_box (&data, wlr_surface, 0, 0, &box))
+    return;
+
+  damage_surface_iterator (self, wlr_surface, &box, scale, &whole);
+}
+
 /**
  * phoc_output_damage_region:
  * @self: The output
@@ -1956,6 +2981,10 @@ phoc_output_config_head_to_output_config (PhocOutput
   oc->transform = head->state.transform;
   oc->scale = adjust_frac_scale (head->state.scale);
   oc->scale_filter = priv->scale_filter;
+  oc->output_layers = priv->use_output_layers;
+  oc->render_margin = phoc_frame_scheduler_get_margin (priv->frame_scheduler) / 1000.0;
+  oc->damage_max_rects = priv->damage_max_rects;
+  oc->damage_fill_ratio = priv->damage_fill_ratio;
 
   if (self->wlr_output->adaptive_sync_supported) {
     if (head->state.adaptive_sync_enabled)
@@ -2,6 +2,7 @@
 
 #include "animatable.h"
 #include "drag-icon.h"
+#include "output-stats.h"
 #include "phoc-animation.h"
 #include "render.h"
 #include "view.h"
@@ -73,6 +74,30 @@ struct _PhocOutput {
   struct wl_listener        output_destroy;
 };
 
+/**
+ * PhocRenderEntry:
+ * @surface: (nullable): The surface to render or %NULL if this entry
+ *    marks the position of @view's blings in the stack
+ * @view: (nullable): The view the surface belongs to
+ * @layer_surface: (nullable): The layer surface the surface belongs to
+ * @box: The surface's box in output local coordinates
+ * @dst_box: The surface's box in output buffer coordinates
+ * @scale: The `scale-to-fit` scale
+ * @offloaded: Whether the surface is currently put on an output layer
+ *    and hence skipped when compositing
+ *
+ * An entry in an output's render list. See [method@Output.get_render_list].
+ */
+typedef struct {
+  struct wlr_surface *surface;
+  PhocView           *view;
+  PhocLayerSurface   *layer_surface;
+  struct wlr_box      box;
+  struct wlr_box      dst_box;
+  float               scale;
+  gboolean            offloaded;
+} PhocRenderEntry;
+
 PhocOutput *phoc_output_new (struct wlr_output *wlr_output, GError **error);
 /**
  * PhocSurfaceIterator:
@@ -133,6 +158,15 @@ void        phoc_output_unmanaged_for_each_surface (PhocOutput            *self,
 GQueue     *phoc_output_get_layer_surfaces_for_layer (PhocOutput                     *self,
                                                       enum zwlr_layer_shell_v1_layer  layer);
 void        phoc_output_set_layer_dirty (PhocOutput *self, enum zwlr_layer_shell_v1_layer  layer);
+void        phoc_output_freeze (PhocOutput *self);
+GPtrArray  *phoc_output_get_layer_surfaces_for_arrange (PhocOutput                     *self,
+                                                        enum zwlr_layer_shell_v1_layer  layer,
+                                                        guint                          *n_exclusive);
+
+GArray     *phoc_output_get_render_list (PhocOutput *self);
+PhocOutputStats *phoc_output_get_stats   (PhocOutput *self);
+void        phoc_output_invalidate_render_list (PhocOutput *self);
+guint32     phoc_output_get_visibility_mask (PhocOutput *self);
 
 /* signal handlers */
 void        phoc_handle_output_manager_apply (struct wl_listener *listener, void *data);
@@ -155,6 +189,16 @@ void        phoc_output_damage_from_surface (PhocOutput         *self,
                                              double              ox,
                                              double              oy,
                                              gboolean            whole);
+void        phoc_output_damage_from_view_surface (PhocOutput         *self,
+                                                  PhocView           *view,
+                                                  struct wlr_surface *wlr_surface,
+                                                  int                 sx,
+                                                  int                 sy);
+void        phoc_output_damage_from_single_surface (PhocOutput         *self,
+                                                    struct wlr_surface *wlr_surface,
+                                                    double              ox,
+                                                    double              oy,
+                                                    float               scale);
 gboolean    phoc_output_damage_box (PhocOutput *self, const struct wlr_box *box);
 gboolean    phoc_output_damage_region (PhocOutput *self, const pixman_region32_t *region);
 
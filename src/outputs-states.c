@@ -11,6 +11,7 @@
 #include "phoc-config.h"
 
 #include "phoc-enums.h"
+#include "phoc-priorities.h"
 #include "outputs-states.h"
 #include "settings.h"
 
@@ -264,6 +265,7 @@ phoc_outputs_states_save_async (PhocOutputsStates    *self,
   g_assert (PHOC_IS_OUTPUTS_STATES (self));
 
   g_task_set_source_tag (task, phoc_outputs_states_save_async);
+  g_task_set_priority (task, PHOC_PRIORITY_BOOKKEEPING);
   statedir = g_path_get_dirname (self->state_file);
   ret = g_mkdir_with_parents (statedir, 0755);
   if (ret != 0) {
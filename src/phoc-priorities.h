@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PHOC_PRIORITY_INTERACTIVE:
+ *
+ * Scheduling class for Wayland dispatch, input and frame handling. Runs
+ * ahead of D-Bus, GSettings and other default priority sources.
+ */
+#define PHOC_PRIORITY_INTERACTIVE G_PRIORITY_HIGH
+
+/**
+ * PHOC_PRIORITY_BOOKKEEPING:
+ *
+ * Scheduling class for work nobody waits for like saving state or
+ * suspending surfaces. Only runs when nothing else is pending.
+ */
+#define PHOC_PRIORITY_BOOKKEEPING G_PRIORITY_LOW
+
+G_END_DECLS
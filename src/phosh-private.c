@@ -46,6 +46,7 @@ struct _PhocPhoshPrivate {
   struct wl_resource* resource;
   struct wl_global *global;
   GList *keyboard_events;
+  GHashTable *accelerators; /* PhocKeyCombo → PhocPhoshPrivateKeyboardEventData */
   guint last_action_id;
   GList *startup_trackers;
   PhocPhoshPrivateShellState state;
@@ -53,7 +54,7 @@ struct _PhocPhoshPrivate {
 G_DEFINE_TYPE (PhocPhoshPrivate, phoc_phosh_private, G_TYPE_OBJECT)
 
 typedef struct {
-  GHashTable *subscribed_accelerators;
+  GHashTable *subscribed_accelerators; /* PhocKeyCombo → action id */
   struct wl_resource *resource;
   PhocPhoshPrivate *phosh;
 } PhocPhoshPrivateKeyboardEventData;
@@ -70,8 +71,19 @@ typedef struct {
   struct wlr_buffer *buffer;
 
   PhocView *view;
+  gboolean  with_damage;
+  gboolean  waiting;       /* for damage, holding a lock on buffer */
+  guint     copy_id;
+
+  struct wl_listener toplevel_destroy;
 } PhocPhoshPrivateScreencopyFrame;
 
+/* What a client's toplevel handle saw of the view's thumbnail */
+typedef struct {
+  struct wl_listener destroy;
+  guint              serial;
+} PhocPhoshPrivateThumbnailState;
+
 typedef struct {
   struct wl_resource *resource;
   PhocPhoshPrivate   *phosh;
@@ -128,6 +140,28 @@ handle_get_xdg_switcher (struct wl_client   *client,
                           "Use wlr-toplevel-management protocol instead");
 }
 
+static void
+unindex_accelerator (PhocPhoshPrivateKeyboardEventData *kbevent, PhocKeyCombo *combo)
+{
+  PhocPhoshPrivate *phosh = kbevent->phosh;
+
+  if (g_hash_table_lookup (phosh->accelerators, combo) == kbevent)
+    g_hash_table_remove (phosh->accelerators, combo);
+}
+
+
+static void
+unindex_accelerators (PhocPhoshPrivateKeyboardEventData *kbevent)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, kbevent->subscribed_accelerators);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    unindex_accelerator (kbevent, key);
+}
+
+
 static void
 phoc_phosh_private_keyboard_event_destroy (PhocPhoshPrivateKeyboardEventData *kbevent)
 {
@@ -138,6 +172,7 @@ phoc_phosh_private_keyboard_event_destroy (PhocPhoshPrivateKeyboardEventData *kb
 
   g_debug ("Destroying private_keyboard_event %p (res %p)", kbevent, kbevent->resource);
   phosh = kbevent->phosh;
+  unindex_accelerators (kbevent);
   g_hash_table_remove_all (kbevent->subscribed_accelerators);
   g_hash_table_unref (kbevent->subscribed_accelerators);
   wl_resource_set_user_data (kbevent->resource, NULL);
@@ -153,31 +188,13 @@ phoc_phosh_private_keyboard_event_handle_resource_destroy (struct wl_resource *r
   phoc_phosh_private_keyboard_event_destroy (kbevent);
 }
 
-static bool
-phoc_phosh_private_keyboard_event_accelerator_is_registered (PhocKeyCombo                      *combo,
-                                                             PhocPhoshPrivateKeyboardEventData *kbevent)
-{
-  gint64 key = ((gint64) combo->modifiers << 32) | combo->keysym;
-  gpointer ret = g_hash_table_lookup (kbevent->subscribed_accelerators, &key);
-  g_debug ("Accelerator is registered: Lookup -> %p", ret);
-  return (ret != NULL);
-}
-
 static bool
 phoc_phosh_private_accelerator_already_subscribed (PhocKeyCombo *combo)
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocPhoshPrivate *phosh = phoc_desktop_get_phosh_private (desktop);
-  GList *l;
-  PhocPhoshPrivateKeyboardEventData *kbevent;
-
-  for (l = phosh->keyboard_events; l != NULL; l = l->next) {
-    kbevent = (PhocPhoshPrivateKeyboardEventData *)l->data;
-    if (phoc_phosh_private_keyboard_event_accelerator_is_registered (combo, kbevent))
-      return true;
-  }
 
-  return false;
+  return g_hash_table_contains (phosh->accelerators, combo);
 }
 
 
@@ -218,7 +235,6 @@ phoc_phosh_private_keyboard_event_grab_accelerator_request (struct wl_client   *
                                                             const char         *accelerator)
 {
   guint new_action_id;
-  gint64 *new_key;
 
   PhocPhoshPrivateKeyboardEventData *kbevent = phoc_phosh_private_keyboard_event_from_resource (resource);
   g_autofree PhocKeyCombo *combo = phoc_keybindings_parse_accelerator (accelerator, NULL);
@@ -265,20 +281,18 @@ phoc_phosh_private_keyboard_event_grab_accelerator_request (struct wl_client   *
     return;
   }
 
-  new_key = (gint64 *) g_malloc (sizeof (gint64));
-  *new_key = ((gint64) combo->modifiers << 32) | combo->keysym;
+  g_debug ("Registered accelerator %s (sym %d mod %d) on phosh_private_keyboard_event %p (client %p)",
+           accelerator, combo->keysym, combo->modifiers, kbevent, wl_client);
 
-  /* subscribed accelerators of kbevent */
+  /* subscribed accelerators of kbevent, the index shares the key */
+  g_hash_table_insert (kbevent->phosh->accelerators, combo, kbevent);
   g_hash_table_insert (kbevent->subscribed_accelerators,
-                       new_key, GUINT_TO_POINTER (new_action_id));
+                       g_steal_pointer (&combo), GUINT_TO_POINTER (new_action_id));
 
   phosh_private_keyboard_event_send_grab_success_event (resource,
                                                         accelerator,
                                                         new_action_id);
 
-  g_debug ("Registered accelerator %s (sym %d mod %d) on phosh_private_keyboard_event %p (client %p)",
-           accelerator, combo->keysym, combo->modifiers, kbevent, wl_client);
-
 }
 
 
@@ -301,7 +315,8 @@ phoc_phosh_private_keyboard_event_ungrab_accelerator_request (struct wl_client *
   }
 
   if (found) {
-    g_hash_table_remove (kbevent->subscribed_accelerators, key);
+    unindex_accelerator (kbevent, found);
+    g_hash_table_remove (kbevent->subscribed_accelerators, found);
     phosh_private_keyboard_event_send_ungrab_success_event (resource,
                                                             action_id);
 
@@ -348,8 +363,8 @@ handle_get_keyboard_event (struct wl_client   *client,
     return;
   }
 
-  kbevent->subscribed_accelerators = g_hash_table_new_full (g_int64_hash,
-                                                            g_int64_equal,
+  kbevent->subscribed_accelerators = g_hash_table_new_full (phoc_key_combo_hash,
+                                                            phoc_key_combo_equal,
                                                             g_free, NULL);
   if (kbevent->subscribed_accelerators == NULL) {
     wl_resource_destroy (kbevent->resource);
@@ -381,10 +396,67 @@ phosh_private_screencopy_frame_handle_resource_destroy (struct wl_resource *reso
   if (frame->view)
     g_signal_handlers_disconnect_by_data (frame->view, frame);
 
+  g_clear_handle_id (&frame->copy_id, g_source_remove);
+  if (frame->waiting)
+    wlr_buffer_unlock (frame->buffer);
+
+  wl_list_remove (&frame->toplevel_destroy.link);
   free (frame);
 }
 
 
+static void
+thumbnail_state_handle_destroy (struct wl_listener *listener, void *data)
+{
+  PhocPhoshPrivateThumbnailState *state = wl_container_of (listener, state, destroy);
+
+  wl_list_remove (&state->destroy.link);
+  g_free (state);
+}
+
+/*
+ * Each client gets its own toplevel handle for a view so that's where
+ * we keep track of the thumbnail it saw last. Damage is relative to that.
+ */
+static PhocPhoshPrivateThumbnailState *
+thumbnail_state_from_toplevel (struct wl_resource *toplevel)
+{
+  PhocPhoshPrivateThumbnailState *state;
+  struct wl_listener *listener;
+
+  listener = wl_resource_get_destroy_listener (toplevel, thumbnail_state_handle_destroy);
+  if (listener)
+    return wl_container_of (listener, state, destroy);
+
+  state = g_new0 (PhocPhoshPrivateThumbnailState, 1);
+  state->destroy.notify = thumbnail_state_handle_destroy;
+  wl_resource_add_destroy_listener (toplevel, &state->destroy);
+
+  return state;
+}
+
+
+static guint
+thumbnail_frame_get_serial (PhocPhoshPrivateScreencopyFrame *frame)
+{
+  if (!frame->toplevel)
+    return 0;
+
+  return thumbnail_state_from_toplevel (frame->toplevel)->serial;
+}
+
+
+static void
+handle_toplevel_destroy (struct wl_listener *listener, void *data)
+{
+  PhocPhoshPrivateScreencopyFrame *frame = wl_container_of (listener, frame, toplevel_destroy);
+
+  wl_list_remove (&frame->toplevel_destroy.link);
+  wl_list_init (&frame->toplevel_destroy.link);
+  frame->toplevel = NULL;
+}
+
+
 static void
 on_surface_destroy (PhocView *view, PhocPhoshPrivateScreencopyFrame *frame)
 {
@@ -392,32 +464,106 @@ on_surface_destroy (PhocView *view, PhocPhoshPrivateScreencopyFrame *frame)
 
   g_signal_handlers_disconnect_by_data (frame->view, frame);
   frame->view = NULL;
+
+  if (frame->waiting) {
+    g_clear_handle_id (&frame->copy_id, g_source_remove);
+    frame->waiting = FALSE;
+    zwlr_screencopy_frame_v1_send_failed (frame->resource);
+    wlr_buffer_unlock (frame->buffer);
+  }
 }
 
 
 static void
-thumbnail_frame_handle_copy (struct wl_client   *wl_client,
-                             struct wl_resource *frame_resource,
-                             struct wl_resource *buffer_resource)
+thumbnail_frame_copy (PhocPhoshPrivateScreencopyFrame *frame)
 {
-  PhocServer *server = phoc_server_get_default ();
-  PhocRenderer *self = phoc_server_get_renderer (server);
-  PhocPhoshPrivateScreencopyFrame *frame;
-  struct wlr_shm_attributes attribs;
+  PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+  PhocView *view = frame->view;
+  guint serial = thumbnail_frame_get_serial (frame);
+  pixman_region32_t damage;
 
-  frame = phoc_phosh_private_screencopy_frame_from_resource (frame_resource);
-  g_return_if_fail (frame);
+  g_signal_handlers_disconnect_by_data (frame->view, frame);
+  frame->view = NULL;
+  frame->waiting = FALSE;
+
+  pixman_region32_init (&damage);
+  if (!phoc_renderer_render_view_to_buffer (renderer, view, frame->buffer, &serial, &damage)) {
+    zwlr_screencopy_frame_v1_send_failed (frame->resource);
+    goto out;
+  }
+
+  if (frame->toplevel)
+    thumbnail_state_from_toplevel (frame->toplevel)->serial = serial;
+
+  zwlr_screencopy_frame_v1_send_flags (frame->resource, 0);
+
+  if (frame->with_damage) {
+    int n_rects;
+    const pixman_box32_t *rects = pixman_region32_rectangles (&damage, &n_rects);
+
+    for (int i = 0; i < n_rects; i++) {
+      zwlr_screencopy_frame_v1_send_damage (frame->resource,
+                                            rects[i].x1,
+                                            rects[i].y1,
+                                            rects[i].x2 - rects[i].x1,
+                                            rects[i].y2 - rects[i].y1);
+    }
+  }
+
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  uint32_t tv_sec_hi = (sizeof(now.tv_sec) > 4) ? now.tv_sec >> 32 : 0;
+  uint32_t tv_sec_lo = now.tv_sec & 0xFFFFFFFF;
+  zwlr_screencopy_frame_v1_send_ready (frame->resource, tv_sec_hi, tv_sec_lo, now.tv_nsec);
+
+ out:
+  pixman_region32_fini (&damage);
+  wlr_buffer_unlock (frame->buffer);
+}
+
+
+static void
+on_thumbnail_copy_idle (gpointer data)
+{
+  PhocPhoshPrivateScreencopyFrame *frame = data;
+
+  frame->copy_id = 0;
+  thumbnail_frame_copy (frame);
+}
+
+
+static void
+on_thumbnail_damaged (PhocView *view, PhocPhoshPrivateScreencopyFrame *frame)
+{
+  g_assert (PHOC_IS_VIEW (view));
+
+  /* Let the client finish its commits before rendering */
+  if (!frame->copy_id)
+    frame->copy_id = g_idle_add_once (on_thumbnail_copy_idle, frame);
+}
+
+/*
+ * Checks the client's buffer and takes a lock on it. Returns %FALSE
+ * if the buffer can't be used, the error is already reported to the
+ * client then.
+ */
+static gboolean
+thumbnail_frame_attach_buffer (PhocPhoshPrivateScreencopyFrame *frame,
+                               struct wl_resource              *buffer_resource)
+{
+  struct wlr_shm_attributes attribs;
+  struct wlr_dmabuf_attributes dmabuf;
 
   if (frame->buffer != NULL) {
     wl_resource_post_error (frame->resource,
                             ZWLR_SCREENCOPY_FRAME_V1_ERROR_ALREADY_USED,
                             "frame already used");
-    return;
+    return FALSE;
   }
 
   if (!frame->view) {
     zwlr_screencopy_frame_v1_send_failed (frame->resource);
-    return;
+    return FALSE;
   }
 
   frame->buffer = wlr_buffer_try_from_resource (buffer_resource);
@@ -425,14 +571,23 @@ thumbnail_frame_handle_copy (struct wl_client   *wl_client,
     wl_resource_post_error (frame->resource,
                             ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
                             "unsupported buffer type");
-    return;
+    return FALSE;
   }
 
-  if (!wlr_buffer_get_shm (frame->buffer, &attribs)) {
+  if (wlr_buffer_get_dmabuf (frame->buffer, &dmabuf)) {
+    /* Dmabufs get filled on the GPU without a copy through system memory */
+    attribs = (struct wlr_shm_attributes) {
+      .format = dmabuf.format,
+      .width = dmabuf.width,
+      .height = dmabuf.height,
+      .stride = frame->stride,
+    };
+  } else if (!wlr_buffer_get_shm (frame->buffer, &attribs)) {
     wl_resource_post_error (frame->resource,
                             ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
                             "unsupported buffer type");
-    goto unlock_buffer;
+    wlr_buffer_unlock (frame->buffer);
+    return FALSE;
   }
 
   if (attribs.format != DRM_FORMAT_ARGB8888 || attribs.width != frame->width ||
@@ -440,28 +595,28 @@ thumbnail_frame_handle_copy (struct wl_client   *wl_client,
     wl_resource_post_error (frame->resource,
                             ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
                             "invalid buffer attributes");
-    goto unlock_buffer;
+    wlr_buffer_unlock (frame->buffer);
+    return FALSE;
   }
 
-  PhocView *view = frame->view;
-  g_signal_handlers_disconnect_by_data (frame->view, frame);
-  frame->view = NULL;
+  return TRUE;
+}
 
-  if (!phoc_renderer_render_view_to_buffer (self, view, frame->buffer)) {
-    zwlr_screencopy_frame_v1_send_failed (frame->resource);
-    goto unlock_buffer;
-  }
 
-  zwlr_screencopy_frame_v1_send_flags (frame->resource, 0);
+static void
+thumbnail_frame_handle_copy (struct wl_client   *wl_client,
+                             struct wl_resource *frame_resource,
+                             struct wl_resource *buffer_resource)
+{
+  PhocPhoshPrivateScreencopyFrame *frame;
 
-  struct timespec now;
-  clock_gettime (CLOCK_MONOTONIC, &now);
-  uint32_t tv_sec_hi = (sizeof(now.tv_sec) > 4) ? now.tv_sec >> 32 : 0;
-  uint32_t tv_sec_lo = now.tv_sec & 0xFFFFFFFF;
-  zwlr_screencopy_frame_v1_send_ready (frame->resource, tv_sec_hi, tv_sec_lo, now.tv_nsec);
+  frame = phoc_phosh_private_screencopy_frame_from_resource (frame_resource);
+  g_return_if_fail (frame);
 
-unlock_buffer:
-  wlr_buffer_unlock (frame->buffer);
+  if (!thumbnail_frame_attach_buffer (frame, buffer_resource))
+    return;
+
+  thumbnail_frame_copy (frame);
 }
 
 static void
@@ -469,10 +624,29 @@ thumbnail_frame_handle_copy_with_damage (struct wl_client   *wl_client,
                                          struct wl_resource *frame_resource,
                                          struct wl_resource *buffer_resource)
 {
-  // XXX: unimplemented
-  (void)wl_client;
-  (void)buffer_resource;
-  zwlr_screencopy_frame_v1_send_failed (frame_resource);
+  PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+  PhocPhoshPrivateScreencopyFrame *frame;
+
+  frame = phoc_phosh_private_screencopy_frame_from_resource (frame_resource);
+  g_return_if_fail (frame);
+
+  if (!thumbnail_frame_attach_buffer (frame, buffer_resource))
+    return;
+
+  frame->with_damage = TRUE;
+
+  /* Nothing changed since this client's last copy so wait for damage */
+  if (phoc_renderer_has_view_thumbnail (renderer,
+                                        frame->view,
+                                        frame->width,
+                                        frame->height,
+                                        thumbnail_frame_get_serial (frame))) {
+    frame->waiting = TRUE;
+    g_signal_connect (frame->view, "thumbnail-damaged", G_CALLBACK (on_thumbnail_damaged), frame);
+    return;
+  }
+
+  thumbnail_frame_copy (frame);
 }
 
 static void
@@ -512,6 +686,7 @@ handle_get_thumbnail (struct wl_client *client,
   }
 
   g_debug ("new phosh_private_screencopy_frame %p (res %p)", frame, frame->resource);
+  wl_list_init (&frame->toplevel_destroy.link);
   wl_resource_set_implementation (frame->resource,
                                   &phoc_phosh_private_screencopy_frame_impl,
                                   frame,
@@ -530,6 +705,8 @@ handle_get_thumbnail (struct wl_client *client,
   }
 
   frame->toplevel = toplevel;
+  frame->toplevel_destroy.notify = handle_toplevel_destroy;
+  wl_resource_add_destroy_listener (toplevel, &frame->toplevel_destroy);
   frame->view = view;
   g_signal_connect (view, "surface-destroy", G_CALLBACK (on_surface_destroy), frame);
 
@@ -658,6 +835,7 @@ phosh_handle_resource_destroy (struct wl_resource *resource)
 
   g_list_free (phosh->keyboard_events);
   phosh->keyboard_events = NULL;
+  g_hash_table_remove_all (phosh->accelerators);
 
   phosh->state = PHOC_PHOSH_PRIVATE_SHELL_STATE_UNKNOWN;
   g_object_notify_by_pspec (G_OBJECT (phosh), props[PROP_SHELL_STATE]);
@@ -760,6 +938,7 @@ phoc_phosh_private_finalize (GObject *object)
   PhocPhoshPrivate *self = PHOC_PHOSH_PRIVATE (object);
 
   wl_global_destroy (self->global);
+  g_hash_table_destroy (self->accelerators);
 
   G_OBJECT_CLASS (phoc_phosh_private_parent_class)->finalize (object);
 }
@@ -795,6 +974,7 @@ static void
 phoc_phosh_private_init (PhocPhoshPrivate *self)
 {
   self->last_action_id = 1;
+  self->accelerators = g_hash_table_new (phoc_key_combo_hash, phoc_key_combo_equal);
 }
 
 
@@ -812,34 +992,31 @@ phoc_phosh_private_forward_keysym (PhocKeyCombo *combo,
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocPhoshPrivate *phosh = phoc_desktop_get_phosh_private (desktop);
-  GList *l;
-  bool forwarded = false;
-
-  for (l = phosh->keyboard_events; l != NULL; l = l->next) {
-    PhocPhoshPrivateKeyboardEventData *kbevent = l->data;
-    uint32_t version = wl_resource_get_version (kbevent->resource);
-
-    g_debug("addr of kbevent and res kbev %p res %p", kbevent, kbevent->resource);
-    /*  forward the keysym if it is has been subscribed to */
-    if (phoc_phosh_private_keyboard_event_accelerator_is_registered (combo, kbevent)) {
-      gint64 key = ((gint64)combo->modifiers << 32) | combo->keysym;
-      guint action_id = GPOINTER_TO_UINT (g_hash_table_lookup (kbevent->subscribed_accelerators, &key));
-
-      if (pressed) {
-        phosh_private_keyboard_event_send_accelerator_activated_event (kbevent->resource,
-                                                                       action_id,
-                                                                       timestamp);
-        forwarded = true;
-      } else if (version >= PHOSH_PRIVATE_KEYBOARD_EVENT_ACCELERATOR_RELEASED_EVENT_SINCE_VERSION) {
-        phosh_private_keyboard_event_send_accelerator_released_event (kbevent->resource,
-                                                                      action_id,
-                                                                      timestamp);
-        forwarded = true;
-      }
-    }
+  PhocPhoshPrivateKeyboardEventData *kbevent;
+  uint32_t version;
+  guint action_id;
+
+  /*  forward the keysym if it is has been subscribed to */
+  kbevent = g_hash_table_lookup (phosh->accelerators, combo);
+  if (kbevent == NULL)
+    return false;
+
+  version = wl_resource_get_version (kbevent->resource);
+  action_id = GPOINTER_TO_UINT (g_hash_table_lookup (kbevent->subscribed_accelerators, combo));
+
+  if (pressed) {
+    phosh_private_keyboard_event_send_accelerator_activated_event (kbevent->resource,
+                                                                   action_id,
+                                                                   timestamp);
+    return true;
+  } else if (version >= PHOSH_PRIVATE_KEYBOARD_EVENT_ACCELERATOR_RELEASED_EVENT_SINCE_VERSION) {
+    phosh_private_keyboard_event_send_accelerator_released_event (kbevent->resource,
+                                                                  action_id,
+                                                                  timestamp);
+    return true;
   }
 
-  return forwarded;
+  return false;
 }
 
 void
@@ -16,15 +16,16 @@
 
 #include "bling.h"
 #include "cursor.h"
+#include "desktop.h"
 #include "input.h"
 #include "layer-surface.h"
+#include "phoc-priorities.h"
 #include "render-private.h"
 #include "render.h"
 #include "seat.h"
 #include "server.h"
 #include "touch-point.h"
 #include "utils.h"
-#include "xwayland-surface.h"
 
 #include <wlr/backend.h>
 #include <wlr/config.h>
@@ -81,6 +82,11 @@ struct _PhocRenderer {
   struct wl_listener    renderer_lost;
   guint renderer_recreate_id;
 
+  GArray               *surface_damage; /* (element-type pixman_region32_t) */
+  GQueue                thumbnail_pool; /* idle thumbnail buffers, most recently used first */
+  gint64                last_thumbnail_us;
+  guint                 thumbnail_timeout_id;
+  guint                 thumbnail_serial;
 };
 
 static void phoc_renderer_initable_iface_init (GInitableIface *iface);
@@ -95,8 +101,61 @@ struct render_view_data {
   int       width;
   int       height;
   struct wlr_render_pass *render_pass;
+  pixman_region32_t      *clip;
 };
 
+/* Number of idle thumbnail buffers kept around for reuse */
+#define THUMBNAIL_POOL_SIZE 8
+/* Drop all thumbnail caches when no thumbnail was requested for that long */
+#define THUMBNAIL_CACHE_TIMEOUT_S 10
+
+
+
+static gboolean
+clear_view_cache_iter (PhocDesktop *desktop, PhocView *view, gpointer user_data)
+{
+  phoc_view_clear_offscreen_cache (view);
+  phoc_view_clear_thumbnail_cache (view);
+
+  return TRUE;
+}
+
+
+static void
+drain_thumbnail_pool (PhocRenderer *self)
+{
+  struct wlr_buffer *buffer;
+
+  while ((buffer = g_queue_pop_head (&self->thumbnail_pool)))
+    wlr_buffer_drop (buffer);
+}
+
+
+static gboolean
+clear_thumbnail_cache_iter (PhocDesktop *desktop, PhocView *view, gpointer user_data)
+{
+  phoc_view_clear_thumbnail_cache (view);
+
+  return TRUE;
+}
+
+
+static gboolean
+on_thumbnail_timeout (gpointer user_data)
+{
+  PhocRenderer *self = PHOC_RENDERER (user_data);
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+
+  if (g_get_monotonic_time () - self->last_thumbnail_us < THUMBNAIL_CACHE_TIMEOUT_S * G_USEC_PER_SEC)
+    return G_SOURCE_CONTINUE;
+
+  g_debug ("No thumbnails requested for %ds, dropping caches", THUMBNAIL_CACHE_TIMEOUT_S);
+  phoc_desktop_for_each_view (desktop, clear_thumbnail_cache_iter, NULL);
+  drain_thumbnail_pool (self);
+
+  self->thumbnail_timeout_id = 0;
+  return G_SOURCE_REMOVE;
+}
 
 
 static void
@@ -140,6 +199,10 @@ recreate_renderer (void *data)
   wl_list_for_each (output, &desktop->outputs, link)
     wlr_output_init_render (output->wlr_output, self->wlr_allocator, self->wlr_renderer);
 
+  /* Cached view textures and buffers belong to the old renderer */
+  phoc_desktop_for_each_view (desktop, clear_view_cache_iter, NULL);
+  drain_thumbnail_pool (self);
+
   wlr_allocator_destroy (old_wlr_allocator);
   wlr_renderer_destroy (old_wlr_renderer);
 }
@@ -206,6 +269,7 @@ render_texture (PhocOutput               *output,
                 const struct wlr_box     *clip_box,
                 enum wl_output_transform  surface_transform,
                 float                     alpha,
+                const pixman_region32_t  *output_damage,
                 PhocRenderContext        *ctx)
 {
   pixman_region32_t damage;
@@ -215,7 +279,7 @@ render_texture (PhocOutput               *output,
   if (alpha == 0.0)
     return;
 
-  if (!phoc_utils_is_damaged (&proj_box, ctx->damage, clip_box, &damage))
+  if (!phoc_utils_is_damaged (&proj_box, output_damage, clip_box, &damage))
     goto buffer_damage_finish;
 
   transform = wlr_output_transform_compose (wlr_output_transform_invert (surface_transform),
@@ -236,50 +300,137 @@ render_texture (PhocOutput               *output,
 }
 
 
+/**
+ * scale_region_inner:
+ * @region: (inout): The region to scale
+ * @scale: The scale to apply
+ *
+ * Scales a region rounding every rectangle inwards so the result
+ * never covers pixels outside of the original region. With fractional
+ * scales rectangles are shrunk by another pixel to account for
+ * filtering at the edges.
+ */
 static void
-render_surface_iterator (PhocOutput         *output,
-                         struct wlr_surface *surface,
-                         struct wlr_box     *box,
-                         float               scale,
-                         void               *data)
+scale_region_inner (pixman_region32_t *region, float scale)
 {
-  PhocRenderContext *ctx = data;
-  struct wlr_output *wlr_output = output->wlr_output;
+  g_autofree pixman_box32_t *scaled = NULL;
+  pixman_box32_t *rects;
+  int n_rects, n_scaled = 0, shrink;
+
+  if (G_APPROX_VALUE (scale, 1.0, FLT_EPSILON))
+    return;
+
+  shrink = G_APPROX_VALUE (scale, roundf (scale), FLT_EPSILON) ? 0 : 1;
+
+  rects = pixman_region32_rectangles (region, &n_rects);
+  scaled = g_new (pixman_box32_t, n_rects);
+  for (int i = 0; i < n_rects; i++) {
+    pixman_box32_t box = {
+      .x1 = ceil (rects[i].x1 * scale) + shrink,
+      .y1 = ceil (rects[i].y1 * scale) + shrink,
+      .x2 = floor (rects[i].x2 * scale) - shrink,
+      .y2 = floor (rects[i].y2 * scale) - shrink,
+    };
+
+    if (box.x1 >= box.x2 || box.y1 >= box.y2)
+      continue;
+
+    scaled[n_scaled++] = box;
+  }
+
+  pixman_region32_fini (region);
+  pixman_region32_init_rects (region, scaled, n_scaled);
+}
+
+
+/**
+ * collect_opaque_region:
+ * @output: The output that is being rendered
+ * @entry: The render list entry to collect the opaque region of
+ * @alpha: The alpha the surface will be rendered with
+ * @ctx: The render context
+ *
+ * Appends the surface's opaque region in buffer coordinates to the
+ * list of regions used for occlusion culling. Surfaces that aren't
+ * rendered fully opaque get an empty region.
+ */
+static void
+collect_opaque_region (PhocOutput        *output,
+                       PhocRenderEntry   *entry,
+                       float              alpha,
+                       PhocRenderContext *ctx)
+{
+  struct wlr_surface *surface = entry->surface;
+  pixman_region32_t opaque;
+
+  pixman_region32_init (&opaque);
+
+  if (alpha < 1.0 || pixman_region32_empty (&surface->opaque_region))
+    goto out;
+
+  pixman_region32_intersect_rect (&opaque, &surface->opaque_region,
+                                  0, 0, surface->current.width, surface->current.height);
+  pixman_region32_translate (&opaque, entry->box.x, entry->box.y);
+  scale_region_inner (&opaque, entry->scale);
+  scale_region_inner (&opaque, output->wlr_output->scale);
+  phoc_output_transform_damage (output, &opaque);
+
+  pixman_region32_intersect_rect (&opaque, &opaque,
+                                  entry->dst_box.x, entry->dst_box.y,
+                                  entry->dst_box.width, entry->dst_box.height);
+ out:
+  g_array_append_val (ctx->surface_damage, opaque);
+}
+
+
+static void
+render_entry (PhocOutput *output, PhocRenderEntry *entry, PhocRenderContext *ctx)
+{
+  struct wlr_surface *surface = entry->surface;
   float alpha = ctx->alpha;
   const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  const pixman_region32_t *damage = ctx->damage;
+
+  /* Shown on an output layer instead */
+  if (entry->offloaded)
+    return;
 
   struct wlr_texture *texture = wlr_surface_get_texture (surface);
   if (!texture)
     return;
 
-  struct wlr_fbox src_box;
-  wlr_surface_get_buffer_source_box (surface, &src_box);
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state)
+    alpha *= (float)alpha_modifier_state->multiplier;
 
-  struct wlr_box dst_box = *box;
-  struct wlr_box clip_box = *box;
+  if (ctx->collect_opaque) {
+    collect_opaque_region (output, entry, alpha, ctx);
+    return;
+  }
 
-  phoc_utils_scale_box (&dst_box, scale);
-  phoc_utils_scale_box (&dst_box, wlr_output->scale);
-  phoc_output_transform_box (output, &dst_box);
+  /* Only paint what isn't covered by opaque surfaces above */
+  if (ctx->surface_damage && ctx->surface_index < ctx->surface_damage->len) {
+    damage = &g_array_index (ctx->surface_damage, pixman_region32_t, ctx->surface_index);
+    ctx->surface_index++;
 
-  phoc_utils_scale_box (&clip_box, scale);
-  phoc_utils_scale_box (&clip_box, wlr_output->scale);
-  phoc_output_transform_box (output, &clip_box);
+    if (pixman_region32_empty (damage))
+      return;
+  }
 
-  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
-  if (alpha_modifier_state)
-    alpha *= (float)alpha_modifier_state->multiplier;
+  struct wlr_fbox src_box;
+  wlr_surface_get_buffer_source_box (surface, &src_box);
 
   render_texture (output,
                   texture,
                   &src_box,
-                  &dst_box,
-                  &clip_box,
+                  &entry->dst_box,
+                  &entry->dst_box,
                   surface->current.transform,
                   alpha,
+                  damage,
                   ctx);
 
-  wlr_presentation_surface_scanned_out_on_output (surface, wlr_output);
+  wlr_presentation_surface_scanned_out_on_output (surface, output->wlr_output);
 }
 
 
@@ -288,6 +439,9 @@ render_blings (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
 {
   GSList *blings;
 
+  if (ctx->collect_opaque)
+    return;
+
   if (!phoc_view_is_mapped (view))
     return;
 
@@ -303,53 +457,6 @@ render_blings (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
 }
 
 
-static void
-render_view (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
-{
-  /*  Do not render views fullscreened on other outputs */
-  if (phoc_view_is_fullscreen (view) && phoc_view_get_fullscreen_output (view) != output)
-    return;
-
-  ctx->alpha = phoc_view_get_alpha (view);
-
-  if (!phoc_view_is_fullscreen (view))
-    render_blings (output, view, ctx);
-
-  phoc_output_view_for_each_surface (output, view, render_surface_iterator, ctx);
-}
-
-
-static void
-render_layer (enum zwlr_layer_shell_v1_layer layer, PhocRenderContext *ctx)
-{
-  GQueue *layer_surfaces = phoc_output_get_layer_surfaces_for_layer (ctx->output, layer);
-
-  for (GList *l = layer_surfaces->head; l; l = l->next) {
-    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
-
-    ctx->alpha = phoc_layer_surface_get_alpha (layer_surface);
-    phoc_output_layer_surface_for_each_surface (ctx->output,
-                                                layer_surface,
-                                                render_surface_iterator,
-                                                ctx);
-  }
-}
-
-
-static void
-render_unmanaged_surfaces (PhocRenderer *self, PhocWorkspace *workspace, PhocRenderContext *ctx)
-{
-  for (GList *l = phoc_workspace_get_unmanaged (workspace)->tail; l; l = l->prev) {
-    PhocXWaylandUnmanaged *unmanaged = PHOC_XWAYLAND_UNMANAGED (l->data);
-
-    phoc_output_unmanaged_for_each_surface (ctx->output,
-                                            unmanaged,
-                                            render_surface_iterator,
-                                            ctx);
-  }
-}
-
-
 static void
 render_output_blings (PhocOutput *output, PhocRenderContext *ctx)
 {
@@ -367,15 +474,6 @@ render_output_blings (PhocOutput *output, PhocRenderContext *ctx)
 }
 
 
-static void
-render_drag_icons (PhocInput *input, PhocRenderContext *ctx)
-{
-  ctx->alpha = 1.0;
-
-  phoc_output_drag_icons_for_each_surface (ctx->output, input, render_surface_iterator, ctx);
-}
-
-
 static void
 render_touch_point_cb (gpointer key, gpointer value, gpointer user_data)
 {
@@ -433,52 +531,160 @@ view_render_to_buffer_iterator (struct wlr_surface *surface, int sx, int sy, voi
       .dst_box = dst_box,
       .transform = wlr_output_transform_invert (surface->current.transform),
       .alpha = &alpha,
+      .clip = data->clip,
     });
 }
 
 
-gboolean
-phoc_renderer_render_view_to_buffer (PhocRenderer      *self,
-                                     PhocView          *view,
-                                     struct wlr_buffer *shm_buffer)
+static void
+add_to_cache_key_iterator (struct wlr_surface *surface, int sx, int sy, void *data)
+{
+  PhocViewCacheKey *key = data;
+
+  key->n_surfaces++;
+  key->stack = phoc_view_cache_add_to_stack (key->stack, surface);
+}
+
+/**
+ * get_thumbnail_cache_key:
+ * @view: The view
+ * @width: The thumbnail's width
+ * @height: The thumbnail's height
+ * @key: (out): The key
+ *
+ * Gets the key identifying a thumbnail of the view's current surface
+ * tree. Thumbnails are scaled to the requested size and contain no
+ * blings so neither affects the key.
+ */
+static void
+get_thumbnail_cache_key (PhocView *view, int width, int height, PhocViewCacheKey *key)
+{
+  *key = (PhocViewCacheKey) {
+    .box = { .width = width, .height = height },
+    .scale = 1.0,
+    .view_scale = 1.0,
+  };
+
+  wlr_surface_for_each_surface (view->wlr_surface, add_to_cache_key_iterator, key);
+}
+
+
+static struct wlr_buffer *
+acquire_thumbnail_buffer (PhocRenderer *self, int width, int height)
 {
-  struct wlr_surface *surface = view->wlr_surface;
-  struct wlr_buffer *buffer;
-  void *data;
-  uint32_t format;
-  size_t stride;
-  int32_t width, height;
-  struct wlr_render_pass *render_pass;
-  const struct wlr_drm_format *fmt;
   struct wlr_drm_format_set fmt_set = {};
-  bool success;
+  const struct wlr_drm_format *fmt;
+  struct wlr_buffer *buffer;
 
-  g_return_val_if_fail (surface, false);
-  g_return_val_if_fail (self->wlr_allocator, false);
-  g_return_val_if_fail (shm_buffer, false);
+  for (GList *l = self->thumbnail_pool.head; l; l = l->next) {
+    buffer = l->data;
+
+    if (buffer->width == width && buffer->height == height) {
+      g_queue_delete_link (&self->thumbnail_pool, l);
+      return buffer;
+    }
+  }
 
-  width = shm_buffer->width;
-  height = shm_buffer->height;
   wlr_drm_format_set_add (&fmt_set, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR);
   fmt = wlr_drm_format_set_get (&fmt_set, DRM_FORMAT_ARGB8888);
-
   buffer = wlr_allocator_create_buffer (self->wlr_allocator, width, height, fmt);
-  if (!buffer) {
-    wlr_drm_format_set_finish (&fmt_set);
-    g_warning ("Failed to allocate buffer");
-    return false;
+  wlr_drm_format_set_finish (&fmt_set);
+
+  return buffer;
+}
+
+
+static void
+release_thumbnail_buffer (struct wlr_buffer *buffer, gpointer user_data)
+{
+  PhocRenderer *self = PHOC_RENDERER (user_data);
+
+  g_queue_push_head (&self->thumbnail_pool, buffer);
+
+  while (g_queue_get_length (&self->thumbnail_pool) > THUMBNAIL_POOL_SIZE)
+    wlr_buffer_drop (g_queue_pop_tail (&self->thumbnail_pool));
+}
+
+/**
+ * update_thumbnail_cache:
+ * @self: The renderer
+ * @view: The view to render
+ * @width: The thumbnail's width
+ * @height: The thumbnail's height
+ * @damage:(out caller-allocates): The updated area of the thumbnail
+ *
+ * Renders the view scaled down to the thumbnail size into its
+ * thumbnail cache unless the cache is still up to date. If only the
+ * view's content changed only the damaged area is rendered
+ * again. Buffers are taken from a pool shared by all views.
+ *
+ * Returns: (nullable): The up to date cache
+ */
+static PhocViewCache *
+update_thumbnail_cache (PhocRenderer      *self,
+                        PhocView          *view,
+                        int                width,
+                        int                height,
+                        pixman_region32_t *damage)
+{
+  PhocViewCache *cache = phoc_view_get_thumbnail_cache (view);
+  struct wlr_render_pass *render_pass;
+  PhocViewCacheKey key;
+  struct wlr_box geo;
+  gboolean partial;
+
+  pixman_region32_clear (damage);
+
+  get_thumbnail_cache_key (view, width, height, &key);
+  if (phoc_view_cache_is_valid (cache, &key))
+    return cache;
+
+  /* Only the content changed, the buffer still holds the rest */
+  partial = cache->buffer && phoc_view_cache_key_equal (&cache->key, &key);
+  if (partial) {
+    float scale;
+
+    phoc_view_get_geometry (view, &geo);
+    scale = fmin (width / (float)geo.width, height / (float)geo.height);
+    wlr_region_scale (damage, &cache->damage, scale);
+    /* Account for filtering when scaling down */
+    wlr_region_expand (damage, damage, 1);
+    pixman_region32_intersect_rect (damage, damage, 0, 0, width, height);
+  } else {
+    pixman_region32_union_rect (damage, damage, 0, 0, width, height);
   }
+  pixman_region32_clear (&cache->damage);
+
+  cache->dirty = TRUE;
+  cache->key = (PhocViewCacheKey) {};
+
+  /* The texture gets recreated after rendering */
+  g_clear_pointer (&cache->texture, wlr_texture_destroy);
 
-  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, buffer, NULL);
+  if (cache->buffer && (cache->buffer->width != width || cache->buffer->height != height))
+    release_thumbnail_buffer (g_steal_pointer (&cache->buffer), self);
+
+  if (cache->buffer == NULL) {
+    cache->buffer = acquire_thumbnail_buffer (self, width, height);
+    if (!cache->buffer) {
+      g_warning ("Failed to allocate thumbnail buffer");
+      return NULL;
+    }
+    /* Return the buffer to the pool when the view goes away */
+    cache->release_func = release_thumbnail_buffer;
+    cache->release_data = self;
+  }
+
+  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, cache->buffer, NULL);
   if (!render_pass) {
-    wlr_drm_format_set_finish (&fmt_set);
-    g_warning ("Failed to start render pass");
-    return false;
+    g_warning ("Failed to start thumbnail render pass");
+    return NULL;
   }
 
   wlr_render_pass_add_rect (render_pass, &(struct wlr_render_rect_options){
       .color = { 0, 0, 0, 0 },
       .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+      .clip = damage,
     });
 
   struct render_view_data render_data = {
@@ -486,29 +692,157 @@ phoc_renderer_render_view_to_buffer (PhocRenderer      *self,
     .width = width,
     .height = height,
     .render_pass = render_pass,
+    .clip = damage,
   };
-  wlr_surface_for_each_surface (surface, view_render_to_buffer_iterator, &render_data);
-  wlr_render_pass_submit (render_pass);
+  wlr_surface_for_each_surface (view->wlr_surface, view_render_to_buffer_iterator, &render_data);
+  if (!wlr_render_pass_submit (render_pass)) {
+    g_warning ("Failed to render thumbnail");
+    return NULL;
+  }
+
+  cache->texture = wlr_texture_from_buffer (self->wlr_renderer, cache->buffer);
+  if (!cache->texture)
+    return NULL;
+
+  cache->key = key;
+  cache->dirty = FALSE;
+
+  /* Serials are unique across views so they stay meaningful when caches get recreated */
+  if (++self->thumbnail_serial == 0)
+    self->thumbnail_serial++;
+  phoc_view_cache_add_render (cache, self->thumbnail_serial, damage);
+
+  return cache;
+}
+
+/**
+ * phoc_renderer_has_view_thumbnail:
+ * @self: The renderer
+ * @view: The view
+ * @width: The thumbnail's width
+ * @height: The thumbnail's height
+ * @serial: The serial of the thumbnail the consumer got last
+ *
+ * Check whether the view's cached thumbnail of the given size is
+ * up to date, i.e. the view wasn't damaged since it was rendered, and
+ * is the one identified by @serial.
+ *
+ * Returns: %TRUE if the cached thumbnail is up to date
+ */
+gboolean
+phoc_renderer_has_view_thumbnail (PhocRenderer *self,
+                                  PhocView     *view,
+                                  int           width,
+                                  int           height,
+                                  guint         serial)
+{
+  PhocViewCache *cache = phoc_view_get_thumbnail_cache (view);
+  PhocViewCacheKey key;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  if (!view->wlr_surface)
+    return FALSE;
+
+  if (serial == 0 || cache->serial != serial)
+    return FALSE;
+
+  get_thumbnail_cache_key (view, width, height, &key);
+  return phoc_view_cache_is_valid (cache, &key);
+}
+
+/**
+ * phoc_renderer_render_view_to_buffer:
+ * @self: The renderer
+ * @view: The view to render
+ * @buffer: The client's buffer
+ * @serial:(inout): The serial of the thumbnail the consumer got last
+ *   or `0`. Updated to the serial of the rendered thumbnail.
+ * @damage:(out caller-allocates)(nullable): The area that changed
+ *   since the thumbnail identified by @serial
+ *
+ * Render a thumbnail of @view into @buffer. The view is scaled down
+ * on the GPU and kept in the view's thumbnail cache until the view
+ * gets damaged so repeated requests only need to copy it. Dmabuf
+ * targets are filled on the GPU, shm targets via a read back. All
+ * thumbnail caches are dropped once no thumbnails were requested
+ * for a while. As the cache is shared by all consumers each of them
+ * tracks the thumbnail it got last via @serial.
+ *
+ * Returns: %TRUE on success, otherwise %FALSE
+ */
+gboolean
+phoc_renderer_render_view_to_buffer (PhocRenderer      *self,
+                                     PhocView          *view,
+                                     struct wlr_buffer *buffer,
+                                     guint             *serial,
+                                     pixman_region32_t *damage)
+{
+  pixman_region32_t cache_damage;
+  PhocViewCache *cache;
+  struct wlr_dmabuf_attributes dmabuf;
+  void *data;
+  uint32_t format;
+  size_t stride;
+  bool success;
+
+  g_return_val_if_fail (view->wlr_surface, false);
+  g_return_val_if_fail (self->wlr_allocator, false);
+  g_return_val_if_fail (buffer, false);
+  g_return_val_if_fail (serial, false);
+
+  self->last_thumbnail_us = g_get_monotonic_time ();
+  if (!self->thumbnail_timeout_id) {
+    self->thumbnail_timeout_id = g_timeout_add_seconds_full (PHOC_PRIORITY_BOOKKEEPING,
+                                                             THUMBNAIL_CACHE_TIMEOUT_S,
+                                                             on_thumbnail_timeout,
+                                                             self,
+                                                             NULL);
+    g_source_set_name_by_id (self->thumbnail_timeout_id, "[phoc] thumbnail cache timeout");
+  }
+
+  pixman_region32_init (&cache_damage);
+  cache = update_thumbnail_cache (self, view, buffer->width, buffer->height, &cache_damage);
+  pixman_region32_fini (&cache_damage);
+  if (!cache)
+    return false;
+
+  if (damage && !phoc_view_cache_get_damage_since (cache, *serial, damage))
+    pixman_region32_union_rect (damage, damage, 0, 0, buffer->width, buffer->height);
+  *serial = cache->serial;
+
+  if (wlr_buffer_get_dmabuf (buffer, &dmabuf)) {
+    struct wlr_render_pass *render_pass;
+
+    render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, buffer, NULL);
+    if (!render_pass) {
+      g_warning ("Failed to start render pass");
+      return false;
+    }
+
+    wlr_render_pass_add_texture (render_pass, &(struct wlr_render_texture_options) {
+        .texture = cache->texture,
+        .dst_box = { .width = buffer->width, .height = buffer->height },
+        .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+      });
 
-  if (!wlr_buffer_begin_data_ptr_access (shm_buffer,
+    return wlr_render_pass_submit (render_pass);
+  }
+
+  if (!wlr_buffer_begin_data_ptr_access (buffer,
                                          WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
                                          &data, &format, &stride)) {
     return false;
   }
 
-  struct wlr_texture *texture = wlr_texture_from_buffer (self->wlr_renderer, buffer);
-  success = wlr_texture_read_pixels (texture, &(struct wlr_texture_read_pixels_options) {
+  success = wlr_texture_read_pixels (cache->texture, &(struct wlr_texture_read_pixels_options) {
       .data = data,
       .format = format,
       .stride = stride,
-      .src_box = (struct wlr_box) { .x = 0, .y = 0, .width = width, .height = height },
+      .src_box = (struct wlr_box) { .x = 0, .y = 0, .width = buffer->width, .height = buffer->height },
     });
-  wlr_texture_destroy (texture);
-
-  wlr_buffer_drop (buffer);
-  wlr_drm_format_set_finish (&fmt_set);
 
-  wlr_buffer_end_data_ptr_access (shm_buffer);
+  wlr_buffer_end_data_ptr_access (buffer);
 
   return success;
 }
@@ -543,6 +877,465 @@ render_damage (PhocRenderer *self, PhocRenderContext *ctx)
   }
 }
 
+static float
+get_render_entry_alpha (PhocRenderEntry *entry)
+{
+  if (entry->view)
+    return phoc_view_get_alpha (entry->view);
+
+  if (entry->layer_surface)
+    return phoc_layer_surface_get_alpha (entry->layer_surface);
+
+  return 1.0;
+}
+
+/**
+ * count_view_entries:
+ * @render_list: The render list
+ * @start: The index of a surface entry
+ *
+ * Returns: The number of consecutive surface entries belonging to the
+ *   same view as the entry at @start. `0` if the entry isn't part of a view.
+ */
+static guint
+count_view_entries (GArray *render_list, guint start)
+{
+  PhocView *view = g_array_index (render_list, PhocRenderEntry, start).view;
+  guint n = 0;
+
+  if (view == NULL)
+    return 0;
+
+  for (guint i = start; i < render_list->len; i++) {
+    PhocRenderEntry *entry = &g_array_index (render_list, PhocRenderEntry, i);
+
+    if (entry->surface == NULL || entry->view != view)
+      break;
+    n++;
+  }
+
+  return n;
+}
+
+/*
+ * Whether the view is shown on outputs with different scales. The
+ * cache only holds the view at a single scale so it would get
+ * rerendered for each of these outputs on every frame.
+ */
+static gboolean
+is_on_mixed_scale_outputs (PhocView *view)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  struct wlr_box view_box, output_box, intersection;
+  PhocOutput *output;
+  float scale = 0.0;
+
+  phoc_view_get_box (view, &view_box);
+  wl_list_for_each (output, &desktop->outputs, link) {
+    if (!output->wlr_output->enabled)
+      continue;
+
+    wlr_output_layout_get_box (desktop->layout, output->wlr_output, &output_box);
+    if (!wlr_box_intersection (&intersection, &view_box, &output_box))
+      continue;
+
+    if (scale == 0.0)
+      scale = output->wlr_output->scale;
+    else if (scale != output->wlr_output->scale)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+ * should_cache_view:
+ * @entry: The first surface entry of a view
+ * @n_entries: The number of surface entries of the view
+ *
+ * Translucent views are composited from an offscreen copy so
+ * overlapping subsurfaces don't shine through each other and fades
+ * only need to paint a single texture. Opaque views are cheaper to
+ * paint directly and so are views spanning outputs with different
+ * scales.
+ *
+ * Returns: %TRUE if the view should be rendered via its cache
+ */
+static gboolean
+should_cache_view (PhocRenderEntry *entry, guint n_entries)
+{
+  float alpha;
+
+  if (n_entries < 2)
+    return FALSE;
+
+  alpha = phoc_view_get_alpha (entry->view);
+  if (alpha <= 0.0 || alpha >= 1.0)
+    return FALSE;
+
+  return !is_on_mixed_scale_outputs (entry->view);
+}
+
+/**
+ * get_view_cache_box:
+ * @output: The output the view is rendered on
+ * @entries: The view's surface entries
+ * @n_entries: The number of entries
+ * @box: (out): The area covered by the entries in output local coordinates
+ * @cache_box: (out): The same area relative to the view's origin
+ *
+ * Gets the bounding box of the given surfaces ignoring the view's scale.
+ */
+static void
+get_view_cache_box (PhocOutput      *output,
+                    PhocRenderEntry *entries,
+                    guint            n_entries,
+                    struct wlr_box  *box,
+                    struct wlr_box  *cache_box)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocView *view = entries[0].view;
+  int x1 = G_MAXINT, y1 = G_MAXINT, x2 = G_MININT, y2 = G_MININT;
+  struct wlr_box output_box;
+
+  for (guint i = 0; i < n_entries; i++) {
+    struct wlr_box *entry_box = &entries[i].box;
+
+    x1 = MIN (x1, entry_box->x);
+    y1 = MIN (y1, entry_box->y);
+    x2 = MAX (x2, entry_box->x + entry_box->width);
+    y2 = MAX (y2, entry_box->y + entry_box->height);
+  }
+
+  *box = (struct wlr_box) { .x = x1, .y = y1, .width = x2 - x1, .height = y2 - y1 };
+
+  wlr_output_layout_get_box (desktop->layout, output->wlr_output, &output_box);
+  *cache_box = *box;
+  cache_box->x -= view->box.x - output_box.x;
+  cache_box->y -= view->box.y - output_box.y;
+}
+
+/**
+ * get_view_cache_key:
+ * @output: The output the view is rendered on
+ * @entries: The view's surface entries
+ * @n_entries: The number of entries
+ * @box: (out): The area covered by the entries in output local coordinates
+ * @key: (out): The key identifying the cached content
+ *
+ * Gets the key for the view's offscreen cache. Besides the covered
+ * area it tracks the surfaces' stacking, the view's scale-to-fit
+ * state and its blings so restacks and bling changes invalidate the
+ * cache even when the area stays the same.
+ */
+static void
+get_view_cache_key (PhocOutput       *output,
+                    PhocRenderEntry  *entries,
+                    guint             n_entries,
+                    struct wlr_box   *box,
+                    PhocViewCacheKey *key)
+{
+  PhocView *view = entries[0].view;
+
+  *key = (PhocViewCacheKey) {
+    .scale = output->wlr_output->scale,
+    .n_surfaces = n_entries,
+    .view_scale = entries[0].scale,
+    .n_blings = g_slist_length (phoc_view_get_blings (view)),
+  };
+  get_view_cache_box (output, entries, n_entries, box, &key->box);
+
+  for (guint i = 0; i < n_entries; i++)
+    key->stack = phoc_view_cache_add_to_stack (key->stack, entries[i].surface);
+}
+
+/**
+ * render_cached_view:
+ * @output: The output that is being rendered
+ * @entry: The first surface entry of a view
+ * @n_entries: The number of surface entries of the view
+ * @ctx: The render context
+ *
+ * Paints all surfaces of a view from the view's offscreen cache with
+ * a single texture. The cache is prepared by
+ * [method@Renderer.update_view_caches] before the output's render
+ * pass starts. The cached view takes a single slot in the occlusion
+ * culling state.
+ *
+ * Returns: %TRUE if the view was handled via its cache
+ */
+static gboolean
+render_cached_view (PhocOutput        *output,
+                    PhocRenderEntry   *entry,
+                    guint              n_entries,
+                    PhocRenderContext *ctx)
+{
+  PhocViewCache *cache;
+  struct wlr_box box, dst_box;
+  float scale = output->wlr_output->scale;
+  const pixman_region32_t *damage = ctx->damage;
+  PhocViewCacheKey key;
+
+  if (!should_cache_view (entry, n_entries))
+    return FALSE;
+
+  cache = phoc_view_get_offscreen_cache (entry->view);
+  get_view_cache_key (output, entry, n_entries, &box, &key);
+  if (!phoc_view_cache_is_valid (cache, &key))
+    return FALSE;
+
+  if (ctx->collect_opaque) {
+    pixman_region32_t opaque;
+
+    /* Translucent, hence never occludes anything */
+    pixman_region32_init (&opaque);
+    g_array_append_val (ctx->surface_damage, opaque);
+    return TRUE;
+  }
+
+  if (ctx->surface_damage && ctx->surface_index < ctx->surface_damage->len) {
+    damage = &g_array_index (ctx->surface_damage, pixman_region32_t, ctx->surface_index);
+    ctx->surface_index++;
+  }
+
+  if (pixman_region32_not_empty (damage)) {
+    dst_box = box;
+    phoc_utils_scale_box (&dst_box, entry->scale);
+    phoc_utils_scale_box (&dst_box, scale);
+    phoc_output_transform_box (output, &dst_box);
+
+    render_texture (output,
+                    cache->texture,
+                    &(struct wlr_fbox) {
+                      .width = cache->texture->width,
+                      .height = cache->texture->height,
+                    },
+                    &dst_box,
+                    &dst_box,
+                    WL_OUTPUT_TRANSFORM_NORMAL,
+                    ctx->alpha,
+                    damage,
+                    ctx);
+  }
+
+  for (guint i = 0; i < n_entries; i++)
+    wlr_presentation_surface_scanned_out_on_output (entry[i].surface, output->wlr_output);
+
+  return TRUE;
+}
+
+/**
+ * update_view_cache:
+ * @self: The renderer
+ * @output: The output the view is rendered on
+ * @entries: The view's surface entries
+ * @n_entries: The number of entries
+ *
+ * Renders the view's surfaces into its offscreen cache unless the
+ * cache is still up to date.
+ */
+static void
+update_view_cache (PhocRenderer    *self,
+                   PhocOutput      *output,
+                   PhocRenderEntry *entries,
+                   guint            n_entries)
+{
+  PhocViewCache *cache = phoc_view_get_offscreen_cache (entries[0].view);
+  float scale = output->wlr_output->scale;
+  struct wlr_box box, buffer_box;
+  struct wlr_render_pass *render_pass;
+  PhocViewCacheKey key;
+
+  get_view_cache_key (output, entries, n_entries, &box, &key);
+  if (phoc_view_cache_is_valid (cache, &key))
+    return;
+
+  cache->dirty = TRUE;
+  buffer_box = (struct wlr_box) { .width = box.width, .height = box.height };
+  phoc_utils_scale_box (&buffer_box, scale);
+  if (wlr_box_empty (&buffer_box))
+    return;
+
+  /* The texture gets recreated after rendering */
+  g_clear_pointer (&cache->texture, wlr_texture_destroy);
+
+  if (cache->buffer == NULL ||
+      cache->buffer->width != buffer_box.width ||
+      cache->buffer->height != buffer_box.height) {
+    struct wlr_drm_format_set fmt_set = {};
+    const struct wlr_drm_format *fmt;
+
+    g_clear_pointer (&cache->buffer, wlr_buffer_drop);
+
+    wlr_drm_format_set_add (&fmt_set, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR);
+    fmt = wlr_drm_format_set_get (&fmt_set, DRM_FORMAT_ARGB8888);
+    cache->buffer = wlr_allocator_create_buffer (self->wlr_allocator,
+                                                 buffer_box.width,
+                                                 buffer_box.height,
+                                                 fmt);
+    wlr_drm_format_set_finish (&fmt_set);
+    if (!cache->buffer) {
+      g_warning ("Failed to allocate view cache buffer");
+      return;
+    }
+  }
+
+  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, cache->buffer, NULL);
+  if (!render_pass) {
+    g_warning ("Failed to start view cache render pass");
+    return;
+  }
+
+  wlr_render_pass_add_rect (render_pass, &(struct wlr_render_rect_options){
+      .color = { 0, 0, 0, 0 },
+      .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+    });
+
+  for (guint i = 0; i < n_entries; i++) {
+    struct wlr_surface *surface = entries[i].surface;
+    const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+    struct wlr_texture *texture = wlr_surface_get_texture (surface);
+    struct wlr_fbox src_box;
+    float alpha = 1.0;
+
+    if (!texture)
+      continue;
+
+    alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+    if (alpha_modifier_state)
+      alpha *= (float)alpha_modifier_state->multiplier;
+
+    struct wlr_box dst_box = {
+      .x = entries[i].box.x - box.x,
+      .y = entries[i].box.y - box.y,
+      .width = entries[i].box.width,
+      .height = entries[i].box.height,
+    };
+    phoc_utils_scale_box (&dst_box, scale);
+    wlr_surface_get_buffer_source_box (surface, &src_box);
+
+    wlr_render_pass_add_texture (render_pass, &(struct wlr_render_texture_options) {
+        .texture = texture,
+        .src_box = src_box,
+        .dst_box = dst_box,
+        .transform = wlr_output_transform_invert (surface->current.transform),
+        .alpha = &alpha,
+        .filter_mode = phoc_output_get_texture_filter_mode (output),
+      });
+  }
+
+  if (!wlr_render_pass_submit (render_pass)) {
+    g_warning ("Failed to render view cache");
+    return;
+  }
+
+  cache->texture = wlr_texture_from_buffer (self->wlr_renderer, cache->buffer);
+  if (!cache->texture)
+    return;
+
+  cache->key = key;
+  cache->dirty = FALSE;
+}
+
+/**
+ * phoc_renderer_update_view_caches:
+ * @self: The renderer
+ * @output: The output about to be rendered
+ *
+ * Updates the offscreen caches of all views on @output that will be
+ * composited from their cache. This needs to happen before the
+ * output's render pass starts.
+ */
+void
+phoc_renderer_update_view_caches (PhocRenderer *self, PhocOutput *output)
+{
+  GArray *render_list;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  render_list = phoc_output_get_render_list (output);
+  for (guint i = 0; i < render_list->len; i++) {
+    PhocRenderEntry *entry = &g_array_index (render_list, PhocRenderEntry, i);
+    guint n_entries;
+
+    if (entry->surface == NULL)
+      continue;
+
+    n_entries = count_view_entries (render_list, i);
+    if (!should_cache_view (entry, n_entries))
+      continue;
+
+    update_view_cache (self, output, entry, n_entries);
+    i += n_entries - 1;
+  }
+}
+
+/**
+ * render_scene:
+ * @self: The renderer
+ * @output: The output to render
+ * @ctx: The render context
+ *
+ * Walks the output's render list in paint order. This is used for
+ * both the opaque region collection and the actual painting so the
+ * order of surfaces matches in both passes.
+ */
+static void
+render_scene (PhocRenderer *self, PhocOutput *output, PhocRenderContext *ctx)
+{
+  GArray *render_list = phoc_output_get_render_list (output);
+
+  for (guint i = 0; i < render_list->len; i++) {
+    PhocRenderEntry *entry = &g_array_index (render_list, PhocRenderEntry, i);
+    guint n_entries;
+
+    /* Blings like decorations use their view's alpha too */
+    ctx->alpha = get_render_entry_alpha (entry);
+
+    if (entry->surface == NULL) {
+      render_blings (output, entry->view, ctx);
+      continue;
+    }
+
+    n_entries = count_view_entries (render_list, i);
+    if (render_cached_view (output, entry, n_entries, ctx)) {
+      i += n_entries - 1;
+      continue;
+    }
+
+    render_entry (output, entry, ctx);
+  }
+}
+
+/**
+ * cull_occluded_damage:
+ * @ctx: The render context holding the collected opaque regions
+ * @uncovered: (out caller-allocates): The damage not covered by any opaque surface
+ *
+ * Walks the collected opaque regions front to back and replaces each
+ * of them by the part of the damage the surface still needs to paint.
+ */
+static void
+cull_occluded_damage (PhocRenderContext *ctx, pixman_region32_t *uncovered)
+{
+  pixman_region32_t covered;
+
+  pixman_region32_init (&covered);
+
+  for (int i = ctx->surface_damage->len - 1; i >= 0; i--) {
+    pixman_region32_t *region = &g_array_index (ctx->surface_damage, pixman_region32_t, i);
+    pixman_region32_t opaque = *region;
+
+    pixman_region32_init (region);
+    pixman_region32_subtract (region, ctx->damage, &covered);
+    pixman_region32_union (&covered, &covered, &opaque);
+    pixman_region32_fini (&opaque);
+  }
+
+  pixman_region32_subtract (uncovered, ctx->damage, &covered);
+  pixman_region32_fini (&covered);
+}
+
 /**
  * phoc_renderer_render_output:
  * @self: The renderer
@@ -550,6 +1343,10 @@ render_damage (PhocRenderer *self, PhocRenderContext *ctx)
  * @context: The render context provided by the output
  *
  * Render a given output.
+ *
+ * Before painting the surfaces' opaque regions are collected so that
+ * damage covered by opaque surfaces further up in the stack isn't
+ * painted at all.
  */
 void
 phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderContext *ctx)
@@ -557,9 +1354,8 @@ phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderC
   gint64 begin_time_nsec G_GNUC_UNUSED = PHOC_TRACE_CURRENT_TIME;
   PhocServer *server = phoc_server_get_default ();
   struct wlr_output *wlr_output = output->wlr_output;
-  PhocDesktop *desktop = phoc_server_get_desktop (server);
-  PhocWorkspace *workspace = phoc_desktop_get_active_workspace (desktop);
   pixman_region32_t *damage = ctx->damage;
+  pixman_region32_t uncovered;
 
   g_assert (PHOC_IS_RENDERER (self));
 
@@ -568,59 +1364,31 @@ phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderC
     return;
   }
 
-  wlr_render_pass_add_rect (ctx->render_pass,
-                            &(struct wlr_render_rect_options){
-                              .box = { .width = wlr_output->width, .height = wlr_output->height },
-                              .color = COLOR_BLACK,
-                              .clip = damage,
-                            });
-
-  /* If a view is fullscreen on this output, render it */
-  if (output->fullscreen_view && phoc_workspace_has_view (workspace, output->fullscreen_view)) {
-    PhocView *view = output->fullscreen_view;
-
-    render_view (output, view, ctx);
-
-    /* During normal rendering the xwayland window tree isn't traversed
-     * because all windows are rendered. Here we only want to render
-     * the fullscreen window's children so we have to traverse the tree. */
-#ifdef PHOC_XWAYLAND
-    if (PHOC_IS_XWAYLAND_SURFACE (view)) {
-      struct wlr_xwayland_surface *xsurface =
-        phoc_xwayland_surface_get_wlr_surface (PHOC_XWAYLAND_SURFACE (view));
-      phoc_output_xwayland_children_for_each_surface (output,
-                                                      xsurface,
-                                                      render_surface_iterator,
-                                                      ctx);
-    }
-#endif
-
-    if (phoc_output_has_shell_revealed (output)) {
-      /* Render top layer above fullscreen view when requested */
-      render_layer (ZWLR_LAYER_SHELL_V1_LAYER_TOP, ctx);
-    }
-  } else {
-    /* Render background and bottom layers under views */
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, ctx);
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, ctx);
-
-    /* Render all views */
-    for (GList *l = phoc_workspace_get_views (workspace)->tail; l; l = l->prev) {
-      PhocView *view = PHOC_VIEW (l->data);
-
-      if (phoc_desktop_view_check_visibility (desktop, view))
-        render_view (output, view, ctx);
-    }
-
-    /* Render unmanaged XWayland surfaces */
-    render_unmanaged_surfaces (self, workspace, ctx);
-
-    /* Render top layer above views */
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_TOP, ctx);
+  /* Collect opaque regions in paint order */
+  g_array_set_size (self->surface_damage, 0);
+  ctx->surface_damage = self->surface_damage;
+  ctx->surface_index = 0;
+  ctx->collect_opaque = TRUE;
+  render_scene (self, output, ctx);
+  ctx->collect_opaque = FALSE;
+
+  pixman_region32_init (&uncovered);
+  cull_occluded_damage (ctx, &uncovered);
+
+  if (pixman_region32_not_empty (&uncovered)) {
+    wlr_render_pass_add_rect (ctx->render_pass,
+                              &(struct wlr_render_rect_options){
+                                .box = { .width = wlr_output->width, .height = wlr_output->height },
+                                .color = COLOR_BLACK,
+                                .clip = &uncovered,
+                              });
   }
-  render_drag_icons (phoc_server_get_input (server), ctx);
+  pixman_region32_fini (&uncovered);
 
-  render_layer (ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ctx);
+  render_scene (self, output, ctx);
+
+  /* Everything below isn't subject to occlusion culling */
+  ctx->surface_damage = NULL;
 
   render_output_blings (output, ctx);
 
@@ -677,10 +1445,14 @@ phoc_renderer_finalize (GObject *object)
   wl_list_remove (&self->renderer_lost.link);
 
   g_clear_handle_id (&self->renderer_recreate_id, g_source_remove);
+  g_clear_handle_id (&self->thumbnail_timeout_id, g_source_remove);
 
+  drain_thumbnail_pool (self);
   g_clear_pointer (&self->wlr_allocator, wlr_allocator_destroy);
   g_clear_pointer (&self->wlr_renderer, wlr_renderer_destroy);
 
+  g_clear_pointer (&self->surface_damage, g_array_unref);
+
   G_OBJECT_CLASS (phoc_renderer_parent_class)->finalize (object);
 }
 
@@ -735,6 +1507,10 @@ static void
 phoc_renderer_init (PhocRenderer *self)
 {
   wl_list_init (&self->renderer_lost.link);
+
+  self->surface_damage = g_array_new (FALSE, FALSE, sizeof (pixman_region32_t));
+  g_array_set_clear_func (self->surface_damage, (GDestroyNotify)pixman_region32_fini);
+  g_queue_init (&self->thumbnail_pool);
 }
 
 
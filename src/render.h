@@ -25,6 +25,11 @@ typedef struct _PhocRenderContext {
   float                       alpha;
   struct wlr_render_pass     *render_pass;
   enum wlr_scale_filter_mode  tex_filter;
+
+  /* Occlusion culling state, private to the renderer */
+  GArray                     *surface_damage; /* (element-type pixman_region32_t) */
+  guint                       surface_index;
+  gboolean                    collect_opaque;
 } PhocRenderContext;
 
 
@@ -33,8 +38,17 @@ PhocRenderer *phoc_renderer_new (struct wlr_backend *wlr_backend, GError **error
 void          phoc_renderer_render_output (PhocRenderer      *self,
                                            PhocOutput        *output,
                                            PhocRenderContext *context);
+void          phoc_renderer_update_view_caches (PhocRenderer *self,
+                                                PhocOutput   *output);
 gboolean      phoc_renderer_render_view_to_buffer (PhocRenderer           *self,
                                                    PhocView               *view,
-                                                   struct wlr_buffer      *data);
+                                                   struct wlr_buffer      *buffer,
+                                                   guint                  *serial,
+                                                   pixman_region32_t      *damage);
+gboolean      phoc_renderer_has_view_thumbnail (PhocRenderer *self,
+                                                PhocView     *view,
+                                                int           width,
+                                                int           height,
+                                                guint         serial);
 
 G_END_DECLS
@@ -257,6 +257,19 @@ handle_touch_motion (struct wl_listener *listener, void *data)
 }
 
 
+static void
+handle_touch_cancel (struct wl_listener *listener, void *data)
+{
+  PhocCursor *cursor = wl_container_of (listener, cursor, touch_cancel);
+  struct wlr_touch_cancel_event *event = data;
+
+  if (!phoc_cursor_is_active_touch_id (cursor, event->touch_id))
+    return;
+
+  phoc_cursor_handle_touch_cancel (cursor, event);
+}
+
+
 static void
 handle_tablet_tool_position (PhocCursor             *cursor,
                              PhocTablet             *tablet,
@@ -598,6 +611,9 @@ phoc_seat_init_cursor (PhocSeat *seat)
   wl_signal_add (&wlr_cursor->events.touch_motion, &seat->cursor->touch_motion);
   seat->cursor->touch_motion.notify = handle_touch_motion;
 
+  wl_signal_add (&wlr_cursor->events.touch_cancel, &seat->cursor->touch_cancel);
+  seat->cursor->touch_cancel.notify = handle_touch_cancel;
+
   wl_signal_add (&wlr_cursor->events.tablet_tool_axis, &seat->cursor->tool_axis);
   seat->cursor->tool_axis.notify = handle_tool_axis;
 
@@ -853,6 +869,7 @@ on_pointer_destroy (PhocTouch *pointer)
   g_assert (PHOC_IS_POINTER (pointer));
   g_debug ("Removing pointer device: %s", device->name);
   seat->pointers = g_slist_remove (seat->pointers, pointer);
+  phoc_cursor_drop_pending_motion (seat->cursor, device);
   wlr_cursor_detach_input_device (seat->cursor->cursor, device);
   g_object_unref (pointer);
 
@@ -926,6 +943,7 @@ on_touch_destroy (PhocTouch *touch)
   g_hash_table_remove (priv->input_mapping_settings, touch);
 
   seat->touch = g_slist_remove (seat->touch, touch);
+  phoc_cursor_drop_pending_motion (seat->cursor, device);
   wlr_cursor_detach_input_device (seat->cursor->cursor, device);
   g_object_unref (touch);
 
@@ -12,6 +12,8 @@
 #include "phoc-config.h"
 #include "phoc-enums.h"
 #include "debug-control.h"
+#include "loop-monitor.h"
+#include "phoc-priorities.h"
 #include "render-private.h"
 #include "seat.h"
 #include "server-private.h"
@@ -118,6 +120,9 @@ G_DEFINE_TYPE_WITH_CODE (PhocServer, phoc_server, G_TYPE_OBJECT,
 typedef struct {
   GSource source;
   struct wl_display *display;
+  /* Interned once so accounting doesn't look them up on every dispatch */
+  const char *idle_sample_name;
+  const char *dispatch_sample_name;
 } WaylandEventSource;
 
 
@@ -148,12 +153,17 @@ wayland_event_source_prepare (GSource *base,
 {
   WaylandEventSource *source = (WaylandEventSource *)base;
   struct wl_event_loop *loop = wl_display_get_event_loop (source->display);
+  gint64 start_us = g_get_monotonic_time ();
 
   *timeout = -1;
 
   wl_event_loop_dispatch_idle (loop);
   wl_display_flush_clients (source->display);
 
+  phoc_loop_monitor_add_sample (phoc_loop_monitor_get_default (),
+                                source->idle_sample_name,
+                                g_get_monotonic_time () - start_us);
+
   return FALSE;
 }
 
@@ -164,9 +174,14 @@ wayland_event_source_dispatch (GSource     *base,
 {
   WaylandEventSource *source = (WaylandEventSource *)base;
   struct wl_event_loop *loop = wl_display_get_event_loop (source->display);
+  gint64 start_us = g_get_monotonic_time ();
 
   wl_event_loop_dispatch (loop, 0);
 
+  phoc_loop_monitor_add_sample (phoc_loop_monitor_get_default (),
+                                source->dispatch_sample_name,
+                                g_get_monotonic_time () - start_us);
+
   return TRUE;
 }
 
@@ -184,7 +199,11 @@ wayland_event_source_new (struct wl_display *display)
   source = (WaylandEventSource *) g_source_new (&wayland_event_source_funcs,
                                                 sizeof (WaylandEventSource));
   g_source_set_name (&source->source, "[phoc] wayland source");
+  /* Input and frame events shouldn't wait for D-Bus or GSettings */
+  g_source_set_priority (&source->source, PHOC_PRIORITY_INTERACTIVE);
   source->display = display;
+  source->idle_sample_name = g_intern_static_string ("[phoc] wayland idle and flush");
+  source->dispatch_sample_name = g_intern_static_string ("[phoc] wayland source");
   g_source_add_unix_fd (&source->source,
                         wl_event_loop_get_fd (loop),
                         G_IO_IN | G_IO_ERR);
@@ -133,6 +133,8 @@ phoc_output_config_new (const char *name)
   oc->y = -1;
   oc->scale_filter = PHOC_OUTPUT_SCALE_FILTER_AUTO;
   oc->drm_panel_orientation = false;
+  oc->damage_max_rects = PHOC_OUTPUT_CONFIG_DAMAGE_MAX_RECTS;
+  oc->damage_fill_ratio = PHOC_OUTPUT_CONFIG_DAMAGE_FILL_RATIO;
 
   return oc;
 }
@@ -162,6 +164,12 @@ config_ini_handler (PhocConfig *config, const char *section, const char *name, c
       } else {
         g_critical ("got unknown xwayland value: %s", value);
       }
+    } else if (g_str_equal (name, "hidden-frame-rate")) {
+      config->hidden_frame_rate = strtof (value, NULL);
+      if (config->hidden_frame_rate < 0) {
+        g_warning ("Invalid hidden-frame-rate %s", value);
+        config->hidden_frame_rate = 0;
+      }
     } else {
       g_critical ("got unknown core config: %s", name);
     }
@@ -250,6 +258,18 @@ config_ini_handler (PhocConfig *config, const char *section, const char *name, c
       oc->phys_height = strtol (value, NULL, 10);
     } else if (g_str_equal (name, "adaptive-sync")) {
       oc->adaptive_sync = parse_adapative_sync (value);
+    } else if (g_str_equal (name, "output-layers")) {
+      oc->output_layers = parse_boolean (value, false);
+    } else if (g_str_equal (name, "render-margin")) {
+      oc->render_margin = strtof (value, NULL);
+      if (oc->render_margin < 0) {
+        g_warning ("Invalid render-margin %s for output %s", value, oc->name);
+        oc->render_margin = 0;
+      }
+    } else if (g_str_equal (name, "damage-max-rects")) {
+      oc->damage_max_rects = strtoul (value, NULL, 10);
+    } else if (g_str_equal (name, "damage-fill-ratio")) {
+      oc->damage_fill_ratio = CLAMP (strtof (value, NULL), 0.0, 1.0);
     } else {
       g_warning ("Unknown key '%s' in section '%s'", name, section);
     }
@@ -269,6 +289,7 @@ phoc_config_new_from_keyfile (GKeyFile *keyfile)
 
   config->xwayland = true;
   config->xwayland_lazy = true;
+  config->hidden_frame_rate = PHOC_CONFIG_HIDDEN_FRAME_RATE;
 
   sections = g_key_file_get_groups (keyfile, NULL);
   for (int i = 0; i < g_strv_length (sections); i++) {
@@ -8,6 +8,11 @@
 
 G_BEGIN_DECLS
 
+#define PHOC_OUTPUT_CONFIG_DAMAGE_MAX_RECTS  32
+#define PHOC_OUTPUT_CONFIG_DAMAGE_FILL_RATIO 0.8
+
+#define PHOC_CONFIG_HIDDEN_FRAME_RATE        1.0
+
 #define PHOC_CONFIG_DEFAULT_SEAT_NAME "seat0"
 
 typedef struct _PhocOutputModeConfig {
@@ -37,11 +42,16 @@ typedef struct _PhocOutputConfig {
 
   guint                    phys_width, phys_height;
   gboolean                 adaptive_sync;
+  bool                     output_layers;
+  float                    render_margin; /* ms */
+  guint                    damage_max_rects;
+  float                    damage_fill_ratio;
 } PhocOutputConfig;
 
 typedef struct _PhocConfig {
   bool             xwayland;
   bool             xwayland_lazy;
+  float            hidden_frame_rate; /* Hz */
 
   GSList          *outputs;
 
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-spatial-index"
+
+#include "phoc-config.h"
+
+#include "spatial-index.h"
+
+#include <math.h>
+
+/* Items covering more cells than this are checked on every lookup */
+#define PHOC_SPATIAL_INDEX_MAX_CELLS 256
+
+typedef struct {
+  gpointer       item;
+  struct wlr_box box;
+  /* The covered cells, inclusive */
+  int            x1, y1, x2, y2;
+  gboolean       oversized;
+} PhocSpatialIndexEntry;
+
+typedef struct {
+  gint64         key;
+  GPtrArray     *entries;
+} PhocSpatialIndexCell;
+
+struct _PhocSpatialIndex {
+  int            cell_size;
+  GHashTable    *entries;   /* item → PhocSpatialIndexEntry */
+  GHashTable    *cells;     /* cell key → PhocSpatialIndexCell */
+  GPtrArray     *oversized; /* PhocSpatialIndexEntry */
+  GPtrArray     *hits;      /* items */
+};
+
+
+static void
+phoc_spatial_index_cell_free (PhocSpatialIndexCell *cell)
+{
+  g_ptr_array_free (cell->entries, TRUE);
+  g_free (cell);
+}
+
+
+static inline int
+cell_coord (PhocSpatialIndex *self, int v)
+{
+  /* Round towards negative infinity so negative coordinates work too */
+  if (v >= 0)
+    return v / self->cell_size;
+
+  return -((-v - 1) / self->cell_size) - 1;
+}
+
+
+static inline gint64
+cell_key (int cx, int cy)
+{
+  /* Shifting negative values is undefined so do it unsigned */
+  return ((guint64)(guint32)cx << 32) | (guint32)cy;
+}
+
+
+static void
+link_entry (PhocSpatialIndex *self, PhocSpatialIndexEntry *entry)
+{
+  gint64 n_cells;
+
+  entry->x1 = cell_coord (self, entry->box.x);
+  entry->y1 = cell_coord (self, entry->box.y);
+  entry->x2 = cell_coord (self, entry->box.x + entry->box.width - 1);
+  entry->y2 = cell_coord (self, entry->box.y + entry->box.height - 1);
+
+  n_cells = (gint64)(entry->x2 - entry->x1 + 1) * (entry->y2 - entry->y1 + 1);
+  entry->oversized = n_cells > PHOC_SPATIAL_INDEX_MAX_CELLS;
+  if (entry->oversized) {
+    g_ptr_array_add (self->oversized, entry);
+    return;
+  }
+
+  for (int cx = entry->x1; cx <= entry->x2; cx++) {
+    for (int cy = entry->y1; cy <= entry->y2; cy++) {
+      gint64 key = cell_key (cx, cy);
+      PhocSpatialIndexCell *cell = g_hash_table_lookup (self->cells, &key);
+
+      if (cell == NULL) {
+        cell = g_new0 (PhocSpatialIndexCell, 1);
+        cell->key = key;
+        cell->entries = g_ptr_array_new ();
+        g_hash_table_insert (self->cells, &cell->key, cell);
+      }
+      g_ptr_array_add (cell->entries, entry);
+    }
+  }
+}
+
+
+static void
+unlink_entry (PhocSpatialIndex *self, PhocSpatialIndexEntry *entry)
+{
+  if (entry->oversized) {
+    g_ptr_array_remove_fast (self->oversized, entry);
+    return;
+  }
+
+  for (int cx = entry->x1; cx <= entry->x2; cx++) {
+    for (int cy = entry->y1; cy <= entry->y2; cy++) {
+      gint64 key = cell_key (cx, cy);
+      PhocSpatialIndexCell *cell = g_hash_table_lookup (self->cells, &key);
+
+      g_assert (cell);
+      g_ptr_array_remove_fast (cell->entries, entry);
+      if (cell->entries->len == 0)
+        g_hash_table_remove (self->cells, &key);
+    }
+  }
+}
+
+/**
+ * phoc_spatial_index_new:
+ * @cell_size: The edge length of a grid cell in layout coordinates
+ *
+ * Create a new, empty spatial index.
+ *
+ * Returns: (transfer full): The new spatial index
+ */
+PhocSpatialIndex *
+phoc_spatial_index_new (int cell_size)
+{
+  PhocSpatialIndex *self = g_new0 (PhocSpatialIndex, 1);
+
+  g_assert (cell_size > 0);
+
+  self->cell_size = cell_size;
+  self->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+  self->cells = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL,
+                                       (GDestroyNotify)phoc_spatial_index_cell_free);
+  self->oversized = g_ptr_array_new ();
+  self->hits = g_ptr_array_new ();
+
+  return self;
+}
+
+/**
+ * phoc_spatial_index_free:
+ * @self: The spatial index
+ *
+ * Free the index. The indexed items aren't touched.
+ */
+void
+phoc_spatial_index_free (PhocSpatialIndex *self)
+{
+  g_hash_table_destroy (self->cells);
+  g_hash_table_destroy (self->entries);
+  g_ptr_array_free (self->oversized, TRUE);
+  g_ptr_array_free (self->hits, TRUE);
+  g_free (self);
+}
+
+/**
+ * phoc_spatial_index_update:
+ * @self: The spatial index
+ * @item: The item to index
+ * @box: The area covered by @item
+ *
+ * Add @item to the index or move it if it's already indexed. An empty
+ * @box removes the item.
+ */
+void
+phoc_spatial_index_update (PhocSpatialIndex *self, gpointer item, const struct wlr_box *box)
+{
+  PhocSpatialIndexEntry *entry;
+
+  g_assert (item);
+
+  if (wlr_box_empty (box)) {
+    phoc_spatial_index_remove (self, item);
+    return;
+  }
+
+  entry = g_hash_table_lookup (self->entries, item);
+  if (entry) {
+    if (wlr_box_equal (&entry->box, box))
+      return;
+
+    unlink_entry (self, entry);
+  } else {
+    entry = g_new0 (PhocSpatialIndexEntry, 1);
+    entry->item = item;
+    g_hash_table_insert (self->entries, item, entry);
+  }
+
+  entry->box = *box;
+  link_entry (self, entry);
+}
+
+/**
+ * phoc_spatial_index_remove:
+ * @self: The spatial index
+ * @item: The item to remove
+ *
+ * Remove @item from the index.
+ *
+ * Returns: %TRUE if the item was indexed, otherwise %FALSE
+ */
+gboolean
+phoc_spatial_index_remove (PhocSpatialIndex *self, gpointer item)
+{
+  PhocSpatialIndexEntry *entry = g_hash_table_lookup (self->entries, item);
+
+  if (entry == NULL)
+    return FALSE;
+
+  unlink_entry (self, entry);
+  g_hash_table_remove (self->entries, item);
+
+  return TRUE;
+}
+
+/**
+ * phoc_spatial_index_contains:
+ * @self: The spatial index
+ * @item: The item to look up
+ *
+ * Returns: %TRUE if @item is indexed, otherwise %FALSE
+ */
+gboolean
+phoc_spatial_index_contains (PhocSpatialIndex *self, gpointer item)
+{
+  return g_hash_table_contains (self->entries, item);
+}
+
+/**
+ * phoc_spatial_index_get_n_items:
+ * @self: The spatial index
+ *
+ * Returns: The number of indexed items
+ */
+guint
+phoc_spatial_index_get_n_items (PhocSpatialIndex *self)
+{
+  return g_hash_table_size (self->entries);
+}
+
+/**
+ * phoc_spatial_index_query_point:
+ * @self: The spatial index
+ * @x: The x coordinate
+ * @y: The y coordinate
+ *
+ * Look up the items whose box contains the given point. The order of
+ * the returned items is unspecified.
+ *
+ * Returns: (transfer none) (element-type gpointer): The matching
+ *   items. The array is only valid until the next call into the index.
+ */
+GPtrArray *
+phoc_spatial_index_query_point (PhocSpatialIndex *self, double x, double y)
+{
+  PhocSpatialIndexCell *cell;
+  gint64 key;
+
+  g_ptr_array_set_size (self->hits, 0);
+
+  if (x < G_MININT || x > G_MAXINT || y < G_MININT || y > G_MAXINT)
+    return self->hits;
+
+  key = cell_key (cell_coord (self, floor (x)), cell_coord (self, floor (y)));
+  cell = g_hash_table_lookup (self->cells, &key);
+
+  for (guint i = 0; cell && i < cell->entries->len; i++) {
+    PhocSpatialIndexEntry *entry = g_ptr_array_index (cell->entries, i);
+
+    if (wlr_box_contains_point (&entry->box, x, y))
+      g_ptr_array_add (self->hits, entry->item);
+  }
+
+  for (guint i = 0; i < self->oversized->len; i++) {
+    PhocSpatialIndexEntry *entry = g_ptr_array_index (self->oversized, i);
+
+    if (wlr_box_contains_point (&entry->box, x, y))
+      g_ptr_array_add (self->hits, entry->item);
+  }
+
+  return self->hits;
+}
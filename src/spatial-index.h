@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <wlr/util/box.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhocSpatialIndex:
+ *
+ * A uniform grid mapping boxes in layout coordinates to the items
+ * covering them so point lookups only need to look at a handful of
+ * candidates.
+ */
+typedef struct _PhocSpatialIndex PhocSpatialIndex;
+
+PhocSpatialIndex *phoc_spatial_index_new         (int                   cell_size);
+void              phoc_spatial_index_free        (PhocSpatialIndex     *self);
+void              phoc_spatial_index_update      (PhocSpatialIndex     *self,
+                                                  gpointer              item,
+                                                  const struct wlr_box *box);
+gboolean          phoc_spatial_index_remove      (PhocSpatialIndex     *self,
+                                                  gpointer              item);
+gboolean          phoc_spatial_index_contains    (PhocSpatialIndex     *self,
+                                                  gpointer              item);
+guint             phoc_spatial_index_get_n_items (PhocSpatialIndex     *self);
+GPtrArray *       phoc_spatial_index_query_point (PhocSpatialIndex     *self,
+                                                  double                x,
+                                                  double                y);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhocSpatialIndex, phoc_spatial_index_free)
+
+G_END_DECLS
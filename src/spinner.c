@@ -20,6 +20,7 @@
 #include "render-private.h"
 
 #include <cairo.h>
+#include <math.h>
 
 enum {
   PROP_0,
@@ -50,11 +51,26 @@ static GParamSpec *props[PROP_LAST_PROP];
  * (IDLE_DISTANCE + EXTEND_DISTANCE + CONTRACT_DISTANCE - OVERLAP_DISTANCE) * k,
  * where k is an integer */
 #define N_CYCLES 53
+#define ATLAS_ROTATION_STEPS PHOC_SPINNER_ATLAS_ROTATION_STEPS
+#define ATLAS_LENGTH_STEPS PHOC_SPINNER_ATLAS_LENGTH_STEPS
 
 /**
  * PhocSpinner:
  *
  * An animated spinner, used to represent indeterminate progress. It is rendered as a [type@Bling].
+ *
+ * To avoid rasterizing and uploading the spinner on every frame all
+ * needed frames are rendered into an atlas once when the spinner gets
+ * mapped. Each frame then only blits a cell of the atlas. If the atlas
+ * can't be created the spinner falls back to drawing each frame with
+ * cairo.
+ *
+ * The atlas holds frames for a quarter turn, the other quarters are
+ * rendered by rotating these. This quantizes the arc: its start is
+ * off by at most 3.75° which is below what it moves per frame at
+ * 60Hz and its length by at most 11.4°. Finer steps didn't look
+ * noticeably smoother but the atlas grows with their product and the
+ * square of the output scale.
  */
 struct _PhocSpinner {
   GObject             parent;
@@ -68,6 +84,10 @@ struct _PhocSpinner {
   float               angle;
   PhocCairoTexture   *texture;
   gboolean            redraw_spinner; /* set whenever angle changes */
+
+  PhocCairoTexture   *atlas;
+  int                 cell_size;
+  struct wlr_box      arc_box;        /* arc drawn into the fallback texture */
 };
 
 static void bling_interface_init (PhocBlingInterface *iface);
@@ -157,15 +177,25 @@ get_arc_end (double angle)
 
 
 static void
-draw_spinner (cairo_t *cr, double base_angle, double size)
+get_arc_angles (double base_angle, double *start_angle, double *end_angle)
+{
+  *start_angle = normalize_angle (base_angle + get_arc_start (base_angle) + START_ANGLE);
+  *end_angle = normalize_angle (base_angle + get_arc_end (base_angle) + START_ANGLE);
+}
+
+
+static void
+draw_frame (cairo_t        *cr,
+            double          start_angle,
+            double          end_angle,
+            double          size,
+            struct wlr_box *arc_box)
 {
   double radius, line_width;
-  double start_angle, end_angle;
+  double x1, y1, x2, y2;
 
-  cairo_save (cr);
-  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
-  cairo_paint (cr);
-  cairo_restore (cr);
+  if (arc_box)
+    *arc_box = (struct wlr_box) { 0 };
 
   radius = (float)size / 2;
   line_width = phoc_lerp (SMALL_WIDTH, LARGE_WIDTH,
@@ -184,20 +214,147 @@ draw_spinner (cairo_t *cr, double base_angle, double size)
   cairo_stroke (cr);
 
   /* animated arc */
-  start_angle = base_angle + get_arc_start (base_angle) + START_ANGLE;
-  end_angle = base_angle + get_arc_end (base_angle) + START_ANGLE;
-
-  start_angle = normalize_angle (start_angle);
-  end_angle = normalize_angle (end_angle);
-
   cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, .55);
   cairo_arc_negative (cr, 0, 0, radius - line_width / 2, start_angle, end_angle);
+  if (arc_box) {
+    cairo_stroke_extents (cr, &x1, &y1, &x2, &y2);
+    *arc_box = (struct wlr_box) {
+      .x = floor (x1 + size / 2),
+      .y = floor (y1 + size / 2),
+      .width = ceil (x2 + size / 2) - floor (x1 + size / 2),
+      .height = ceil (y2 + size / 2) - floor (y1 + size / 2),
+    };
+  }
   cairo_stroke (cr);
 
   cairo_restore (cr);
 }
 
 
+static void
+draw_spinner (cairo_t *cr, double base_angle, double size, struct wlr_box *arc_box)
+{
+  double start_angle, end_angle;
+
+  cairo_save (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  get_arc_angles (base_angle, &start_angle, &end_angle);
+  draw_frame (cr, start_angle, end_angle, size, arc_box);
+}
+
+
+static double
+atlas_rotation (int col)
+{
+  return col * (G_PI / 2) / ATLAS_ROTATION_STEPS;
+}
+
+
+static double
+atlas_length (int row)
+{
+  return phoc_lerp (MIN_ARC_LENGTH, MAX_ARC_LENGTH, (double)row / (ATLAS_LENGTH_STEPS - 1));
+}
+
+
+static PhocCairoTexture *
+create_atlas (int cell_size)
+{
+  g_autoptr (PhocCairoTexture) atlas = NULL;
+  cairo_t *cr;
+
+  atlas = phoc_cairo_texture_new (cell_size * ATLAS_ROTATION_STEPS,
+                                  cell_size * ATLAS_LENGTH_STEPS);
+  cr = phoc_cairo_texture_get_context (atlas);
+  if (!cr)
+    return NULL;
+
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  for (int row = 0; row < ATLAS_LENGTH_STEPS; row++) {
+    for (int col = 0; col < ATLAS_ROTATION_STEPS; col++) {
+      double start_angle = atlas_rotation (col);
+
+      cairo_save (cr);
+      cairo_translate (cr, col * cell_size, row * cell_size);
+      cairo_rectangle (cr, 0, 0, cell_size, cell_size);
+      cairo_clip (cr);
+      draw_frame (cr, start_angle, start_angle - atlas_length (row), cell_size, NULL);
+      cairo_restore (cr);
+    }
+  }
+
+  phoc_cairo_texture_update (atlas);
+  if (!phoc_cairo_texture_get_texture (atlas))
+    return NULL;
+
+  return g_steal_pointer (&atlas);
+}
+
+/*
+ * Find the atlas cell closest to the arc at the given angle and the
+ * quarter it needs to be rotated into.
+ */
+static void
+quantize_arc (double base_angle, int *col, int *row, int *quarter)
+{
+  double start_angle, end_angle, length;
+
+  get_arc_angles (base_angle, &start_angle, &end_angle);
+
+  length = start_angle - end_angle;
+  if (length < 0)
+    length += G_PI * 2;
+  *row = round (inverse_lerp (MIN_ARC_LENGTH, MAX_ARC_LENGTH, length) * (ATLAS_LENGTH_STEPS - 1));
+  *row = CLAMP (*row, 0, ATLAS_LENGTH_STEPS - 1);
+
+  *col = round (start_angle / atlas_rotation (1));
+  *quarter = (*col / ATLAS_ROTATION_STEPS) % 4;
+  *col %= ATLAS_ROTATION_STEPS;
+}
+
+
+static void
+get_atlas_cell (PhocSpinner *self, struct wlr_fbox *src_box, enum wl_output_transform *transform)
+{
+  int col, row, quarter;
+
+  quantize_arc (self->angle, &col, &row, &quarter);
+
+  *src_box = (struct wlr_fbox) {
+    .x = col * self->cell_size,
+    .y = row * self->cell_size,
+    .width = self->cell_size,
+    .height = self->cell_size,
+  };
+
+  /* Cairo angles go clockwise while output transforms rotate counter-clockwise */
+  *transform = (4 - quarter) % 4;
+}
+
+
+static void
+update_fallback_texture (PhocSpinner *self)
+{
+  cairo_t *cr = phoc_cairo_texture_get_context (self->texture);
+  struct wlr_box arc_box;
+
+  draw_spinner (cr, self->angle, self->cell_size, &arc_box);
+
+  /* Outside of the old and the new arc only the unchanged circle got redrawn */
+  phoc_cairo_texture_add_damage_box (self->texture, &self->arc_box);
+  phoc_cairo_texture_add_damage_box (self->texture, &arc_box);
+  phoc_cairo_texture_update (self->texture);
+
+  self->arc_box = arc_box;
+  self->redraw_spinner = FALSE;
+}
+
+
 static void
 bling_render (PhocBling *bling, PhocRenderContext *ctx)
 {
@@ -205,7 +362,18 @@ bling_render (PhocBling *bling, PhocRenderContext *ctx)
   struct wlr_render_texture_options options;
   struct wlr_box box = bling_get_box (bling);
   pixman_region32_t damage;
-  struct wlr_texture *texture = phoc_cairo_texture_get_texture (self->texture);
+  struct wlr_texture *texture;
+
+  if (self->atlas) {
+    texture = phoc_cairo_texture_get_texture (self->atlas);
+  } else if (self->texture) {
+    /* Update before fetching so the new frame doesn't go to the back texture */
+    if (self->redraw_spinner)
+      update_fallback_texture (self);
+    texture = phoc_cairo_texture_get_texture (self->texture);
+  } else {
+    return;
+  }
 
   if (!texture)
     return;
@@ -220,19 +388,15 @@ bling_render (PhocBling *bling, PhocRenderContext *ctx)
     return;
   }
 
-  /* only redraw spinner if needed (angle property was changed since last render) */
-  if (self->redraw_spinner) {
-    draw_spinner (phoc_cairo_texture_get_context (self->texture), self->angle, box.width);
-    phoc_cairo_texture_update (self->texture);
-    self->redraw_spinner = false;
-  }
-
   options = (struct wlr_render_texture_options) {
     .texture = texture,
     .dst_box = box,
     .clip    = &damage,
   };
 
+  if (self->atlas)
+    get_atlas_cell (self, &options.src_box, &options.transform);
+
   wlr_render_pass_add_texture (ctx->render_pass, &options);
 }
 
@@ -251,9 +415,15 @@ bling_map (PhocBling *bling)
 
   cairo_t *cr;
 
-  if (self->texture)
+  if (self->texture || self->atlas)
     return;
 
+  self->cell_size = size;
+  self->atlas = create_atlas (size);
+  if (self->atlas)
+    goto out;
+
+  g_debug ("Failed to create spinner atlas, drawing every frame");
   self->texture = phoc_cairo_texture_new (size, size);
   cr = phoc_cairo_texture_get_context (self->texture);
 
@@ -264,7 +434,11 @@ bling_map (PhocBling *bling)
 
   cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
   cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+  /* Nothing got uploaded yet */
+  self->arc_box = (struct wlr_box) { .width = size, .height = size };
+  self->redraw_spinner = TRUE;
 
+ out:
   phoc_bling_damage_box (PHOC_BLING (self));
   phoc_timed_animation_play (self->animation);
 }
@@ -275,10 +449,11 @@ bling_unmap (PhocBling *bling)
 {
   PhocSpinner *self = PHOC_SPINNER (bling);
 
-  if (!self->texture)
+  if (!self->texture && !self->atlas)
     return;
 
   g_clear_object (&self->texture);
+  g_clear_object (&self->atlas);
 
   phoc_bling_damage_box (PHOC_BLING (self));
   phoc_timed_animation_reset (self->animation);
@@ -290,7 +465,7 @@ bling_is_mapped (PhocBling *bling)
 {
   PhocSpinner *self = PHOC_SPINNER (bling);
 
-  return self->texture != NULL;
+  return self->texture != NULL || self->atlas != NULL;
 }
 
 
@@ -495,3 +670,31 @@ phoc_spinner_new (PhocAnimatable *animatable, int lx, int ly, int size)
                        "size", size,
                        NULL);
 }
+
+/**
+ * phoc_spinner_get_arc:
+ * @angle: The spinner's angle
+ * @from_atlas: Whether to get the arc as rendered from the atlas
+ * @start_angle: (out): The start of the arc in radians
+ * @length: (out): The length of the arc in radians
+ *
+ * Get the arc drawn at @angle. Used to check the atlas' quantization.
+ */
+void
+phoc_spinner_get_arc (double angle, gboolean from_atlas, double *start_angle, double *length)
+{
+  double end_angle;
+  int col, row, quarter;
+
+  if (!from_atlas) {
+    get_arc_angles (angle, start_angle, &end_angle);
+    *length = *start_angle - end_angle;
+    if (*length < 0)
+      *length += G_PI * 2;
+    return;
+  }
+
+  quantize_arc (angle, &col, &row, &quarter);
+  *start_angle = normalize_angle (atlas_rotation (col) + quarter * G_PI / 2);
+  *length = atlas_length (row);
+}
@@ -11,10 +11,18 @@
 
 G_BEGIN_DECLS
 
+/* Atlas cells per quarter turn and for the arc's length */
+#define PHOC_SPINNER_ATLAS_ROTATION_STEPS 12
+#define PHOC_SPINNER_ATLAS_LENGTH_STEPS 8
+
 #define PHOC_TYPE_SPINNER (phoc_spinner_get_type ())
 
 G_DECLARE_FINAL_TYPE (PhocSpinner, phoc_spinner, PHOC, SPINNER, GObject)
 
-PhocSpinner *phoc_spinner_new (PhocAnimatable *animatable, int cx, int cy, int size);
+PhocSpinner *phoc_spinner_new     (PhocAnimatable *animatable, int cx, int cy, int size);
+void         phoc_spinner_get_arc (double    angle,
+                                   gboolean  from_atlas,
+                                   double   *start_angle,
+                                   double   *length);
 
 G_END_DECLS
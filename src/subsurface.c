@@ -108,6 +108,8 @@ handle_parent_commit (struct wl_listener *listener, void *data)
   gboolean moved, reordered;
   int sx, sy;
 
+  /* The parent commit might have moved us */
+  phoc_view_child_invalidate_pos (PHOC_VIEW_CHILD (self));
   phoc_view_child_get_pos (PHOC_VIEW_CHILD (self), &sx, &sy);
 
   moved = (self->previous.x != sx || self->previous.y != sy);
@@ -125,6 +127,8 @@ handle_parent_commit (struct wl_listener *listener, void *data)
 
   if (wlr_subsurface->surface->mapped && (moved || reordered)) {
     wlr_surface_for_each_surface (wlr_surface, collect_damage_iter, self);
+    if (wlr_surface->data)
+      phoc_surface_invalidate_render_lists (PHOC_SURFACE (wlr_surface->data));
     phoc_view_child_apply_damage (PHOC_VIEW_CHILD (self));
   }
 }
@@ -10,6 +10,7 @@
 
 #include "phoc-config.h"
 
+#include "output.h"
 #include "surface.h"
 
 /**
@@ -31,7 +32,14 @@ struct _PhocSurface {
   struct wlr_surface *wlr_surface;
   pixman_region32_t   damage;
 
+  /* Statistics */
+  guint64             n_commits;
+  guint64             n_frame_done;
+  guint64             n_throttled_frame_done;
+  gint64              last_frame_done_us;
+
   struct wl_listener  commit;
+  struct wl_listener  unmap;
   struct wl_listener  destroy;
 };
 G_DEFINE_TYPE (PhocSurface, phoc_surface, G_TYPE_OBJECT)
@@ -43,11 +51,16 @@ handle_commit (struct wl_listener *listener, void *data)
   PhocSurface *self = wl_container_of (listener, self, commit);
   struct wlr_surface *wlr_surface = self->wlr_surface;
 
+  self->n_commits++;
+
   if (wlr_surface->WLR_PRIVATE.previous.width == wlr_surface->current.width &&
       wlr_surface->WLR_PRIVATE.previous.height == wlr_surface->current.height &&
       wlr_surface->current.dx == 0 && wlr_surface->current.dy ==  0)
     return;
 
+  /* Surface boxes changed */
+  phoc_surface_invalidate_render_lists (self);
+
   /* Damage surface size or contents offset changed */
   pixman_region32_union_rect (&self->damage,
                               &self->damage,
@@ -58,6 +71,16 @@ handle_commit (struct wl_listener *listener, void *data)
 }
 
 
+static void
+handle_unmap (struct wl_listener *listener, void *data)
+{
+  PhocSurface *self = wl_container_of (listener, self, unmap);
+
+  /* Render entries reference the surface */
+  phoc_surface_invalidate_render_lists (self);
+}
+
+
 static void
 handle_destroy (struct wl_listener *listener, void *data)
 {
@@ -65,6 +88,9 @@ handle_destroy (struct wl_listener *listener, void *data)
 
   g_debug ("Surface %p destroyed", self->wlr_surface);
 
+  /* Render entries reference the surface */
+  phoc_surface_invalidate_render_lists (self);
+
   g_object_unref (self);
 }
 
@@ -81,6 +107,9 @@ set_wlr_surface (PhocSurface *self, struct wlr_surface *wlr_surface)
   self->commit.notify = handle_commit;
   wl_signal_add (&self->wlr_surface->events.commit, &self->commit);
 
+  self->unmap.notify = handle_unmap;
+  wl_signal_add (&self->wlr_surface->events.unmap, &self->unmap);
+
   self->destroy.notify = handle_destroy;
   wl_signal_add (&self->wlr_surface->events.destroy, &self->destroy);
 }
@@ -132,6 +161,7 @@ phoc_surface_finalize (GObject *object)
   pixman_region32_fini (&self->damage);
 
   wl_list_remove (&self->commit.link);
+  wl_list_remove (&self->unmap.link);
   wl_list_remove (&self->destroy.link);
 
   self->wlr_surface = NULL;
@@ -227,3 +257,103 @@ phoc_surface_add_damage_box (PhocSurface *self, struct wlr_box *box)
   phoc_surface_add_damage (self, &damage);
   pixman_region32_fini (&damage);
 }
+
+/**
+ * phoc_surface_send_frame_done:
+ * @self: The surface
+ * @when: The time to send to the client
+ * @throttled: Whether this is a throttled frame callback for a
+ *   surface that isn't visible
+ *
+ * Send frame done events to the client for all pending frame
+ * callbacks of the surface and account for them in the surface's
+ * statistics.
+ */
+void
+phoc_surface_send_frame_done (PhocSurface *self, const struct timespec *when, gboolean throttled)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  self->last_frame_done_us = g_get_monotonic_time ();
+
+  if (wl_list_empty (&self->wlr_surface->current.frame_callback_list))
+    return;
+
+  if (throttled)
+    self->n_throttled_frame_done++;
+  else
+    self->n_frame_done++;
+
+  wlr_surface_send_frame_done (self->wlr_surface, when);
+}
+
+/**
+ * phoc_surface_get_last_frame_done:
+ * @self: The surface
+ *
+ * Get the time when frame done was last sent. This is updated even
+ * if the client didn't ask for a frame callback.
+ *
+ * Returns: The monotonic time in microseconds or `0` if never sent
+ */
+gint64
+phoc_surface_get_last_frame_done (PhocSurface *self)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  return self->last_frame_done_us;
+}
+
+/**
+ * phoc_surface_get_stats:
+ * @self: The surface
+ *
+ * Get the surface's statistics as dictionary containing:
+ *
+ * - commits (t): Number of commits
+ * - frame-done (t): Number of frame callbacks completed when the
+ *   surface got displayed
+ * - throttled-frame-done (t): Number of frame callbacks completed at
+ *   the reduced rate while the surface wasn't visible
+ *
+ * Returns: (transfer floating): The statistics
+ */
+GVariant *
+phoc_surface_get_stats (PhocSurface *self)
+{
+  GVariantBuilder builder;
+
+  g_assert (PHOC_IS_SURFACE (self));
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&builder, "{sv}", "commits", g_variant_new_uint64 (self->n_commits));
+  g_variant_builder_add (&builder, "{sv}", "frame-done", g_variant_new_uint64 (self->n_frame_done));
+  g_variant_builder_add (&builder, "{sv}", "throttled-frame-done",
+                         g_variant_new_uint64 (self->n_throttled_frame_done));
+
+  return g_variant_builder_end (&builder);
+}
+
+/**
+ * phoc_surface_invalidate_render_lists:
+ * @self: The surface
+ *
+ * Invalidate the render lists of the outputs the surface is on,
+ * e.g. because it got resized, restacked or unmapped. Surfaces are
+ * only rendered on outputs they entered so other outputs are not
+ * affected.
+ */
+void
+phoc_surface_invalidate_render_lists (PhocSurface *self)
+{
+  struct wlr_surface_output *surface_output;
+
+  g_assert (PHOC_IS_SURFACE (self));
+
+  wl_list_for_each (surface_output, &self->wlr_surface->current_outputs, link) {
+    PhocOutput *output = surface_output->output->data;
+
+    if (output)
+      phoc_output_invalidate_render_list (output);
+  }
+}
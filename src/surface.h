@@ -21,5 +21,11 @@ const pixman_region32_t *phoc_surface_get_damage (PhocSurface *self);
 void                     phoc_surface_add_damage (PhocSurface *self, pixman_region32_t *damage);
 void                     phoc_surface_add_damage_box (PhocSurface *self, struct wlr_box *box);
 void                     phoc_surface_clear_damage (PhocSurface *self);
+void                     phoc_surface_send_frame_done (PhocSurface           *self,
+                                                       const struct timespec *when,
+                                                       gboolean               throttled);
+gint64                   phoc_surface_get_last_frame_done (PhocSurface *self);
+GVariant                *phoc_surface_get_stats (PhocSurface *self);
+void                     phoc_surface_invalidate_render_lists (PhocSurface *self);
 
 G_END_DECLS
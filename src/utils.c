@@ -175,6 +175,64 @@ phoc_utils_is_damaged (const struct wlr_box    *box,
   return !pixman_region32_empty (out_damage);
 }
 
+/**
+ * phoc_utils_region_area:
+ * @region: The region
+ *
+ * Computes the area covered by a region.
+ *
+ * Returns: The area in pixels
+ */
+guint64
+phoc_utils_region_area (const pixman_region32_t *region)
+{
+  const pixman_box32_t *rects;
+  guint64 area = 0;
+  int n_rects;
+
+  rects = pixman_region32_rectangles ((pixman_region32_t *)region, &n_rects);
+  for (int i = 0; i < n_rects; i++)
+    area += (guint64)(rects[i].x2 - rects[i].x1) * (rects[i].y2 - rects[i].y1);
+
+  return area;
+}
+
+/**
+ * phoc_utils_region_simplify:
+ * @region: The region to simplify
+ * @max_rects: Maximum number of rectangles to keep
+ * @min_fill: Fill ratio at which to merge rectangles
+ *
+ * Replaces the region by its bounding box if it consists of more than
+ * `max_rects` rectangles or if the rectangles already fill at least
+ * `min_fill` of the bounding box. This bounds the cost of further
+ * region operations and of rendering with the region as clip at the
+ * expense of some overdraw.
+ *
+ * Returns: %TRUE if the region was simplified
+ */
+gboolean
+phoc_utils_region_simplify (pixman_region32_t *region, guint max_rects, float min_fill)
+{
+  pixman_box32_t *extents;
+  guint64 extents_area;
+  int n_rects;
+
+  n_rects = pixman_region32_n_rects (region);
+  if (n_rects < 2)
+    return FALSE;
+
+  extents = pixman_region32_extents (region);
+  if ((guint)n_rects <= max_rects) {
+    extents_area = (guint64)(extents->x2 - extents->x1) * (extents->y2 - extents->y1);
+    if (phoc_utils_region_area (region) < min_fill * extents_area)
+      return FALSE;
+  }
+
+  pixman_region32_reset (region, extents);
+  return TRUE;
+}
+
 
 void
 phoc_utils_wlr_surface_update_scales (struct wlr_surface *surface)
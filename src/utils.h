@@ -44,6 +44,10 @@ gboolean   phoc_utils_is_damaged            (const struct wlr_box    *box,
                                              const pixman_region32_t *damage,
                                              const struct wlr_box    *clip_box,
                                              pixman_region32_t       *out_damage);
+guint64    phoc_utils_region_area           (const pixman_region32_t *region);
+gboolean   phoc_utils_region_simplify       (pixman_region32_t       *region,
+                                             guint                    max_rects,
+                                             float                    min_fill);
 
 void       phoc_utils_wlr_surface_update_scales (struct wlr_surface *surface);
 void       phoc_utils_wlr_surface_enter_output  (struct wlr_surface *wlr_surface,
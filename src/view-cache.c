@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-view-cache"
+
+#include "phoc-config.h"
+
+#include "view-cache.h"
+
+/**
+ * phoc_view_cache_new:
+ *
+ * Create a new, empty view cache. The renderer fills it on demand.
+ *
+ * Returns: (transfer full): The new view cache
+ */
+PhocViewCache *
+phoc_view_cache_new (void)
+{
+  PhocViewCache *self = g_new0 (PhocViewCache, 1);
+
+  self->dirty = TRUE;
+  pixman_region32_init (&self->damage);
+  for (guint i = 0; i < PHOC_VIEW_CACHE_HISTORY; i++)
+    pixman_region32_init (&self->history[i].damage);
+
+  return self;
+}
+
+/**
+ * phoc_view_cache_free:
+ * @self: The view cache
+ *
+ * Free the cache and release the buffer holding the view's content.
+ */
+void
+phoc_view_cache_free (PhocViewCache *self)
+{
+  g_clear_pointer (&self->texture, wlr_texture_destroy);
+  if (self->buffer && self->release_func)
+    self->release_func (g_steal_pointer (&self->buffer), self->release_data);
+  g_clear_pointer (&self->buffer, wlr_buffer_drop);
+  pixman_region32_fini (&self->damage);
+  for (guint i = 0; i < PHOC_VIEW_CACHE_HISTORY; i++)
+    pixman_region32_fini (&self->history[i].damage);
+
+  g_free (self);
+}
+
+/**
+ * phoc_view_cache_invalidate:
+ * @self: The view cache
+ *
+ * Mark the cache as outdated. It will be rendered again the next time
+ * it's used.
+ */
+void
+phoc_view_cache_invalidate (PhocViewCache *self)
+{
+  self->dirty = TRUE;
+}
+
+/**
+ * phoc_view_cache_key_equal:
+ * @key1: A cache key
+ * @key2: Another cache key
+ *
+ * Returns: %TRUE if a cache rendered for @key1 can be used for @key2
+ */
+gboolean
+phoc_view_cache_key_equal (const PhocViewCacheKey *key1, const PhocViewCacheKey *key2)
+{
+  return wlr_box_equal (&key1->box, &key2->box) &&
+    G_APPROX_VALUE (key1->scale, key2->scale, FLT_EPSILON) &&
+    key1->n_surfaces == key2->n_surfaces &&
+    key1->stack == key2->stack &&
+    G_APPROX_VALUE (key1->view_scale, key2->view_scale, FLT_EPSILON) &&
+    key1->n_blings == key2->n_blings;
+}
+
+/**
+ * phoc_view_cache_add_to_stack:
+ * @stack: The stack identifier so far, `0` for the first surface
+ * @surface: The next surface in paint order
+ *
+ * Fold a surface into a [struct@ViewCacheKey]'s stack
+ * identifier. Unlike the number of surfaces this changes when
+ * surfaces get replaced or restacked.
+ *
+ * Returns: The new stack identifier
+ */
+guint64
+phoc_view_cache_add_to_stack (guint64 stack, gconstpointer surface)
+{
+  /* FNV-1a, so the order matters */
+  if (stack == 0)
+    stack = 14695981039346656037ULL;
+
+  return (stack ^ (guint64)GPOINTER_TO_SIZE (surface)) * 1099511628211ULL;
+}
+
+/**
+ * phoc_view_cache_is_valid:
+ * @self: The view cache
+ * @key: What the cache is needed for
+ *
+ * Check whether the cached content can be used as is.
+ *
+ * Returns: %TRUE if the cache is up to date
+ */
+gboolean
+phoc_view_cache_is_valid (PhocViewCache *self, const PhocViewCacheKey *key)
+{
+  if (self->dirty || self->texture == NULL)
+    return FALSE;
+
+  return phoc_view_cache_key_equal (&self->key, key);
+}
+
+/**
+ * phoc_view_cache_add_render:
+ * @self: The view cache
+ * @serial: The serial identifying the render
+ * @damage: The area that got rendered in buffer coordinates
+ *
+ * Record that the cache got rendered. The oldest render drops out of
+ * the history.
+ */
+void
+phoc_view_cache_add_render (PhocViewCache *self, guint serial, const pixman_region32_t *damage)
+{
+  g_assert (serial != 0);
+
+  for (guint i = PHOC_VIEW_CACHE_HISTORY - 1; i > 0; i--) {
+    self->history[i].serial = self->history[i - 1].serial;
+    pixman_region32_copy (&self->history[i].damage, &self->history[i - 1].damage);
+  }
+
+  self->history[0].serial = serial;
+  pixman_region32_copy (&self->history[0].damage, (pixman_region32_t *)damage);
+  self->serial = serial;
+}
+
+/**
+ * phoc_view_cache_get_damage_since:
+ * @self: The view cache
+ * @serial: The serial of a past render
+ * @damage:(out caller-allocates): The area rendered since then
+ *
+ * Get the area that changed since the render identified by @serial.
+ *
+ * Returns: %FALSE if @serial isn't in the history anymore so
+ *   everything needs to be considered changed
+ */
+gboolean
+phoc_view_cache_get_damage_since (PhocViewCache *self, guint serial, pixman_region32_t *damage)
+{
+  pixman_region32_clear (damage);
+
+  if (serial == 0)
+    return FALSE;
+
+  for (guint i = 0; i < PHOC_VIEW_CACHE_HISTORY && self->history[i].serial; i++) {
+    if (self->history[i].serial == serial)
+      return TRUE;
+
+    pixman_region32_union (damage, damage, &self->history[i].damage);
+  }
+
+  return FALSE;
+}
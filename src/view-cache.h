@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <pixman.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/render/wlr_texture.h>
+#include <wlr/util/box.h>
+
+G_BEGIN_DECLS
+
+/* Number of past renders whose damage is kept */
+#define PHOC_VIEW_CACHE_HISTORY 4
+
+typedef void (*PhocViewCacheReleaseFunc) (struct wlr_buffer *buffer, gpointer user_data);
+
+/**
+ * PhocViewCacheKey:
+ * @box: The area covered by the cache in layout coordinates relative
+ *    to the view's origin ignoring the view's scale
+ * @scale: The output scale the cache is rendered at
+ * @n_surfaces: The number of surfaces rendered into the cache
+ * @stack: Identifies the rendered surfaces and their stacking order
+ * @view_scale: The view's scale-to-fit scale
+ * @n_blings: The number of blings attached to the view
+ *
+ * Everything besides the surfaces' content the cached copy depends
+ * on. If any of it changes the cache needs to be rendered again.
+ */
+typedef struct {
+  struct wlr_box box;
+  float          scale;
+  guint          n_surfaces;
+  guint64        stack;
+  float          view_scale;
+  guint          n_blings;
+} PhocViewCacheKey;
+
+/**
+ * PhocViewCache:
+ * @buffer: The buffer holding the rendered view
+ * @texture: The texture used to sample from @buffer
+ * @key: What the cache got rendered for
+ * @dirty: Whether the view's content changed since the cache was rendered
+ * @damage: The damage accumulated since the cache was rendered in
+ *    coordinates relative to the view's geometry. Only tracked for
+ *    thumbnails.
+ * @serial: Identifies the last render of the cache, `0` if none.
+ *    Only tracked for thumbnails.
+ * @history: The serials and damage in buffer coordinates of the last
+ *    renders so consumers can find out what changed since the render
+ *    they saw last. Only tracked for thumbnails.
+ * @release_func: (nullable): Hands @buffer back to its owner when
+ *    the cache is freed. If unset the buffer gets dropped.
+ * @release_data: The data passed to @release_func
+ *
+ * An offscreen copy of a view's surface tree so the view can be
+ * composited as a single texture.
+ */
+typedef struct {
+  struct wlr_buffer  *buffer;
+  struct wlr_texture *texture;
+  PhocViewCacheKey    key;
+  gboolean            dirty;
+  pixman_region32_t   damage;
+
+  guint               serial;
+  struct {
+    guint             serial;
+    pixman_region32_t damage;
+  } history[PHOC_VIEW_CACHE_HISTORY];
+
+  PhocViewCacheReleaseFunc release_func;
+  gpointer                 release_data;
+} PhocViewCache;
+
+PhocViewCache *phoc_view_cache_new        (void);
+void           phoc_view_cache_free       (PhocViewCache *self);
+void           phoc_view_cache_invalidate (PhocViewCache *self);
+gboolean       phoc_view_cache_is_valid   (PhocViewCache          *self,
+                                           const PhocViewCacheKey *key);
+gboolean       phoc_view_cache_key_equal  (const PhocViewCacheKey *key1,
+                                           const PhocViewCacheKey *key2);
+guint64        phoc_view_cache_add_to_stack (guint64       stack,
+                                             gconstpointer surface);
+void           phoc_view_cache_add_render (PhocViewCache           *self,
+                                           guint                    serial,
+                                           const pixman_region32_t *damage);
+gboolean       phoc_view_cache_get_damage_since (PhocViewCache     *self,
+                                                 guint              serial,
+                                                 pixman_region32_t *damage);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhocViewCache, phoc_view_cache_free)
+
+G_END_DECLS
@@ -46,6 +46,7 @@ PhocChildRoot *       phoc_view_child_get_root (PhocViewChild *self);
 void                  phoc_view_child_apply_damage (PhocViewChild *self);
 void                  phoc_view_child_damage_whole (PhocViewChild *self);
 void                  phoc_view_child_get_pos (PhocViewChild *self, int *sx, int *sy);
+void                  phoc_view_child_invalidate_pos (PhocViewChild *self);
 PhocViewChild *       phoc_view_child_get_parent (PhocViewChild *self);
 struct wlr_surface *  phoc_view_child_get_wlr_surface (PhocViewChild *self);
 void                  phoc_view_child_set_mapped (PhocViewChild *self, bool mapped);
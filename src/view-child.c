@@ -50,6 +50,10 @@ typedef struct _PhocViewChildPrivate {
   struct wlr_surface           *wlr_surface;
   bool                          mapped;
 
+  /* Cached position relative to the root */
+  gboolean                      pos_valid;
+  int                           sx, sy;
+
   struct wl_listener            map;
   struct wl_listener            unmap;
   struct wl_listener            commit;
@@ -187,8 +191,14 @@ phoc_view_child_handle_commit (struct wl_listener *listener, void *data)
 {
   PhocViewChildPrivate *priv = wl_container_of (listener, priv, commit);
   PhocViewChild *self = PHOC_VIEW_CHILD_SELF (priv);
+  int sx, sy;
+
+  if (!phoc_view_child_is_mapped (self) || !phoc_child_root_is_mapped (priv->root))
+    return;
 
-  phoc_view_child_apply_damage (self);
+  /* Only this surface changed, no need to walk the whole tree */
+  phoc_view_child_get_pos (self, &sx, &sy);
+  phoc_child_root_apply_surface_damage (priv->root, priv->wlr_surface, sx, sy);
 }
 
 
@@ -398,12 +408,52 @@ phoc_view_child_damage_whole (PhocViewChild *self)
 }
 
 
+/**
+ * phoc_view_child_get_pos:
+ * @self: A view child
+ * @sx: (out): The x coordinate relative to the root
+ * @sy: (out): The y coordinate relative to the root
+ *
+ * Get the child's position relative to its root. The position is
+ * cached until [method@ViewChild.invalidate_pos] is invoked.
+ */
 void
 phoc_view_child_get_pos (PhocViewChild *self, int *sx, int *sy)
 {
+  PhocViewChildPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW_CHILD (self));
+  priv = phoc_view_child_get_instance_private (self);
+
+  if (!priv->pos_valid) {
+    PHOC_VIEW_CHILD_GET_CLASS (self)->get_pos (self, &priv->sx, &priv->sy);
+    priv->pos_valid = TRUE;
+  }
+
+  *sx = priv->sx;
+  *sy = priv->sy;
+}
+
+/**
+ * phoc_view_child_invalidate_pos:
+ * @self: A view child
+ *
+ * Drop the cached position of the child and all its children. Needs
+ * to be invoked whenever the child might have moved relative to its
+ * root.
+ */
+void
+phoc_view_child_invalidate_pos (PhocViewChild *self)
+{
+  PhocViewChildPrivate *priv;
+
   g_assert (PHOC_IS_VIEW_CHILD (self));
+  priv = phoc_view_child_get_instance_private (self);
+
+  priv->pos_valid = FALSE;
 
-  PHOC_VIEW_CHILD_GET_CLASS (self)->get_pos (self, sx, sy);
+  for (GSList *elem = priv->children; elem; elem = elem->next)
+    phoc_view_child_invalidate_pos (PHOC_VIEW_CHILD (elem->data));
 }
 
 /**
@@ -10,6 +10,8 @@
 #include "desktop.h"
 #include "focus-frame.h"
 #include "input.h"
+#include "layout-transaction.h"
+#include "phoc-priorities.h"
 #include "seat.h"
 #include "server.h"
 #include "subsurface.h"
@@ -21,6 +23,8 @@
 
 #include <wlr/types/wlr_subcompositor.h>
 #include <wlr/types/wlr_output_layout.h>
+#include <wlr/util/box.h>
+#include <math.h>
 
 #define PHOC_ANIM_DURATION_WINDOW_FADE 150
 #define PHOC_MOVE_TO_CORNER_MARGIN 12
@@ -45,6 +49,7 @@ enum {
   SURFACE_DESTROY,
   POS_CHANGED,
   SIZE_CHANGED,
+  THUMBNAIL_DAMAGED,
   N_SIGNALS
 };
 static guint signals[N_SIGNALS] = { 0 };
@@ -63,6 +68,19 @@ typedef struct _PhocViewPrivate {
   PhocViewTileDirection tile_direction;
   gboolean       always_on_top;
   gboolean       visibility;
+  guint32        visible_outputs;
+  /* What the last visibility check saw of the view */
+  struct {
+    gboolean          mapped;
+    struct wlr_box    bounds;
+    gboolean          bounds_dirty;
+    pixman_region32_t opaque;
+    gboolean          opaque_dirty;
+    float             alpha;
+    float             scale;
+    PhocViewState     state;
+    PhocOutput       *fullscreen_output;
+  } occlusion;
   gboolean       modal;
   guint          suspend_timer_id;
   char          *tag;
@@ -74,6 +92,8 @@ typedef struct _PhocViewPrivate {
   char          *activation_token;
   int            activation_token_type;
   GSList        *blings; /* PhocBlings */
+  PhocViewCache *cache;
+  PhocViewCache *thumbnail_cache;
 
   /* wlr-toplevel-management handling */
   struct wlr_foreign_toplevel_handle_v1 *toplevel_handle;
@@ -100,6 +120,155 @@ G_DEFINE_TYPE_WITH_CODE (PhocView, phoc_view, G_TYPE_OBJECT,
 #define PHOC_VIEW_SELF(p) PHOC_PRIV_CONTAINER(PHOC_VIEW, PhocView, (p))
 
 static bool view_center (PhocView *self, PhocOutput *output);
+static void view_apply_damage (PhocView *self);
+
+
+/*
+ * The view's size, position or the layout of its surface tree
+ * changed so the input bounds need to be computed again.
+ */
+static void
+view_invalidate_bounds (PhocView *self)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+
+  priv->occlusion.bounds_dirty = TRUE;
+}
+
+
+static gboolean
+surface_extents_changed (struct wlr_surface *surface)
+{
+  return surface->WLR_PRIVATE.previous.width != surface->current.width ||
+    surface->WLR_PRIVATE.previous.height != surface->current.height ||
+    surface->current.dx != 0 || surface->current.dy != 0;
+}
+
+/*
+ * Whether anything that affects occlusion changed since the last
+ * check. Plain content updates don't so they don't need to rerun the
+ * visibility check. The surface tree is only walked when its layout
+ * changed and the opaque region is only compared after the root
+ * surface got committed.
+ */
+static gboolean
+view_occlusion_changed (PhocView *self)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  gboolean mapped = phoc_view_is_mapped (self);
+  gboolean changed = FALSE;
+
+  if (mapped != priv->occlusion.mapped) {
+    priv->occlusion.mapped = mapped;
+    priv->occlusion.bounds_dirty = TRUE;
+    priv->occlusion.opaque_dirty = TRUE;
+    changed = TRUE;
+  }
+
+  if (priv->occlusion.bounds_dirty) {
+    struct wlr_box bounds = { 0 };
+
+    if (mapped)
+      phoc_view_get_input_bounds (self, &bounds);
+
+    if (!wlr_box_equal (&bounds, &priv->occlusion.bounds)) {
+      priv->occlusion.bounds = bounds;
+      changed = TRUE;
+    }
+    priv->occlusion.bounds_dirty = FALSE;
+  }
+
+  if (priv->alpha != priv->occlusion.alpha ||
+      priv->scale != priv->occlusion.scale ||
+      priv->state != priv->occlusion.state ||
+      priv->fullscreen_output != priv->occlusion.fullscreen_output) {
+    changed = TRUE;
+  }
+
+  priv->occlusion.alpha = priv->alpha;
+  priv->occlusion.scale = priv->scale;
+  priv->occlusion.state = priv->state;
+  priv->occlusion.fullscreen_output = priv->fullscreen_output;
+
+  if (priv->occlusion.opaque_dirty && mapped) {
+    if (!pixman_region32_equal (&self->wlr_surface->opaque_region, &priv->occlusion.opaque)) {
+      pixman_region32_copy (&priv->occlusion.opaque, &self->wlr_surface->opaque_region);
+      changed = TRUE;
+    }
+    priv->occlusion.opaque_dirty = FALSE;
+  }
+
+  return changed;
+}
+
+
+static void
+view_extents_changed (PhocView *self)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+
+  phoc_desktop_invalidate_view_input (desktop, self);
+  if (view_occlusion_changed (self))
+    phoc_desktop_invalidate_visibility (desktop);
+}
+
+
+static void
+add_surface_thumbnail_damage (PhocView *self, struct wlr_surface *surface, int sx, int sy)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  pixman_region32_t damage;
+  struct wlr_box geo;
+
+  phoc_view_get_geometry (self, &geo);
+
+  pixman_region32_init (&damage);
+  wlr_surface_get_effective_damage (surface, &damage);
+  pixman_region32_translate (&damage, sx - geo.x, sy - geo.y);
+  pixman_region32_union (&priv->thumbnail_cache->damage, &priv->thumbnail_cache->damage, &damage);
+  pixman_region32_fini (&damage);
+}
+
+
+static void
+add_thumbnail_damage_iter (struct wlr_surface *surface, int sx, int sy, void *data)
+{
+  add_surface_thumbnail_damage (PHOC_VIEW (data), surface, sx, sy);
+}
+
+/*
+ * Track what changed since the thumbnail was last rendered so it
+ * can be updated partially. With @whole the whole view is damaged,
+ * with @surface only that surface's damage is added, otherwise the
+ * damage of all the view's surfaces.
+ */
+static void
+damage_thumbnail (PhocView *self, struct wlr_surface *surface, int sx, int sy, gboolean whole)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  gboolean was_dirty;
+
+  if (G_LIKELY (priv->thumbnail_cache == NULL))
+    return;
+
+  was_dirty = priv->thumbnail_cache->dirty;
+
+  if (whole) {
+    struct wlr_box geo;
+
+    phoc_view_get_geometry (self, &geo);
+    pixman_region32_union_rect (&priv->thumbnail_cache->damage, &priv->thumbnail_cache->damage,
+                                0, 0, geo.width, geo.height);
+  } else if (surface) {
+    add_surface_thumbnail_damage (self, surface, sx, sy);
+  } else if (self->wlr_surface) {
+    wlr_surface_for_each_surface (self->wlr_surface, add_thumbnail_damage_iter, self);
+  }
+  phoc_view_cache_invalidate (priv->thumbnail_cache);
+
+  if (!was_dirty)
+    g_signal_emit (self, signals[THUMBNAIL_DAMAGED], 0);
+}
 
 /* {{{ PhocChildRoot interface */
 
@@ -132,7 +301,37 @@ phoc_view_child_root_apply_damage (PhocChildRoot *root)
 
   g_assert (PHOC_IS_VIEW (self));
 
-  phoc_view_apply_damage (self);
+  /* A child moved or got restacked */
+  view_invalidate_bounds (self);
+  view_apply_damage (self);
+}
+
+
+static void
+phoc_view_child_root_apply_surface_damage (PhocChildRoot      *root,
+                                           struct wlr_surface *surface,
+                                           int                 sx,
+                                           int                 sy)
+{
+  PhocView *self = PHOC_VIEW (root);
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocViewPrivate *priv;
+  PhocOutput *output;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  if (priv->cache)
+    phoc_view_cache_invalidate (priv->cache);
+  damage_thumbnail (self, surface, sx, sy, FALSE);
+
+  /* The child might have changed size */
+  if (surface_extents_changed (surface))
+    view_invalidate_bounds (self);
+  view_extents_changed (self);
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    phoc_output_damage_from_view_surface (output, self, surface, sx, sy);
 }
 
 
@@ -161,6 +360,8 @@ phoc_view_child_root_remove_child (PhocChildRoot *root, PhocViewChild *child)
   priv = phoc_view_get_instance_private (self);
 
   priv->child_surfaces = g_slist_remove (priv->child_surfaces, child);
+  view_invalidate_bounds (self);
+  view_extents_changed (self);
 }
 
 
@@ -224,6 +425,7 @@ phoc_view_child_root_iface_init (PhocChildRootInterface *iface)
   iface->get_box = phoc_view_child_root_get_box;
   iface->is_mapped = phoc_view_child_root_is_mapped;
   iface->apply_damage = phoc_view_child_root_apply_damage;
+  iface->apply_surface_damage = phoc_view_child_root_apply_surface_damage;
   iface->add_child = phoc_view_child_root_add_child;
   iface->remove_child = phoc_view_child_root_remove_child;
   iface->unconstrain_popup = phoc_view_child_root_unconstrain_popup;
@@ -257,6 +459,8 @@ toggle_decoration (PhocView *self)
     }
     g_clear_object (&priv->deco);
   }
+  view_invalidate_bounds (self);
+  view_extents_changed (self);
 }
 
 /* {{{ Foreign toplevel requests  */
@@ -623,7 +827,7 @@ phoc_view_move_default (PhocView *self, double x, double y)
 }
 
 
-static void
+static gboolean
 on_suspend_timer_expired (gpointer user_data)
 {
   PhocView *self = user_data;
@@ -635,6 +839,8 @@ on_suspend_timer_expired (gpointer user_data)
   priv->suspend_timer_id = 0;
 
   PHOC_VIEW_GET_CLASS (self)->set_suspended (self, TRUE);
+
+  return G_SOURCE_REMOVE;
 }
 
 
@@ -647,9 +853,11 @@ phoc_view_set_suspended (PhocView *self, bool suspended)
 
   if (suspended) {
     if (!priv->suspend_timer_id) {
-      priv->suspend_timer_id = g_timeout_add_seconds_once (PHOC_SUSPEND_TIMEOUT_SECONDS,
+      priv->suspend_timer_id = g_timeout_add_seconds_full (PHOC_PRIORITY_BOOKKEEPING,
+                                                           PHOC_SUSPEND_TIMEOUT_SECONDS,
                                                            on_suspend_timer_expired,
-                                                           self);
+                                                           self,
+                                                           NULL);
       g_source_set_name_by_id (priv->suspend_timer_id, "[phoc] surface suspend timer");
     }
   } else {
@@ -1383,8 +1591,11 @@ view_update_scale (PhocView *self)
     priv->scale = 1.0;
   }
 
-  if (priv->scale != oldscale)
+  if (priv->scale != oldscale) {
+    view_invalidate_bounds (self);
+    view_extents_changed (self);
     phoc_view_arrange (self, NULL, TRUE);
+  }
 }
 
 
@@ -1495,6 +1706,8 @@ phoc_view_unmap (PhocView *self)
 
   wl_list_remove (&priv->surface_new_subsurface.link);
   phoc_view_drop_child_surfaces (self);
+  g_clear_pointer (&priv->cache, phoc_view_cache_free);
+  g_clear_pointer (&priv->thumbnail_cache, phoc_view_cache_free);
 
   if (phoc_view_is_fullscreen (self)) {
     phoc_output_damage_whole (priv->fullscreen_output);
@@ -1503,6 +1716,8 @@ phoc_view_unmap (PhocView *self)
   }
 
   phoc_desktop_remove_view (desktop, self);
+  /* Don't wait for views that are gone */
+  phoc_layout_transaction_notify_view_configured (phoc_layout_transaction_get_default (), self);
 
   if (was_visible && desktop->maximize && phoc_workspace_has_views (workspace)) {
     /* Damage the newly activated stack as well since it may have just become visible */
@@ -1566,21 +1781,47 @@ phoc_view_setup (PhocView *self)
   wlr_foreign_toplevel_handle_v1_set_parent (priv->toplevel_handle, toplevel_handle);
 }
 
+static void
+view_apply_damage (PhocView *self)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  PhocOutput *output;
+
+  /* The surfaces' content changed */
+  if (priv->cache)
+    phoc_view_cache_invalidate (priv->cache);
+  damage_thumbnail (self, NULL, 0, 0, FALSE);
+
+  /* Children might have moved relative to us */
+  for (GSList *l = priv->child_surfaces; l; l = l->next)
+    phoc_view_child_invalidate_pos (PHOC_VIEW_CHILD (l->data));
+  view_extents_changed (self);
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    phoc_output_damage_from_view (output, self, false);
+}
+
 /**
  * phoc_view_apply_damage:
  * @view: A view
  *
  * Add the accumulated damage of all surfaces belonging to a
  * [class@PhocView] to the damaged screen area that needs repaint.
+ * Invoked when the view's root surface got committed.
  */
 void
 phoc_view_apply_damage (PhocView *self)
 {
-  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
-  PhocOutput *output;
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
 
-  wl_list_for_each (output, &desktop->outputs, link)
-    phoc_output_damage_from_view (output, self, false);
+  if (self->wlr_surface) {
+    if (surface_extents_changed (self->wlr_surface))
+      view_invalidate_bounds (self);
+    priv->occlusion.opaque_dirty = TRUE;
+  }
+
+  view_apply_damage (self);
 }
 
 /**
@@ -1598,6 +1839,9 @@ phoc_view_damage_whole (PhocView *self)
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocOutput *output;
 
+  damage_thumbnail (self, NULL, 0, 0, TRUE);
+  view_extents_changed (self);
+
   wl_list_for_each (output, &desktop->outputs, link)
     phoc_output_damage_from_view (output, self, true);
 }
@@ -1614,6 +1858,7 @@ view_update_position (PhocView *self, int x, int y)
   phoc_view_damage_whole (self);
   self->box.x = x;
   self->box.y = y;
+  view_invalidate_bounds (self);
   view_update_output (self, &before);
   phoc_view_damage_whole (self);
 
@@ -1633,6 +1878,7 @@ view_update_size (PhocView *self, int width, int height)
   phoc_view_damage_whole (self);
   self->box.width = width;
   self->box.height = height;
+  view_invalidate_bounds (self);
   if (self->pending_centering ||
       (phoc_view_is_floating (self) && phoc_desktop_get_auto_maximize (desktop))) {
     view_center (self, NULL);
@@ -1798,6 +2044,10 @@ phoc_view_set_alpha (PhocView *self, float alpha)
     return;
 
   priv->alpha = alpha;
+  /* Only needed while the view is translucent */
+  if (alpha >= 1.0)
+    g_clear_pointer (&priv->cache, phoc_view_cache_free);
+
   phoc_view_damage_whole (self);
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ALPHA]);
 }
@@ -1877,6 +2127,9 @@ phoc_view_finalize (GObject *object)
 
   g_clear_pointer (&priv->tag, g_free);
   g_clear_handle_id (&priv->suspend_timer_id, g_source_remove);
+  g_clear_pointer (&priv->cache, phoc_view_cache_free);
+  g_clear_pointer (&priv->thumbnail_cache, phoc_view_cache_free);
+  pixman_region32_fini (&priv->occlusion.opaque);
 
   /* Unlink from our parent */
   if (self->parent) {
@@ -2158,6 +2411,19 @@ phoc_view_class_init (PhocViewClass *klass)
                                         NULL, NULL, NULL,
                                         G_TYPE_NONE,
                                         0);
+  /**
+   * PhocView::thumbnail-damaged:
+   *
+   * The view got damaged after its thumbnail was rendered. This is
+   * only emitted once until the thumbnail is rendered again.
+   */
+  signals[THUMBNAIL_DAMAGED] = g_signal_new ("thumbnail-damaged",
+                                             G_TYPE_FROM_CLASS (object_class),
+                                             G_SIGNAL_RUN_LAST,
+                                             0,
+                                             NULL, NULL, NULL,
+                                             G_TYPE_NONE,
+                                             0);
 }
 
 
@@ -2171,6 +2437,8 @@ phoc_view_init (PhocView *self)
   priv->scale = 1.0f;
   priv->state = PHOC_VIEW_STATE_FLOATING;
   priv->visibility = TRUE;
+  priv->visible_outputs = G_MAXUINT32;
+  pixman_region32_init (&priv->occlusion.opaque);
 
   wl_list_init (&self->stack);
 
@@ -2506,6 +2774,68 @@ phoc_view_get_wlr_surface_at (PhocView *self, double sx, double sy, double *sub_
   return PHOC_VIEW_GET_CLASS (self)->get_wlr_surface_at (self, sx, sy, sub_x, sub_y);
 }
 
+
+static void
+union_input_bounds_iter (struct wlr_surface *surface, int sx, int sy, void *data)
+{
+  pixman_box32_t *bounds = data;
+
+  bounds->x1 = MIN (bounds->x1, sx);
+  bounds->y1 = MIN (bounds->y1, sy);
+  bounds->x2 = MAX (bounds->x2, sx + surface->current.width);
+  bounds->y2 = MAX (bounds->y2, sy + surface->current.height);
+}
+
+/**
+ * phoc_view_get_input_bounds:
+ * @self: The view
+ * @box: (out): The bounds in layout coordinates
+ *
+ * Get a box containing all points where [method@View.get_wlr_surface_at]
+ * or [method@View.get_deco_part] can find something. This includes
+ * subsurfaces, popups and server side decorations. Not every point
+ * inside the box needs to accept input.
+ *
+ * Returns: %TRUE if the view can receive input at all, otherwise %FALSE
+ */
+gboolean
+phoc_view_get_input_bounds (PhocView *self, struct wlr_box *box)
+{
+  PhocViewPrivate *priv;
+  pixman_box32_t bounds = { G_MAXINT32, G_MAXINT32, G_MININT32, G_MININT32 };
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  *box = (struct wlr_box){ 0 };
+  if (!phoc_view_is_mapped (self) || self->wlr_surface == NULL)
+    return FALSE;
+
+  phoc_view_for_each_surface (self, union_input_bounds_iter, &bounds);
+
+  if (priv->deco) {
+    int bw = phoc_view_deco_get_border_width (priv->deco);
+    int titlebar_h = phoc_view_deco_get_title_bar_height (priv->deco);
+
+    bounds.x1 = MIN (bounds.x1, -bw);
+    bounds.y1 = MIN (bounds.y1, -(titlebar_h + bw));
+    /* The outer edges of the borders are inclusive */
+    bounds.x2 = MAX (bounds.x2, self->wlr_surface->current.width + bw + 1);
+    bounds.y2 = MAX (bounds.y2, self->wlr_surface->current.height + bw + 1);
+  }
+
+  if (bounds.x1 >= bounds.x2 || bounds.y1 >= bounds.y2)
+    return FALSE;
+
+  /* Map to layout coordinates like the hit test does */
+  box->x = floor ((self->box.x + bounds.x1) * priv->scale);
+  box->y = floor ((self->box.y + bounds.y1) * priv->scale);
+  box->width = ceil ((self->box.x + bounds.x2) * priv->scale) - box->x;
+  box->height = ceil ((self->box.y + bounds.y2) * priv->scale) - box->y;
+
+  return TRUE;
+}
+
 /**
  * phoc_view_want_auto_maximize:
  * @self: The view
@@ -2648,6 +2978,90 @@ phoc_view_get_blings (PhocView *self)
   return priv->blings;
 }
 
+/**
+ * phoc_view_get_offscreen_cache:
+ * @self: The view
+ *
+ * Gets the offscreen cache used to composite the view as a single
+ * texture while it's translucent. The cache is created on first use
+ * and dropped once the view becomes opaque again.
+ *
+ * Returns: (transfer none): The view's cache
+ */
+PhocViewCache *
+phoc_view_get_offscreen_cache (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  if (priv->cache == NULL)
+    priv->cache = phoc_view_cache_new ();
+
+  return priv->cache;
+}
+
+/**
+ * phoc_view_clear_offscreen_cache:
+ * @self: The view
+ *
+ * Drops the view's offscreen cache e.g. when the renderer that
+ * created it goes away.
+ */
+void
+phoc_view_clear_offscreen_cache (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  g_clear_pointer (&priv->cache, phoc_view_cache_free);
+}
+
+/**
+ * phoc_view_get_thumbnail_cache:
+ * @self: The view
+ *
+ * Gets the cache holding the view's last rendered thumbnail. The
+ * cache is created on first use and invalidated whenever the view
+ * gets damaged.
+ *
+ * Returns: (transfer none): The view's thumbnail cache
+ */
+PhocViewCache *
+phoc_view_get_thumbnail_cache (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  if (priv->thumbnail_cache == NULL)
+    priv->thumbnail_cache = phoc_view_cache_new ();
+
+  return priv->thumbnail_cache;
+}
+
+/**
+ * phoc_view_clear_thumbnail_cache:
+ * @self: The view
+ *
+ * Drops the view's thumbnail cache e.g. when the renderer that
+ * created it goes away.
+ */
+void
+phoc_view_clear_thumbnail_cache (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  g_clear_pointer (&priv->thumbnail_cache, phoc_view_cache_free);
+}
+
 /**
  * phoc_view_arrange:
  * @self: a view
@@ -2734,6 +3148,48 @@ phoc_view_set_visibility (PhocView *self, gboolean visibility)
   phoc_view_set_suspended (self, !visibility);
 }
 
+/**
+ * phoc_view_set_visible_outputs:
+ * @self: a view
+ * @visible_outputs: The outputs the view is visible on
+ *
+ * Sets the outputs the view is visible on as determined by
+ * [method@Desktop.view_check_visibility]. Each bit corresponds to an
+ * output's visibility mask. The view is suspended when it isn't visible
+ * on any output.
+ */
+void
+phoc_view_set_visible_outputs (PhocView *self, guint32 visible_outputs)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  priv->visible_outputs = visible_outputs;
+  phoc_view_set_visibility (self, !!visible_outputs);
+}
+
+/**
+ * phoc_view_get_visible_outputs:
+ * @self: a view
+ *
+ * Get the outputs the view was last found visible on. See
+ * [method@View.set_visible_outputs].
+ *
+ * Returns: The visibility bitmask
+ */
+guint32
+phoc_view_get_visible_outputs (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  return priv->visible_outputs;
+}
+
 
 void
 phoc_view_set_modal (PhocView *self, gboolean modal)
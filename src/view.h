@@ -1,6 +1,7 @@
 #pragma once
 
 #include "phoc-types.h"
+#include "view-cache.h"
 
 #include <stdbool.h>
 #include <wlr/config.h>
@@ -200,6 +201,7 @@ PhocOutput *          phoc_view_get_output (PhocView *self);
 pid_t                 phoc_view_get_pid (PhocView *self);
 bool                  phoc_view_is_mapped (PhocView *self);
 PhocViewDecoPart      phoc_view_get_deco_part (PhocView *self, double sx, double sy);
+gboolean              phoc_view_get_input_bounds (PhocView *self, struct wlr_box *box);
 void                  phoc_view_set_scale_to_fit (PhocView *self, gboolean enable);
 gboolean              phoc_view_get_scale_to_fit (PhocView *self);
 void                  phoc_view_set_activation_token (PhocView *self, const char *token, int type);
@@ -218,6 +220,8 @@ gboolean              phoc_view_get_maximized_box (PhocView       *self,
                                                    PhocOutput     *output,
                                                    struct wlr_box *box);
 void                  phoc_view_set_visibility (PhocView *self, gboolean visibility);
+void                  phoc_view_set_visible_outputs (PhocView *self, guint32 visible_outputs);
+guint32               phoc_view_get_visible_outputs (PhocView *self);
 gboolean              phoc_view_get_tiled_box (PhocView             *self,
                                                PhocViewTileDirection dir,
                                                PhocOutput           *output,
@@ -226,6 +230,10 @@ void                  phoc_view_add_bling (PhocView *self, PhocBling *bling);
 void                  phoc_view_insert_bling (PhocView *self, PhocBling *bling);
 void                  phoc_view_remove_bling (PhocView *self, PhocBling *bling);
 GSList *              phoc_view_get_blings (PhocView *self);
+PhocViewCache *       phoc_view_get_offscreen_cache (PhocView *self);
+void                  phoc_view_clear_offscreen_cache (PhocView *self);
+PhocViewCache *       phoc_view_get_thumbnail_cache (PhocView *self);
+void                  phoc_view_clear_thumbnail_cache (PhocView *self);
 PhocView *            phoc_view_get_modal_dialog (PhocView *self);
 
 G_END_DECLS
@@ -208,6 +208,9 @@ bling_map (PhocBling *bling)
   text = g_strdup_printf ("%d", self->num);
   draw_indicator (cr, text, self->size);
 
+  /* Only the indicator's rounded box needs uploading */
+  phoc_cairo_texture_add_damage_box (self->texture,
+                                     &(struct wlr_box) { .width = self->size, .height = self->size });
   phoc_cairo_texture_update (self->texture);
 
   phoc_bling_damage_box (PHOC_BLING (self));
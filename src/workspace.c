@@ -26,6 +26,10 @@ struct _PhocWorkspace {
    * order */
   GQueue *views;
   GQueue *unmanaged;
+  /* Bumped whenever the render order of views changes */
+  guint   stack_serial;
+  /* Views need arranging once the workspace becomes active */
+  gboolean arrange_pending;
 };
 G_DEFINE_TYPE (PhocWorkspace, phoc_workspace, G_TYPE_OBJECT)
 
@@ -116,6 +120,7 @@ phoc_workspace_move_view_to_top (PhocWorkspace *self, PhocView *view)
     g_queue_insert_before_link (self->views, l, view_link);
   }
 
+  self->stack_serial++;
   phoc_view_damage_whole (view);
 }
 
@@ -148,6 +153,7 @@ phoc_workspace_cycle (PhocWorkspace *self, gboolean forward)
     link = g_queue_pop_head_link (self->views);
     g_queue_push_tail_link (self->views, link);
   }
+  self->stack_serial++;
 
   view = g_queue_peek_head (self->views);
   return view;
@@ -170,6 +176,55 @@ phoc_workspace_get_views (PhocWorkspace *self)
   return self->views;
 }
 
+/**
+ * phoc_workspace_get_stack_serial:
+ * @self: the workspace
+ *
+ * Get a serial that changes whenever views are added, removed or
+ * restacked. This allows to cache information that depends on the
+ * render order.
+ *
+ * Returns: The current stack serial
+ */
+guint
+phoc_workspace_get_stack_serial (PhocWorkspace *self)
+{
+  g_assert (PHOC_IS_WORKSPACE (self));
+
+  return self->stack_serial;
+}
+
+/**
+ * phoc_workspace_set_arrange_pending:
+ * @self: the workspace
+ * @pending: Whether the views need to be arranged
+ *
+ * Mark the views of an inactive workspace as needing to be arranged
+ * once the workspace is shown, e.g. because an output's usable area
+ * changed.
+ */
+void
+phoc_workspace_set_arrange_pending (PhocWorkspace *self, gboolean pending)
+{
+  g_assert (PHOC_IS_WORKSPACE (self));
+
+  self->arrange_pending = pending;
+}
+
+/**
+ * phoc_workspace_get_arrange_pending:
+ * @self: the workspace
+ *
+ * Returns: `TRUE` if the views need to be arranged before the workspace is shown
+ */
+gboolean
+phoc_workspace_get_arrange_pending (PhocWorkspace *self)
+{
+  g_assert (PHOC_IS_WORKSPACE (self));
+
+  return self->arrange_pending;
+}
+
 /**
  * phoc_workspace_has_view:
  * @self: the workspace
@@ -217,7 +272,11 @@ phoc_workspace_remove_view (PhocWorkspace *self, PhocView *view)
 {
   g_assert (PHOC_IS_WORKSPACE (self));
 
-  return g_queue_remove (self->views, view);
+  if (!g_queue_remove (self->views, view))
+    return FALSE;
+
+  self->stack_serial++;
+  return TRUE;
 }
 
 /**
@@ -35,6 +35,10 @@ PhocWorkspace *         phoc_workspace_new                       (void);
 void                    phoc_workspace_insert_view               (PhocWorkspace *self,
                                                                   PhocView      *view);
 GQueue *                phoc_workspace_get_views                 (PhocWorkspace *self);
+guint                   phoc_workspace_get_stack_serial          (PhocWorkspace *self);
+void                    phoc_workspace_set_arrange_pending       (PhocWorkspace *self,
+                                                                  gboolean       pending);
+gboolean                phoc_workspace_get_arrange_pending       (PhocWorkspace *self);
 gboolean                phoc_workspace_has_view                  (PhocWorkspace *self,
                                                                   PhocView      *view);
 gboolean                phoc_workspace_has_views                 (PhocWorkspace *self);
@@ -12,6 +12,7 @@
 #include "phoc-config.h"
 
 #include "cursor.h"
+#include "layout-transaction.h"
 #include "server.h"
 #include "view-private.h"
 #include "xdg-popup.h"
@@ -218,6 +219,7 @@ move_resize (PhocView *view, double x, double y, uint32_t width, uint32_t height
   } else if (self->xdg_toplevel->base->initialized) {
     self->pending_move_resize_configure_serial =
       wlr_xdg_toplevel_set_size (wlr_xdg_toplevel, constrained_width, constrained_height);
+    phoc_layout_transaction_add_view_dirty (phoc_layout_transaction_get_default (), view);
   }
 
   send_frame_done_if_not_visible (self);
@@ -449,8 +451,11 @@ handle_surface_commit (struct wl_listener *listener, void *data)
     }
     view_update_position (view, x, y);
 
-    if (pending_serial == xdg_toplevel->base->current.configure_serial)
+    if (pending_serial == xdg_toplevel->base->current.configure_serial) {
       self->pending_move_resize_configure_serial = 0;
+      phoc_layout_transaction_notify_view_configured (phoc_layout_transaction_get_default (),
+                                                      view);
+    }
   }
 
   struct wlr_box geometry;
@@ -10,6 +10,7 @@
 
 #include "phoc-config.h"
 #include "cursor.h"
+#include "layout-transaction.h"
 #include "seat.h"
 #include "server.h"
 #include "view-private.h"
@@ -195,6 +196,13 @@ move_resize (PhocView *view, double x, double y, uint32_t width, uint32_t height
                              constrained_height);
 
   wlr_xwayland_surface_configure (xwayland_surface, x, y, constrained_width, constrained_height);
+
+  /* Only wait for views that need to submit a buffer with a new size */
+  if (view->wlr_surface &&
+      (constrained_width != view->wlr_surface->current.width ||
+       constrained_height != view->wlr_surface->current.height)) {
+    phoc_layout_transaction_add_view_dirty (phoc_layout_transaction_get_default (), view);
+  }
 }
 
 static void
@@ -452,6 +460,11 @@ handle_surface_commit (struct wl_listener *listener, void *data)
 
   view_update_size (view, width, height);
 
+  /* X11 has no configure acks and clients might not honor the
+   * requested size so the first commit after the configure ends our
+   * participation in the transaction */
+  phoc_layout_transaction_notify_view_configured (phoc_layout_transaction_get_default (), view);
+
   double x = view->box.x;
   double y = view->box.y;
 
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+
+#include "cairo-texture.h"
+
+#define SIZE 32
+
+
+static void
+assert_stale (PhocCairoTexture *cairo_texture, struct wlr_texture *texture, const struct wlr_box *box)
+{
+  const pixman_region32_t *stale = phoc_cairo_texture_get_stale (cairo_texture, texture);
+  pixman_box32_t *extents;
+
+  g_assert_nonnull (stale);
+  if (box == NULL) {
+    g_assert_false (pixman_region32_not_empty (stale));
+    return;
+  }
+
+  g_assert_cmpint (pixman_region32_n_rects (stale), ==, 1);
+  extents = pixman_region32_extents (stale);
+  g_assert_cmpint (extents->x1, ==, box->x);
+  g_assert_cmpint (extents->y1, ==, box->y);
+  g_assert_cmpint (extents->x2, ==, box->x + box->width);
+  g_assert_cmpint (extents->y2, ==, box->y + box->height);
+}
+
+
+static gboolean
+test_cairo_texture_server_prepare (PhocServer *server, gpointer data)
+{
+  g_autoptr (PhocCairoTexture) cairo_texture = phoc_cairo_texture_new (SIZE, SIZE);
+  struct wlr_box left = { 0, 0, SIZE / 2, SIZE };
+  struct wlr_box right = { SIZE / 2, 0, SIZE / 2, SIZE };
+  struct wlr_box top = { 0, 0, SIZE, SIZE / 2 };
+  struct wlr_box top_left = { 0, 0, SIZE / 2, SIZE / 2 };
+  struct wlr_texture *front, *back;
+
+  g_assert_nonnull (phoc_cairo_texture_get_context (cairo_texture));
+
+  /* Nothing uses the texture yet so it's updated in place */
+  phoc_cairo_texture_add_damage_box (cairo_texture, &left);
+  phoc_cairo_texture_update (cairo_texture);
+  front = phoc_cairo_texture_get_texture (cairo_texture);
+  g_assert_nonnull (front);
+  assert_stale (cairo_texture, front, NULL);
+
+  /* The front texture is in use so the update goes to a new texture */
+  phoc_cairo_texture_add_damage_box (cairo_texture, &right);
+  phoc_cairo_texture_update (cairo_texture);
+  back = phoc_cairo_texture_get_texture (cairo_texture);
+  g_assert_nonnull (back);
+  g_assert_true (back != front);
+  assert_stale (cairo_texture, back, NULL);
+  /* The old front texture lags behind by what was damaged since */
+  assert_stale (cairo_texture, front, &right);
+
+  /* Swapping back uploads what the texture missed and the new damage */
+  phoc_cairo_texture_add_damage_box (cairo_texture, &top);
+  phoc_cairo_texture_update (cairo_texture);
+  g_assert_true (phoc_cairo_texture_get_texture (cairo_texture) == front);
+  assert_stale (cairo_texture, front, NULL);
+  assert_stale (cairo_texture, back, &top);
+
+  /* Damage is clipped to the surface */
+  phoc_cairo_texture_add_damage_box (cairo_texture,
+                                     &(struct wlr_box) { -SIZE, -SIZE, SIZE + SIZE / 2,
+                                                         SIZE + SIZE / 2 });
+  phoc_cairo_texture_update (cairo_texture);
+  g_assert_true (phoc_cairo_texture_get_texture (cairo_texture) == back);
+  assert_stale (cairo_texture, back, NULL);
+  assert_stale (cairo_texture, front, &top_left);
+
+  /* Without a new user the front texture gets updated in place */
+  phoc_cairo_texture_add_damage_box (cairo_texture, &top_left);
+  phoc_cairo_texture_update (cairo_texture);
+  phoc_cairo_texture_add_damage_box (cairo_texture, &left);
+  phoc_cairo_texture_update (cairo_texture);
+  g_assert_true (phoc_cairo_texture_get_texture (cairo_texture) == front);
+  assert_stale (cairo_texture, front, NULL);
+  assert_stale (cairo_texture, back, &left);
+
+  g_assert_null (phoc_cairo_texture_get_stale (cairo_texture, NULL));
+
+  return TRUE;
+}
+
+
+static gboolean
+test_cairo_texture_client_run (PhocTestClientGlobals *globals, gpointer data)
+{
+  return TRUE;
+}
+
+
+static void
+test_cairo_texture_double_buffer (void)
+{
+  PhocTestClientIface iface = {
+    .server_prepare = test_cairo_texture_server_prepare,
+    .client_run     = test_cairo_texture_client_run,
+  };
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, NULL);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  PHOC_TEST_ADD ("/phoc/cairo-texture/double-buffer", test_cairo_texture_double_buffer);
+
+  return g_test_run ();
+}
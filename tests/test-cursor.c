@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+
+#include "cursor.h"
+#include "desktop.h"
+#include "pointer.h"
+#include "seat.h"
+#include "server.h"
+#include "settings.h"
+#include "touch.h"
+#include "view.h"
+
+#include <wlr/interfaces/wlr_pointer.h>
+#include <wlr/interfaces/wlr_touch.h>
+
+#define N_MOTIONS 10
+
+static const struct wlr_pointer_impl pointer_impl = {
+  .name = "test-pointer",
+};
+
+static const struct wlr_touch_impl touch_impl = {
+  .name = "test-touch",
+};
+
+typedef struct {
+  struct wlr_touch  wlr_touch;
+  PhocTouch        *touch;
+  guint             inject_id;
+} TestCoalesceTouch;
+
+typedef struct {
+  enum {
+    TEST_TOUCH_DOWN,
+    TEST_TOUCH_MOTION,
+    TEST_TOUCH_UP,
+  } type;
+  int    id;
+  double x, y;
+} TestTouchEvent;
+
+
+static void
+emit_motion (PhocCursor *cursor, struct wlr_pointer *wlr_pointer, guint32 time)
+{
+  struct wlr_pointer_motion_event event = {
+    .pointer = wlr_pointer,
+    .time_msec = time,
+    .delta_x = 1,
+    .delta_y = 2,
+    .unaccel_dx = 1,
+    .unaccel_dy = 2,
+  };
+
+  wl_signal_emit_mutable (&cursor->cursor->events.motion, &event);
+}
+
+
+static gboolean
+test_cursor_coalesce_motion_server_prepare (PhocServer *server, gpointer data)
+{
+  PhocInput *input = phoc_server_get_input (server);
+  PhocSeat *seat = phoc_input_get_seat (input, PHOC_CONFIG_DEFAULT_SEAT_NAME);
+  PhocCursor *cursor = seat->cursor;
+  PhocPointer *pointer;
+  struct wlr_pointer wlr_pointer;
+  PhocInputDevice *device;
+  gboolean coalesce;
+  double x, y;
+
+  wlr_pointer_init (&wlr_pointer, &pointer_impl, "test-pointer");
+  pointer = phoc_pointer_new (&wlr_pointer.base, seat);
+  device = PHOC_INPUT_DEVICE (pointer);
+
+  /* Coalescing is opt-in */
+  g_assert_false (phoc_input_device_get_coalesce_motion (device));
+  g_object_set (device, "coalesce-motion", TRUE, NULL);
+  g_object_get (device, "coalesce-motion", &coalesce, NULL);
+  g_assert_true (coalesce);
+
+  /* Start away from the output's edges so motion isn't clamped */
+  wlr_cursor_warp (cursor->cursor, NULL, 100, 100);
+  x = cursor->cursor->x;
+  y = cursor->cursor->y;
+
+  for (guint i = 0; i < N_MOTIONS; i++) {
+    emit_motion (cursor, &wlr_pointer, i);
+    /* Nothing is delivered before the frame ends */
+    g_assert_cmpfloat (cursor->cursor->x, ==, x);
+    g_assert_cmpfloat (cursor->cursor->y, ==, y);
+  }
+
+  /* The frame delivers a single motion with the accumulated delta */
+  wl_signal_emit_mutable (&cursor->cursor->events.frame, cursor->cursor);
+  g_assert_cmpfloat (cursor->cursor->x, ==, x + N_MOTIONS);
+  g_assert_cmpfloat (cursor->cursor->y, ==, y + 2 * N_MOTIONS);
+  x = cursor->cursor->x;
+  y = cursor->cursor->y;
+
+  /* Another frame doesn't deliver the motion again */
+  wl_signal_emit_mutable (&cursor->cursor->events.frame, cursor->cursor);
+  g_assert_cmpfloat (cursor->cursor->x, ==, x);
+  g_assert_cmpfloat (cursor->cursor->y, ==, y);
+
+  /* Pending motion doesn't outlive its device */
+  emit_motion (cursor, &wlr_pointer, N_MOTIONS);
+  phoc_cursor_drop_pending_motion (cursor, &wlr_pointer.base);
+  wl_signal_emit_mutable (&cursor->cursor->events.frame, cursor->cursor);
+  g_assert_cmpfloat (cursor->cursor->x, ==, x);
+  g_assert_cmpfloat (cursor->cursor->y, ==, y);
+
+  /* Without coalescing motion is delivered right away */
+  phoc_input_device_set_coalesce_motion (device, FALSE);
+  emit_motion (cursor, &wlr_pointer, N_MOTIONS + 1);
+  g_assert_cmpfloat (cursor->cursor->x, ==, x + 1);
+  g_assert_cmpfloat (cursor->cursor->y, ==, y + 2);
+
+  wlr_pointer_finish (&wlr_pointer);
+  g_assert_finalize_object (pointer);
+
+  return TRUE;
+}
+
+
+static gboolean
+test_cursor_client_run (PhocTestClientGlobals *globals, gpointer data)
+{
+  return TRUE;
+}
+
+
+static void
+touch_handle_down (void              *data,
+                   struct wl_touch   *wl_touch,
+                   uint32_t           serial,
+                   uint32_t           time,
+                   struct wl_surface *surface,
+                   int32_t            id,
+                   wl_fixed_t         x,
+                   wl_fixed_t         y)
+{
+  GArray *events = data;
+  TestTouchEvent event = {
+    .type = TEST_TOUCH_DOWN,
+    .id = id,
+    .x = wl_fixed_to_double (x),
+    .y = wl_fixed_to_double (y),
+  };
+
+  g_array_append_val (events, event);
+}
+
+
+static void
+touch_handle_up (void            *data,
+                 struct wl_touch *wl_touch,
+                 uint32_t         serial,
+                 uint32_t         time,
+                 int32_t          id)
+{
+  GArray *events = data;
+  TestTouchEvent event = { .type = TEST_TOUCH_UP, .id = id };
+
+  g_array_append_val (events, event);
+}
+
+
+static void
+touch_handle_motion (void            *data,
+                     struct wl_touch *wl_touch,
+                     uint32_t         time,
+                     int32_t          id,
+                     wl_fixed_t       x,
+                     wl_fixed_t       y)
+{
+  GArray *events = data;
+  TestTouchEvent event = {
+    .type = TEST_TOUCH_MOTION,
+    .id = id,
+    .x = wl_fixed_to_double (x),
+    .y = wl_fixed_to_double (y),
+  };
+
+  g_array_append_val (events, event);
+}
+
+
+static void
+touch_handle_frame (void *data, struct wl_touch *wl_touch)
+{
+}
+
+
+static void
+touch_handle_cancel (void *data, struct wl_touch *wl_touch)
+{
+  g_assert_not_reached ();
+}
+
+
+static const struct wl_touch_listener touch_listener = {
+  .down = touch_handle_down,
+  .up = touch_handle_up,
+  .motion = touch_handle_motion,
+  .frame = touch_handle_frame,
+  .cancel = touch_handle_cancel,
+};
+
+
+static gboolean
+find_view_iter (PhocDesktop *desktop, PhocView *view, gpointer user_data)
+{
+  PhocView **found = user_data;
+
+  if (!phoc_view_is_mapped (view))
+    return TRUE;
+
+  *found = view;
+  return FALSE;
+}
+
+
+static void
+emit_touch_motion (TestCoalesceTouch *td, PhocCursor *cursor, int id, double x, double y)
+{
+  struct wlr_touch_motion_event event = {
+    .touch = &td->wlr_touch,
+    .touch_id = id,
+    .x = x,
+    .y = y,
+  };
+
+  phoc_cursor_handle_touch_motion (cursor, &event);
+}
+
+
+static gboolean
+on_inject_touch (gpointer data)
+{
+  TestCoalesceTouch *td = data;
+  PhocServer *server = phoc_server_get_default ();
+  PhocDesktop *desktop = phoc_server_get_desktop (server);
+  PhocSeat *seat = phoc_input_get_seat (phoc_server_get_input (server),
+                                        PHOC_CONFIG_DEFAULT_SEAT_NAME);
+  PhocCursor *cursor = seat->cursor;
+  struct wlr_seat_client *seat_client;
+  struct wlr_box box, layout_box;
+  PhocView *view = NULL;
+  double x, y, w, h;
+
+  /* Wait for the client's surface and wl_touch */
+  phoc_desktop_for_each_view (desktop, find_view_iter, &view);
+  if (!view)
+    return G_SOURCE_CONTINUE;
+
+  seat_client = wlr_seat_client_for_wl_client (seat->seat,
+                                               wl_resource_get_client (view->wlr_surface->resource));
+  if (!seat_client || wl_list_empty (&seat_client->touches))
+    return G_SOURCE_CONTINUE;
+
+  phoc_view_get_box (view, &box);
+  wlr_output_layout_get_box (desktop->layout, NULL, &layout_box);
+  w = layout_box.width;
+  h = layout_box.height;
+  x = box.x + box.width / 2;
+  y = box.y + box.height / 2;
+
+  for (int id = 0; id < 2; id++) {
+    struct wlr_touch_down_event event = {
+      .touch = &td->wlr_touch,
+      .touch_id = id,
+      .x = (x + 10 * id) / w,
+      .y = y / h,
+    };
+
+    phoc_cursor_handle_touch_down (cursor, &event);
+  }
+  wl_signal_emit_mutable (&cursor->cursor->events.touch_frame, NULL);
+
+  /* Two motions per slot, interleaved */
+  emit_touch_motion (td, cursor, 0, (x + 1) / w, y / h);
+  emit_touch_motion (td, cursor, 1, (x + 10 + 3) / w, y / h);
+  emit_touch_motion (td, cursor, 0, (x + 5) / w, y / h);
+  emit_touch_motion (td, cursor, 1, (x + 10 + 7) / w, y / h);
+
+  /* Lifting the fingers in the same frame delivers the motion first */
+  for (int id = 0; id < 2; id++) {
+    struct wlr_touch_up_event event = {
+      .touch = &td->wlr_touch,
+      .touch_id = id,
+    };
+
+    phoc_cursor_handle_touch_up (cursor, &event);
+  }
+  wl_signal_emit_mutable (&cursor->cursor->events.touch_frame, NULL);
+
+  wlr_touch_finish (&td->wlr_touch);
+  g_assert_finalize_object (td->touch);
+
+  td->inject_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+test_cursor_coalesce_touch_server_prepare (PhocServer *server, gpointer data)
+{
+  TestCoalesceTouch *td = data;
+  PhocSeat *seat = phoc_input_get_seat (phoc_server_get_input (server),
+                                        PHOC_CONFIG_DEFAULT_SEAT_NAME);
+
+  wlr_touch_init (&td->wlr_touch, &touch_impl, "test-touch");
+  td->touch = phoc_touch_new (&td->wlr_touch.base, seat);
+  phoc_input_device_set_coalesce_motion (PHOC_INPUT_DEVICE (td->touch), TRUE);
+
+  /* So the client's wl_touch isn't inert */
+  wlr_seat_set_capabilities (seat->seat, seat->seat->capabilities | WL_SEAT_CAPABILITY_TOUCH);
+
+  td->inject_id = g_timeout_add (10, on_inject_touch, td);
+
+  return TRUE;
+}
+
+
+static gboolean
+test_cursor_coalesce_touch_client_run (PhocTestClientGlobals *globals, gpointer data)
+{
+  g_autoptr (GArray) events = g_array_new (FALSE, TRUE, sizeof (TestTouchEvent));
+  PhocTestXdgToplevelSurface *toplevel;
+  struct wl_touch *wl_touch;
+  guint n_up = 0;
+  TestTouchEvent *ev;
+
+  g_assert_nonnull (globals->seat);
+  wl_touch = wl_seat_get_touch (globals->seat);
+  wl_touch_add_listener (wl_touch, &touch_listener, events);
+  wl_display_roundtrip (globals->display);
+
+  toplevel = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, "coalesce-touch", 0xFF00FF00);
+  g_assert_nonnull (toplevel);
+
+  while (n_up < 2) {
+    g_assert_cmpint (wl_display_dispatch (globals->display), !=, -1);
+
+    n_up = 0;
+    for (guint i = 0; i < events->len; i++) {
+      if (g_array_index (events, TestTouchEvent, i).type == TEST_TOUCH_UP)
+        n_up++;
+    }
+  }
+
+  /* One motion per slot, in order, with the latest position, before any up */
+  g_assert_cmpint (events->len, ==, 6);
+  for (int id = 0; id < 2; id++) {
+    TestTouchEvent *down = &g_array_index (events, TestTouchEvent, id);
+
+    g_assert_cmpint (down->type, ==, TEST_TOUCH_DOWN);
+    g_assert_cmpint (down->id, ==, id);
+
+    ev = &g_array_index (events, TestTouchEvent, 2 + id);
+    g_assert_cmpint (ev->type, ==, TEST_TOUCH_MOTION);
+    g_assert_cmpint (ev->id, ==, id);
+    g_assert_cmpfloat_with_epsilon (ev->x - down->x, id ? 7 : 5, 0.1);
+    g_assert_cmpfloat_with_epsilon (ev->y, down->y, 0.1);
+
+    ev = &g_array_index (events, TestTouchEvent, 4 + id);
+    g_assert_cmpint (ev->type, ==, TEST_TOUCH_UP);
+    g_assert_cmpint (ev->id, ==, id);
+  }
+
+  wl_touch_release (wl_touch);
+  phoc_test_xdg_toplevel_free (toplevel);
+
+  return TRUE;
+}
+
+
+static void
+test_cursor_coalesce_touch (void)
+{
+  TestCoalesceTouch td = {};
+  PhocTestClientIface iface = {
+    .server_prepare = test_cursor_coalesce_touch_server_prepare,
+    .client_run     = test_cursor_coalesce_touch_client_run,
+  };
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, &td);
+  g_assert_cmpint (td.inject_id, ==, 0);
+}
+
+
+static void
+test_cursor_coalesce_motion (void)
+{
+  PhocTestClientIface iface = {
+    .server_prepare = test_cursor_coalesce_motion_server_prepare,
+    .client_run     = test_cursor_client_run,
+  };
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, NULL);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  PHOC_TEST_ADD ("/phoc/cursor/coalesce-motion", test_cursor_coalesce_motion);
+  PHOC_TEST_ADD ("/phoc/cursor/coalesce-touch", test_cursor_coalesce_touch);
+
+  return g_test_run ();
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "frame-scheduler.h"
+
+#define REFRESH_60HZ_US 16666
+
+
+static void
+add_render_times (PhocFrameScheduler *scheduler, guint n, gint64 render_time_us)
+{
+  for (guint i = 0; i < n; i++)
+    phoc_frame_scheduler_add_render_time (scheduler, render_time_us);
+}
+
+
+static void
+test_frame_scheduler_disabled (void)
+{
+  g_autoptr (PhocFrameScheduler) scheduler = phoc_frame_scheduler_new (0);
+
+  add_render_times (scheduler, 32, 2000);
+  g_assert_cmpint (phoc_frame_scheduler_predict_render_time (scheduler), ==, 2000);
+  /* A margin of 0 disables delaying */
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==, 0);
+
+  phoc_frame_scheduler_set_margin (scheduler, 2000);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==,
+                   REFRESH_60HZ_US - 2000 - 2000);
+  /* Unknown refresh rate */
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, 0), ==, 0);
+}
+
+
+static void
+test_frame_scheduler_predict (void)
+{
+  g_autoptr (PhocFrameScheduler) scheduler = phoc_frame_scheduler_new (1000);
+
+  /* Not enough data yet */
+  add_render_times (scheduler, 3, 2000);
+  g_assert_cmpint (phoc_frame_scheduler_predict_render_time (scheduler), ==, -1);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==, 0);
+
+  add_render_times (scheduler, 16, 2000);
+  phoc_frame_scheduler_add_render_time (scheduler, 5000);
+  /* Worst case wins */
+  g_assert_cmpint (phoc_frame_scheduler_predict_render_time (scheduler), ==, 5000);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==,
+                   REFRESH_60HZ_US - 5000 - 1000);
+
+  /* Slow frame drops out of the history */
+  add_render_times (scheduler, 16, 3000);
+  g_assert_cmpint (phoc_frame_scheduler_predict_render_time (scheduler), ==, 3000);
+
+  /* No point in delaying if we'd barely wait */
+  add_render_times (scheduler, 16, REFRESH_60HZ_US - 1500);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==, 0);
+}
+
+
+static void
+test_frame_scheduler_missed (void)
+{
+  g_autoptr (PhocFrameScheduler) scheduler = phoc_frame_scheduler_new (1000);
+
+  add_render_times (scheduler, 16, 2000);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), >, 0);
+
+  g_assert_false (phoc_frame_scheduler_check_missed (scheduler, 0, REFRESH_60HZ_US - 10,
+                                                     REFRESH_60HZ_US));
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), >, 0);
+
+  /* Missing the deadline makes us repaint right away */
+  g_assert_true (phoc_frame_scheduler_check_missed (scheduler, 0, REFRESH_60HZ_US + 10,
+                                                    REFRESH_60HZ_US));
+  g_assert_cmpint (phoc_frame_scheduler_predict_render_time (scheduler), ==, -1);
+  g_assert_cmpint (phoc_frame_scheduler_get_delay (scheduler, REFRESH_60HZ_US), ==, 0);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/frame-scheduler/disabled", test_frame_scheduler_disabled);
+  g_test_add_func ("/phoc/frame-scheduler/predict", test_frame_scheduler_predict);
+  g_test_add_func ("/phoc/frame-scheduler/missed", test_frame_scheduler_missed);
+
+  return g_test_run ();
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "gesture-drag.h"
+#include "gesture-single.h"
+#include "gesture-swipe.h"
+#include "gesture-zoom.h"
+#include "touch.h"
+
+#include <wlr/interfaces/wlr_touch.h>
+
+/* Count allocations by interposing the allocator. Not possible with ASan
+ * which brings its own. */
+#if defined (__GLIBC__) && !defined (__SANITIZE_ADDRESS__)
+# define PHOC_TEST_COUNT_ALLOCS 1
+#endif
+#if defined (__has_feature)
+# if __has_feature (address_sanitizer)
+#  undef PHOC_TEST_COUNT_ALLOCS
+# endif
+#endif
+
+#define N_STROKES 50
+#define N_MOTIONS 120 /* One second at 120Hz */
+/* Motions until the gestures recognized or dropped the stroke */
+#define N_WARMUP_MOTIONS 10
+
+static gboolean count_allocs;
+static int n_allocs;
+
+#ifdef PHOC_TEST_COUNT_ALLOCS
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+void *
+malloc (size_t size)
+{
+  if (count_allocs)
+    g_atomic_int_inc (&n_allocs);
+  return __libc_malloc (size);
+}
+
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  if (count_allocs)
+    g_atomic_int_inc (&n_allocs);
+  return __libc_calloc (nmemb, size);
+}
+
+
+void *
+realloc (void *ptr, size_t size)
+{
+  if (count_allocs)
+    g_atomic_int_inc (&n_allocs);
+  return __libc_realloc (ptr, size);
+}
+#endif
+
+static const struct wlr_touch_impl touch_impl = {
+  .name = "test-touch",
+};
+
+
+typedef struct {
+  struct wlr_touch wlr_touch;
+  PhocTouch       *touch;
+  GPtrArray       *gestures;
+} GestureFixture;
+
+
+static void
+gesture_fixture_setup (GestureFixture *fixture, gconstpointer unused)
+{
+  PhocGesture *gesture;
+
+  wlr_touch_init (&fixture->wlr_touch, &touch_impl, "test-touch");
+  fixture->touch = phoc_touch_new (&fixture->wlr_touch.base, NULL);
+  fixture->wlr_touch.base.data = fixture->touch;
+
+  /* What the cursor and a typical shell register */
+  fixture->gestures = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (fixture->gestures, phoc_gesture_drag_new ());
+  g_ptr_array_add (fixture->gestures, phoc_gesture_swipe_new ());
+  g_ptr_array_add (fixture->gestures, phoc_gesture_zoom_new ());
+  g_ptr_array_add (fixture->gestures, phoc_gesture_single_new ());
+  gesture = PHOC_GESTURE (phoc_gesture_swipe_new ());
+  g_object_set (gesture, "n-points", 3, NULL);
+  g_ptr_array_add (fixture->gestures, gesture);
+  gesture = PHOC_GESTURE (phoc_gesture_drag_new ());
+  g_object_set (gesture, "n-points", 2, NULL);
+  g_ptr_array_add (fixture->gestures, gesture);
+}
+
+
+static void
+gesture_fixture_teardown (GestureFixture *fixture, gconstpointer unused)
+{
+  g_clear_pointer (&fixture->gestures, g_ptr_array_unref);
+  wlr_touch_finish (&fixture->wlr_touch);
+  g_assert_finalize_object (fixture->touch);
+}
+
+
+static void
+feed_event (GestureFixture *fixture, PhocEventType type, gconstpointer wlr_event, gsize size,
+            double lx, double ly)
+{
+  PhocEvent event;
+
+  phoc_event_init (&event, type, wlr_event, size);
+  for (guint i = 0; i < fixture->gestures->len; i++)
+    phoc_gesture_handle_event (g_ptr_array_index (fixture->gestures, i), &event, lx, ly);
+}
+
+
+static void
+test_phoc_gestures_touch_stress (GestureFixture *fixture, gconstpointer unused)
+{
+  guint n_strokes = g_test_perf () ? 20 * N_STROKES : N_STROKES;
+  guint n_events = 0, n_steady_motions = 0;
+  int n_motion_allocs = 0;
+  guint32 time = 0;
+
+  n_allocs = 0;
+  for (guint stroke = 0; stroke < n_strokes; stroke++) {
+    double x = 100, y = 500;
+    int touch_id = stroke % 10;
+    struct wlr_touch_down_event down = {
+      .touch = &fixture->wlr_touch,
+      .time_msec = time,
+      .touch_id = touch_id,
+      .x = x,
+      .y = y,
+    };
+    struct wlr_touch_up_event up = {
+      .touch = &fixture->wlr_touch,
+      .touch_id = touch_id,
+    };
+
+    count_allocs = TRUE;
+    feed_event (fixture, PHOC_EVENT_TOUCH_BEGIN, &down, sizeof (down), x, y);
+    n_events++;
+
+    for (guint i = 0; i < N_MOTIONS; i++) {
+      struct wlr_touch_motion_event motion = {
+        .touch = &fixture->wlr_touch,
+        .time_msec = time,
+        .touch_id = touch_id,
+      };
+      int n_before = g_atomic_int_get (&n_allocs);
+
+      time += 8;
+      x += (stroke % 2) ? 3 : -1;
+      y -= 2;
+      motion.time_msec = time;
+      motion.x = x;
+      motion.y = y;
+      feed_event (fixture, PHOC_EVENT_TOUCH_UPDATE, &motion, sizeof (motion), x, y);
+      /* The first stroke sets up state that is reused afterwards */
+      if (stroke > 0 && i >= N_WARMUP_MOTIONS) {
+        n_motion_allocs += g_atomic_int_get (&n_allocs) - n_before;
+        n_steady_motions++;
+      }
+      n_events++;
+    }
+
+    up.time_msec = time;
+    feed_event (fixture, PHOC_EVENT_TOUCH_END, &up, sizeof (up), x, y);
+    count_allocs = FALSE;
+    n_events++;
+    time += 100;
+  }
+
+#ifdef PHOC_TEST_COUNT_ALLOCS
+  g_test_message ("%u events through %u gestures: %.3f allocations per event, "
+                  "%.3f per steady state motion event",
+                  n_events, fixture->gestures->len,
+                  (double) n_allocs / n_events,
+                  (double) n_motion_allocs / n_steady_motions);
+  g_test_minimized_result ((double) n_allocs / n_events,
+                           "Allocations per event: %.3f", (double) n_allocs / n_events);
+  /* Once gestures track a stroke motion events must not allocate */
+  g_assert_cmpint (n_steady_motions, >, 0);
+  g_assert_cmpint (n_motion_allocs, ==, 0);
+#else
+  g_test_message ("%u events through %u gestures, allocations not counted",
+                  n_events, fixture->gestures->len);
+#endif
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/phoc/gestures/touch-stress", GestureFixture, NULL,
+              gesture_fixture_setup,
+              test_phoc_gestures_touch_stress,
+              gesture_fixture_teardown);
+
+  return g_test_run ();
+}
@@ -8,8 +8,20 @@
 
 #include "keybindings.h"
 
+#include <gio/gio.h>
 #include <glib-object.h>
 
+#define KEYBINDINGS_SCHEMA_ID "org.gnome.desktop.wm.keybindings"
+
+
+static void
+set_accelerators (GSettings *settings, const char *name, const char * const *accelerators)
+{
+  g_settings_set_strv (settings, name, accelerators);
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
 
 static void
 test_keybindings_parse (void)
@@ -47,12 +59,77 @@ test_keybindings_parse (void)
 }
 
 
+static void
+test_keybindings_lookup (void)
+{
+  g_autoptr (GSettings) settings = g_settings_new (KEYBINDINGS_SCHEMA_ID);
+  g_autoptr (PhocKeybindings) keybindings = phoc_keybindings_new ();
+  PhocKeyCombo f13 = { WLR_MODIFIER_LOGO, XKB_KEY_F13 };
+  PhocKeyCombo f14 = { WLR_MODIFIER_LOGO, XKB_KEY_F14 };
+
+  set_accelerators (settings, "close", (const char *[]){ "<super>F13", NULL });
+  phoc_keybindings_load_settings (keybindings);
+  g_assert_cmpstr (phoc_keybindings_lookup (keybindings, &f13), ==, "close");
+  g_assert_null (phoc_keybindings_lookup (keybindings, &f14));
+
+  /* Changing a binding updates the index */
+  set_accelerators (settings, "close", (const char *[]){ "<super>F14", NULL });
+  g_assert_null (phoc_keybindings_lookup (keybindings, &f13));
+  g_assert_cmpstr (phoc_keybindings_lookup (keybindings, &f14), ==, "close");
+
+  /* The first binding wins, the other one takes over once it's gone */
+  set_accelerators (settings, "maximize", (const char *[]){ "<super>F14", NULL });
+  g_assert_cmpstr (phoc_keybindings_lookup (keybindings, &f14), ==, "close");
+  set_accelerators (settings, "close", (const char *[]){ NULL });
+  g_assert_cmpstr (phoc_keybindings_lookup (keybindings, &f14), ==, "maximize");
+
+  /* Reloading keeps the current bindings */
+  phoc_keybindings_load_settings (keybindings);
+  g_assert_cmpstr (phoc_keybindings_lookup (keybindings, &f14), ==, "maximize");
+
+  g_settings_reset (settings, "close");
+  g_settings_reset (settings, "maximize");
+}
+
+
+static void
+test_keybindings_lookup_perf (void)
+{
+  g_autoptr (GSettings) settings = g_settings_new (KEYBINDINGS_SCHEMA_ID);
+  g_autoptr (PhocKeybindings) keybindings = phoc_keybindings_new ();
+  guint n_iterations = g_test_perf () ? 10000000 : 100000;
+  PhocKeyCombo combo = { WLR_MODIFIER_LOGO, XKB_KEY_F13 };
+  guint n_found = 0;
+  double elapsed, ns_per_lookup;
+
+  set_accelerators (settings, "close", (const char *[]){ "<super>F13", NULL });
+  phoc_keybindings_load_settings (keybindings);
+
+  /* Every key press looks up the pressed combo, most of them miss */
+  g_test_timer_start ();
+  for (guint i = 0; i < n_iterations; i++) {
+    combo.keysym = (i % 16) ? XKB_KEY_a + (i % 26) : XKB_KEY_F13;
+    if (phoc_keybindings_lookup (keybindings, &combo))
+      n_found++;
+  }
+  elapsed = g_test_timer_elapsed ();
+
+  g_assert_cmpint (n_found, ==, (n_iterations + 15) / 16);
+  ns_per_lookup = elapsed * G_USEC_PER_SEC * 1000 / n_iterations;
+  g_test_minimized_result (ns_per_lookup, "Keybinding lookup: %.1f ns", ns_per_lookup);
+
+  g_settings_reset (settings, "close");
+}
+
+
 int
 main (int argc, char *argv[])
 {
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/phoc/keybindings/parse", test_keybindings_parse);
+  g_test_add_func ("/phoc/keybindings/lookup", test_keybindings_lookup);
+  g_test_add_func ("/phoc/keybindings/lookup/perf", test_keybindings_lookup_perf);
 
   return g_test_run ();
 }
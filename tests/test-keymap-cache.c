@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "keymap-cache.h"
+
+typedef struct {
+  GMainLoop         *loop;
+  struct xkb_keymap *keymaps[2];
+  guint              n_done;
+} LookupData;
+
+
+static void
+on_lookup_ready (GObject *object, GAsyncResult *res, gpointer user_data)
+{
+  LookupData *data = user_data;
+  g_autoptr (GError) err = NULL;
+
+  data->keymaps[data->n_done] = phoc_keymap_cache_lookup_finish (PHOC_KEYMAP_CACHE (object),
+                                                                 res,
+                                                                 &err);
+  g_assert_no_error (err);
+  g_assert_nonnull (data->keymaps[data->n_done]);
+
+  data->n_done++;
+  if (data->n_done == G_N_ELEMENTS (data->keymaps))
+    g_main_loop_quit (data->loop);
+}
+
+
+static void
+test_phoc_keymap_cache_lookup (void)
+{
+  PhocKeymapCache *cache = phoc_keymap_cache_get_default ();
+  struct xkb_rule_names us = { .layout = "us" };
+  struct xkb_rule_names de = { .layout = "de", .options = "compose:ralt" };
+  struct xkb_keymap *keymap1, *keymap2, *keymap3;
+
+  g_assert_true (cache == phoc_keymap_cache_get_default ());
+
+  keymap1 = phoc_keymap_cache_lookup (cache, &us);
+  g_assert_nonnull (keymap1);
+  keymap2 = phoc_keymap_cache_lookup (cache, &us);
+  g_assert_true (keymap1 == keymap2);
+
+  keymap3 = phoc_keymap_cache_lookup (cache, &de);
+  g_assert_nonnull (keymap3);
+  g_assert_true (keymap1 != keymap3);
+  g_assert_cmpint (phoc_keymap_cache_get_n_keymaps (cache), >=, 2);
+
+  xkb_keymap_unref (keymap1);
+  xkb_keymap_unref (keymap2);
+  xkb_keymap_unref (keymap3);
+}
+
+
+static void
+test_phoc_keymap_cache_lookup_async (void)
+{
+  PhocKeymapCache *cache = phoc_keymap_cache_get_default ();
+  struct xkb_rule_names names = { .layout = "fr", .variant = "bepo" };
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  LookupData data = { .loop = loop };
+  struct xkb_keymap *keymap;
+
+  /* Both lookups share a single compile */
+  phoc_keymap_cache_lookup_async (cache, &names, NULL, on_lookup_ready, &data);
+  phoc_keymap_cache_lookup_async (cache, &names, NULL, on_lookup_ready, &data);
+  g_main_loop_run (loop);
+
+  g_assert_cmpint (data.n_done, ==, 2);
+  g_assert_true (data.keymaps[0] == data.keymaps[1]);
+
+  /* The result is now cached */
+  keymap = phoc_keymap_cache_lookup (cache, &names);
+  g_assert_true (keymap == data.keymaps[0]);
+
+  xkb_keymap_unref (keymap);
+  xkb_keymap_unref (data.keymaps[0]);
+  xkb_keymap_unref (data.keymaps[1]);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/keymap-cache/lookup", test_phoc_keymap_cache_lookup);
+  g_test_add_func ("/phoc/keymap-cache/lookup-async", test_phoc_keymap_cache_lookup_async);
+
+  return g_test_run ();
+}
@@ -16,6 +16,7 @@ typedef struct _PhocTestLayerSurface {
   PhocTestBuffer     buffer;
   guint32 width, height;
   gboolean configured;
+  guint n_configures;
 } PhocTestLayerSurface;
 
 
@@ -201,6 +202,7 @@ layer_surface_configure (void                         *data,
   ls->height = height;
 
   ls->configured = TRUE;
+  ls->n_configures++;
 }
 
 
@@ -218,6 +220,25 @@ static struct zwlr_layer_surface_v1_listener layer_surface_listener = {
   .closed = layer_surface_closed,
 };
 
+static void
+phoc_test_layer_surface_draw (PhocTestClientGlobals *globals,
+                              PhocTestLayerSurface  *ls,
+                              guint32                color)
+{
+  phoc_test_buffer_free (&ls->buffer);
+  phoc_test_client_create_shm_buffer (globals, &ls->buffer, ls->width, ls->height,
+                                      WL_SHM_FORMAT_XRGB8888);
+
+  for (int i = 0; i < ls->width * ls->height * 4; i += 4)
+    *(guint32*)(ls->buffer.shm_data + i) = color;
+
+  wl_surface_attach (ls->wl_surface, ls->buffer.wl_buffer, 0, 0);
+  wl_surface_damage (ls->wl_surface, 0, 0, ls->width, ls->height);
+  wl_surface_commit (ls->wl_surface);
+  wl_display_roundtrip (globals->display);
+}
+
+
 static PhocTestLayerSurface *
 phoc_test_layer_surface_new (PhocTestClientGlobals *globals,
                              guint32 width, guint32 height, guint32 color,
@@ -245,15 +266,7 @@ phoc_test_layer_surface_new (PhocTestClientGlobals *globals,
   wl_display_roundtrip (globals->display);
   g_assert_true (ls->configured);
 
-  phoc_test_client_create_shm_buffer (globals, &ls->buffer, ls->width, ls->height,
-                                      WL_SHM_FORMAT_XRGB8888);
-
-  for (int i = 0; i < ls->width * ls->height * 4; i += 4)
-    *(guint32*)(ls->buffer.shm_data + i) = color;
-
-  wl_surface_attach (ls->wl_surface, ls->buffer.wl_buffer, 0, 0);
-  wl_surface_damage (ls->wl_surface, 0, 0, ls->width, ls->height);
-  wl_surface_commit (ls->wl_surface);
+  phoc_test_layer_surface_draw (globals, ls, color);
   wl_display_dispatch (globals->display);
   wl_display_roundtrip (globals->display);
 
@@ -337,6 +350,69 @@ test_layer_shell_exclusive_zone (void)
 }
 
 
+static gboolean
+test_client_layer_shell_arrange (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocTestLayerSurface *ls_zone, *ls_fill, *ls_other;
+  guint n_configures;
+  guint32 height;
+
+  ls_zone = phoc_test_layer_surface_new (globals, 0, HEIGHT, 0xFF00FF00,
+                                         ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
+                                         | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
+                                         | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+                                         HEIGHT);
+  g_assert_nonnull (ls_zone);
+
+  /* Fills the area left by the exclusive zone */
+  ls_fill = phoc_test_layer_surface_new (globals, 0, 0, 0xFFFF0000,
+                                         ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
+                                         | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM
+                                         | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
+                                         | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+                                         0);
+  g_assert_nonnull (ls_fill);
+
+  ls_other = phoc_test_layer_surface_new (globals, WIDTH, HEIGHT, 0xFF0000FF,
+                                          ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM, 0);
+  g_assert_nonnull (ls_other);
+
+  n_configures = ls_fill->n_configures;
+  height = ls_fill->height;
+
+  /* Surfaces whose arrangement didn't change are skipped */
+  zwlr_layer_surface_v1_set_margin (ls_other->layer_surface, 0, 0, 10, 0);
+  wl_surface_commit (ls_other->wl_surface);
+  wl_display_roundtrip (globals->display);
+  g_assert_cmpint (ls_fill->n_configures, ==, n_configures);
+  g_assert_cmpint (ls_fill->height, ==, height);
+
+  /* A changed exclusive zone re-arranges the surfaces below it */
+  zwlr_layer_surface_v1_set_exclusive_zone (ls_zone->layer_surface, HEIGHT / 2);
+  wl_surface_commit (ls_zone->wl_surface);
+  wl_display_roundtrip (globals->display);
+  g_assert_cmpint (ls_fill->n_configures, ==, n_configures + 1);
+  g_assert_cmpint (ls_fill->height, ==, height + HEIGHT / 2);
+  phoc_test_layer_surface_draw (globals, ls_fill, 0xFFFF0000);
+
+  phoc_test_layer_surface_free (ls_other);
+  phoc_test_layer_surface_free (ls_fill);
+  phoc_test_layer_surface_free (ls_zone);
+
+  phoc_assert_screenshot (globals, "empty.png");
+  return TRUE;
+}
+
+
+static void
+test_layer_shell_arrange (void)
+{
+  PhocTestClientIface iface = { .client_run = test_client_layer_shell_arrange };
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, NULL);
+}
+
+
 static gboolean
 test_client_layer_shell_set_layer (PhocTestClientGlobals *globals, gpointer data)
 {
@@ -422,6 +498,7 @@ main (int argc, char *argv[])
 
   PHOC_TEST_ADD ("/phoc/layer-shell/anchor", test_layer_shell_anchor);
   PHOC_TEST_ADD ("/phoc/layer-shell/exclusive_zone", test_layer_shell_exclusive_zone);
+  PHOC_TEST_ADD ("/phoc/layer-shell/arrange", test_layer_shell_arrange);
   PHOC_TEST_ADD ("/phoc/layer-shell/set_layer", test_layer_shell_set_layer);
   PHOC_TEST_ADD ("/phoc/layer-shell/popup", test_layer_shell_popup);
 
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "layout-transaction.h"
+
+
+static void
+on_active_changed (PhocLayoutTransaction *transaction, GParamSpec *pspec, guint *n_notifies)
+{
+  (*n_notifies)++;
+}
+
+
+static void
+test_phoc_layout_transaction_layers (void)
+{
+  PhocLayoutTransaction *transaction = phoc_layout_transaction_get_default ();
+  guint n_notifies = 0;
+
+  g_signal_connect (transaction, "notify::active", G_CALLBACK (on_active_changed), &n_notifies);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+
+  phoc_layout_transaction_begin (transaction);
+  phoc_layout_transaction_add_layer_dirty (transaction);
+  phoc_layout_transaction_add_layer_dirty (transaction);
+  g_assert_true (phoc_layout_transaction_end (transaction));
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 1);
+
+  phoc_layout_transaction_notify_layer_configured (transaction);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 1);
+
+  /* Transaction done once all configures are committed */
+  phoc_layout_transaction_notify_layer_configured (transaction);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 2);
+
+  /* Nothing collected */
+  phoc_layout_transaction_begin (transaction);
+  phoc_layout_transaction_begin (transaction);
+  g_assert_false (phoc_layout_transaction_end (transaction));
+  g_assert_false (phoc_layout_transaction_end (transaction));
+  g_assert_cmpint (n_notifies, ==, 2);
+
+  g_signal_handlers_disconnect_by_data (transaction, &n_notifies);
+}
+
+
+static void
+test_phoc_layout_transaction_views (void)
+{
+  PhocLayoutTransaction *transaction = phoc_layout_transaction_get_default ();
+  g_autoptr (PhocView) view1 = g_object_new (PHOC_TYPE_VIEW, NULL);
+  g_autoptr (PhocView) view2 = g_object_new (PHOC_TYPE_VIEW, NULL);
+  guint n_notifies = 0;
+
+  g_signal_connect (transaction, "notify::active", G_CALLBACK (on_active_changed), &n_notifies);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+
+  /* Configures outside of a layout change don't take part */
+  phoc_layout_transaction_add_view_dirty (transaction, view1);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 0);
+
+  phoc_layout_transaction_begin (transaction);
+  phoc_layout_transaction_add_view_dirty (transaction, view1);
+  /* Configuring a view again doesn't make us wait twice */
+  phoc_layout_transaction_add_view_dirty (transaction, view1);
+  phoc_layout_transaction_add_view_dirty (transaction, view2);
+  g_assert_true (phoc_layout_transaction_end (transaction));
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 1);
+
+  /* Views joining after the layout change don't take part */
+  phoc_layout_transaction_notify_view_configured (transaction, view1);
+  phoc_layout_transaction_add_view_dirty (transaction, view1);
+  phoc_layout_transaction_notify_view_configured (transaction, view1);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 1);
+
+  /* Unmapping views notify too so they don't block the transaction */
+  phoc_layout_transaction_notify_view_configured (transaction, view2);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 2);
+
+  /* Views and layers are waited for together */
+  phoc_layout_transaction_begin (transaction);
+  phoc_layout_transaction_add_layer_dirty (transaction);
+  phoc_layout_transaction_add_view_dirty (transaction, view1);
+  g_assert_true (phoc_layout_transaction_end (transaction));
+  phoc_layout_transaction_notify_view_configured (transaction, view1);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+  phoc_layout_transaction_notify_layer_configured (transaction);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+  g_assert_cmpint (n_notifies, ==, 4);
+
+  g_signal_handlers_disconnect_by_data (transaction, &n_notifies);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/layout-transaction/layers", test_phoc_layout_transaction_layers);
+  g_test_add_func ("/phoc/layout-transaction/views", test_phoc_layout_transaction_views);
+
+  return g_test_run ();
+}
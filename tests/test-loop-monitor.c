@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "loop-monitor.h"
+
+
+static void
+on_busy_idle (gpointer data)
+{
+  gint64 start_us = g_get_monotonic_time ();
+
+  g_usleep (2 * PHOC_LOOP_MONITOR_BUDGET_US);
+  phoc_loop_monitor_add_sample (PHOC_LOOP_MONITOR (data), NULL, g_get_monotonic_time () - start_us);
+}
+
+
+static void
+test_phoc_loop_monitor_overrun (void)
+{
+  PhocLoopMonitor *monitor = phoc_loop_monitor_get_default ();
+  guint64 n_iterations, n_overruns;
+  guint id;
+
+  g_assert_true (monitor == phoc_loop_monitor_get_default ());
+
+  /* Let the monitor see some iterations */
+  g_main_context_iteration (NULL, FALSE);
+  g_main_context_iteration (NULL, FALSE);
+  n_iterations = phoc_loop_monitor_get_n_iterations (monitor);
+  n_overruns = phoc_loop_monitor_get_n_overruns (monitor);
+  g_assert_cmpint (n_iterations, >, 0);
+
+  id = g_idle_add_once (on_busy_idle, monitor);
+  g_source_set_name_by_id (id, "[phoc] busy idle");
+
+  /* The iteration is reported when polling in the next one */
+  g_main_context_iteration (NULL, FALSE);
+  g_main_context_iteration (NULL, FALSE);
+
+  g_assert_cmpint (phoc_loop_monitor_get_n_iterations (monitor), >, n_iterations);
+  g_assert_cmpint (phoc_loop_monitor_get_n_overruns (monitor), >, n_overruns);
+  g_assert_cmpint (phoc_loop_monitor_get_max_latency (monitor), >=,
+                   2 * PHOC_LOOP_MONITOR_BUDGET_US);
+  g_assert_nonnull (g_strstr_len (phoc_loop_monitor_get_last_overrun (monitor), -1,
+                                 "[phoc] busy idle"));
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/loop-monitor/overrun", test_phoc_loop_monitor_overrun);
+
+  return g_test_run ();
+}
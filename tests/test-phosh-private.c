@@ -28,11 +28,16 @@ typedef struct _PhocTestKeyboardEvent {
 
 
 static PhocTestScreencopyFrame *
-phoc_test_get_thumbnail (PhocTestClientGlobals *globals,
-                         guint32 max_width, guint32 max_height, PhocTestForeignToplevel *toplevel)
+phoc_test_get_thumbnail_full (PhocTestClientGlobals   *globals,
+                              guint32                  max_width,
+                              guint32                  max_height,
+                              PhocTestForeignToplevel *toplevel,
+                              gboolean                 with_damage)
 {
   PhocTestScreencopyFrame *thumbnail = g_malloc0 (sizeof(PhocTestScreencopyFrame));
 
+  thumbnail->with_damage = with_damage;
+
   struct zwlr_screencopy_frame_v1 *handle = phosh_private_get_thumbnail (globals->phosh,
                                                                          toplevel->handle,
                                                                          max_width, max_height);
@@ -42,6 +47,13 @@ phoc_test_get_thumbnail (PhocTestClientGlobals *globals,
   return thumbnail;
 }
 
+static PhocTestScreencopyFrame *
+phoc_test_get_thumbnail (PhocTestClientGlobals *globals,
+                         guint32 max_width, guint32 max_height, PhocTestForeignToplevel *toplevel)
+{
+  return phoc_test_get_thumbnail_full (globals, max_width, max_height, toplevel, FALSE);
+}
+
 static void
 phoc_test_thumbnail_free (PhocTestScreencopyFrame *frame)
 {
@@ -84,6 +96,176 @@ test_phosh_private_thumbnail_simple (void)
   phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, GINT_TO_POINTER (FALSE));
 }
 
+static gboolean
+test_client_phosh_private_thumbnail_damage (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocTestXdgToplevelSurface *toplevel_green;
+  PhocTestScreencopyFrame *green_thumbnail;
+
+  toplevel_green = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, "green", 0xFF00FF00);
+  g_assert_nonnull (toplevel_green);
+
+  /* Nothing was rendered yet so the whole thumbnail is damaged */
+  green_thumbnail = phoc_test_get_thumbnail_full (globals,
+                                                  toplevel_green->width,
+                                                  toplevel_green->height,
+                                                  toplevel_green->foreign_toplevel,
+                                                  TRUE);
+  g_assert_cmpint (green_thumbnail->n_damage_rects, >, 0);
+  phoc_assert_buffer_equal (&toplevel_green->buffer, &green_thumbnail->buffer);
+  phoc_test_thumbnail_free (green_thumbnail);
+
+  /* A plain copy from the cache gives the same content */
+  green_thumbnail = phoc_test_get_thumbnail (globals, toplevel_green->width, toplevel_green->height,
+                                             toplevel_green->foreign_toplevel);
+  phoc_assert_buffer_equal (&toplevel_green->buffer, &green_thumbnail->buffer);
+  phoc_test_thumbnail_free (green_thumbnail);
+
+  phoc_test_xdg_toplevel_free (toplevel_green);
+  phoc_assert_screenshot (globals, "empty.png");
+
+  return TRUE;
+}
+
+static void
+test_phosh_private_thumbnail_damage (void)
+{
+  PhocTestClientIface iface = {
+   .client_run = test_client_phosh_private_thumbnail_damage,
+   .debug_flags    = PHOC_SERVER_DEBUG_FLAG_DISABLE_ANIMATIONS,
+  };
+
+  /* pixman renderer can work in containers, skip tests otherwise */
+  g_assert_cmpstr (g_getenv ("WLR_RENDERER"), ==, "pixman");
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, GINT_TO_POINTER (FALSE));
+}
+
+typedef struct _PhocTestDeferredCopy {
+  PhocTestClientGlobals *globals;
+  PhocTestBuffer buffer;
+  guint n_copies;
+  guint n_damage_rects;
+} PhocTestDeferredCopy;
+
+
+static void
+deferred_copy_handle_buffer (void                            *data,
+                             struct zwlr_screencopy_frame_v1 *handle,
+                             uint32_t                         format,
+                             uint32_t                         width,
+                             uint32_t                         height,
+                             uint32_t                         stride)
+{
+  PhocTestDeferredCopy *copy = data;
+
+  g_assert_true (phoc_test_client_create_shm_buffer (copy->globals, &copy->buffer,
+                                                     width, height, format));
+  zwlr_screencopy_frame_v1_copy_with_damage (handle, copy->buffer.wl_buffer);
+}
+
+
+static void
+deferred_copy_handle_flags (void *data, struct zwlr_screencopy_frame_v1 *handle, uint32_t flags)
+{
+  g_assert_false (flags);
+}
+
+
+static void
+deferred_copy_handle_ready (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                            uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec)
+{
+  PhocTestDeferredCopy *copy = data;
+
+  copy->n_copies++;
+}
+
+
+static void
+deferred_copy_handle_damage (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                             uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+  PhocTestDeferredCopy *copy = data;
+
+  copy->n_damage_rects++;
+}
+
+
+G_NORETURN
+static void
+deferred_copy_handle_failed (void *data, struct zwlr_screencopy_frame_v1 *handle)
+{
+  g_assert_not_reached ();
+}
+
+
+static const struct zwlr_screencopy_frame_v1_listener deferred_copy_listener = {
+  .buffer = deferred_copy_handle_buffer,
+  .flags = deferred_copy_handle_flags,
+  .ready = deferred_copy_handle_ready,
+  .failed = deferred_copy_handle_failed,
+  .damage = deferred_copy_handle_damage,
+};
+
+
+static gboolean
+test_client_phosh_private_thumbnail_wait_damage (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocTestXdgToplevelSurface *toplevel;
+  PhocTestScreencopyFrame *thumbnail;
+  PhocTestDeferredCopy copy = { .globals = globals };
+  struct zwlr_screencopy_frame_v1 *handle;
+
+  toplevel = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, "green", 0xFF00FF00);
+  g_assert_nonnull (toplevel);
+
+  /* Render the thumbnail once */
+  thumbnail = phoc_test_get_thumbnail_full (globals, toplevel->width, toplevel->height,
+                                            toplevel->foreign_toplevel, TRUE);
+  phoc_test_thumbnail_free (thumbnail);
+
+  handle = phosh_private_get_thumbnail (globals->phosh, toplevel->foreign_toplevel->handle,
+                                        toplevel->width, toplevel->height);
+  zwlr_screencopy_frame_v1_add_listener (handle, &deferred_copy_listener, &copy);
+  wl_display_roundtrip (globals->display);
+  wl_display_roundtrip (globals->display);
+
+  /* The view didn't change so the copy waits */
+  g_assert_cmpint (copy.n_copies, ==, 0);
+
+  phoc_test_xdg_update_buffer (globals, toplevel, 0xFFFF0000);
+  while (copy.n_copies == 0 && wl_display_dispatch (globals->display) != -1) {
+  }
+  wl_display_roundtrip (globals->display);
+
+  /* Damaging the view results in a single copy of the new content */
+  g_assert_cmpint (copy.n_copies, ==, 1);
+  g_assert_cmpint (copy.n_damage_rects, >, 0);
+  phoc_assert_buffer_equal (&toplevel->buffer, &copy.buffer);
+
+  zwlr_screencopy_frame_v1_destroy (handle);
+  phoc_test_buffer_free (&copy.buffer);
+  phoc_test_xdg_toplevel_free (toplevel);
+  phoc_assert_screenshot (globals, "empty.png");
+
+  return TRUE;
+}
+
+static void
+test_phosh_private_thumbnail_wait_damage (void)
+{
+  PhocTestClientIface iface = {
+   .client_run = test_client_phosh_private_thumbnail_wait_damage,
+   .debug_flags    = PHOC_SERVER_DEBUG_FLAG_DISABLE_ANIMATIONS,
+  };
+
+  /* pixman renderer can work in containers, skip tests otherwise */
+  g_assert_cmpstr (g_getenv ("WLR_RENDERER"), ==, "pixman");
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, GINT_TO_POINTER (FALSE));
+}
+
 static void
 keyboard_event_handle_grab_failed (void                                *data,
                                    struct phosh_private_keyboard_event *kbevent,
@@ -301,6 +483,8 @@ main (int argc, char *argv[])
   g_test_init (&argc, &argv, NULL);
 
   PHOC_TEST_ADD ("/phoc/phosh/thumbnail/simple", test_phosh_private_thumbnail_simple);
+  PHOC_TEST_ADD ("/phoc/phosh/thumbnail/damage", test_phosh_private_thumbnail_damage);
+  PHOC_TEST_ADD ("/phoc/phosh/thumbnail/wait-damage", test_phosh_private_thumbnail_wait_damage);
   PHOC_TEST_ADD ("/phoc/phosh/kbevents/simple", test_phosh_private_kbevents_simple);
   PHOC_TEST_ADD ("/phoc/phosh/startup-tracker/simple", test_phosh_private_startup_tracker_simple);
   return g_test_run ();
@@ -10,6 +10,8 @@
 
 #include "testlib.h"
 
+#include <float.h>
+
 
 static void
 test_phoc_config_defaults (void)
@@ -18,6 +20,7 @@ test_phoc_config_defaults (void)
 
   g_assert_true (config->xwayland);
   g_assert_true (config->xwayland_lazy);
+  g_assert_cmpfloat (config->hidden_frame_rate, ==, PHOC_CONFIG_HIDDEN_FRAME_RATE);
   g_assert_cmpint (g_slist_length (config->outputs), ==, 0);
   g_assert_null (config->config_path);
 }
@@ -31,7 +34,10 @@ test_phoc_config_output (void)
   g_autoptr (PhocConfig) config1 = phoc_config_new_from_data (
     "[output:X11-1]\n"
     "scale = 3\n"
-    "adaptive-sync = enabled\n");
+    "adaptive-sync = enabled\n"
+    "output-layers = true\n"
+    "render-margin = 2.5\n"
+    "damage-max-rects = 8\n");
 
   g_autoptr (PhocConfig) config2 = phoc_config_new_from_data (
     "[output:X11-1]\n"
@@ -43,6 +49,10 @@ test_phoc_config_output (void)
   g_assert_cmpint (g_slist_length (config1->outputs), ==, 1);
   g_assert_cmpfloat (oc->scale, ==, 3.0);
   g_assert_cmpint (oc->adaptive_sync, ==, PHOC_OUTPUT_ADAPTIVE_SYNC_ENABLED);
+  g_assert_true (oc->output_layers);
+  g_assert_cmpfloat (oc->render_margin, ==, 2.5);
+  g_assert_cmpint (oc->damage_max_rects, ==, 8);
+  g_assert_cmpfloat_with_epsilon (oc->damage_fill_ratio, PHOC_OUTPUT_CONFIG_DAMAGE_FILL_RATIO, FLT_EPSILON);
   g_assert_cmpint (g_slist_length (config1->outputs), ==, 1);
 
 
@@ -65,10 +75,81 @@ test_phoc_config_modelines (void)
   g_assert_cmpint (g_slist_length (config->outputs), ==, 1);
   g_assert_cmpfloat (oc->scale, ==, 3.0);
   g_assert_cmpint (oc->adaptive_sync, ==, PHOC_OUTPUT_ADAPTIVE_SYNC_NONE);
+  g_assert_false (oc->output_layers);
+  g_assert_cmpfloat (oc->render_margin, ==, 0.0);
   g_assert_cmpint (g_slist_length (oc->modes), ==, 2);
 }
 
 
+static void
+test_phoc_config_damage (void)
+{
+  PhocOutputConfig *oc;
+
+  g_autoptr (PhocConfig) config1 = phoc_config_new_from_data (
+    "[output:X11-1]\n"
+    "scale = 1\n");
+
+  g_autoptr (PhocConfig) config2 = phoc_config_new_from_data (
+    "[output:X11-1]\n"
+    "damage-max-rects = 0\n"
+    "damage-fill-ratio = 0.25\n");
+
+  g_autoptr (PhocConfig) config3 = phoc_config_new_from_data (
+    "[output:X11-1]\n"
+    "damage-fill-ratio = 2\n");
+
+  oc = config1->outputs->data;
+  g_assert_cmpint (oc->damage_max_rects, ==, PHOC_OUTPUT_CONFIG_DAMAGE_MAX_RECTS);
+  g_assert_cmpfloat_with_epsilon (oc->damage_fill_ratio, PHOC_OUTPUT_CONFIG_DAMAGE_FILL_RATIO, FLT_EPSILON);
+
+  oc = config2->outputs->data;
+  g_assert_cmpint (oc->damage_max_rects, ==, 0);
+  g_assert_cmpfloat (oc->damage_fill_ratio, ==, 0.25);
+
+  /* Out of range ratios get clamped */
+  oc = config3->outputs->data;
+  g_assert_cmpfloat (oc->damage_fill_ratio, ==, 1.0);
+}
+
+
+static void
+test_phoc_config_core (void)
+{
+  g_autoptr (PhocConfig) config1 = phoc_config_new_from_data (
+    "[core]\n"
+    "xwayland = false\n"
+    "hidden-frame-rate = 0.5\n");
+
+  g_autoptr (PhocConfig) config2 = phoc_config_new_from_data (
+    "[core]\n"
+    "hidden-frame-rate = 0\n");
+
+  g_assert_false (config1->xwayland);
+  g_assert_cmpfloat (config1->hidden_frame_rate, ==, 0.5);
+  g_assert_cmpfloat (config2->hidden_frame_rate, ==, 0.0);
+}
+
+
+static void
+test_phoc_config_hidden_frame_rate (void)
+{
+  g_autoptr (PhocConfig) config1 = phoc_config_new_from_data (
+    "[core]\n"
+    "hidden-frame-rate = 30\n");
+  g_autoptr (PhocConfig) config2 = NULL;
+
+  g_assert_cmpfloat (config1->hidden_frame_rate, ==, 30.0);
+
+  g_test_expect_message ("phoc-settings", G_LOG_LEVEL_WARNING, "Invalid hidden-frame-rate -1");
+  config2 = phoc_config_new_from_data (
+    "[core]\n"
+    "hidden-frame-rate = -1\n");
+  g_test_assert_expected_messages ();
+  g_assert_cmpfloat (config2->hidden_frame_rate, ==, 0.0);
+}
+
+
 int
 main (int argc, char *argv[])
 {
@@ -77,6 +158,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/phoc/config/simple", test_phoc_config_defaults);
   g_test_add_func ("/phoc/config/output", test_phoc_config_output);
   g_test_add_func ("/phoc/config/modelines", test_phoc_config_modelines);
+  g_test_add_func ("/phoc/config/damage", test_phoc_config_damage);
+  g_test_add_func ("/phoc/config/core", test_phoc_config_core);
+  g_test_add_func ("/phoc/config/hidden-frame-rate", test_phoc_config_hidden_frame_rate);
 
   return g_test_run ();
 }
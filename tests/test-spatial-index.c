@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "spatial-index.h"
+
+#define ITEM(i) GUINT_TO_POINTER ((i) + 1)
+
+
+static gboolean
+hits_contain (GPtrArray *hits, gpointer item)
+{
+  return g_ptr_array_find (hits, item, NULL);
+}
+
+
+static void
+test_phoc_spatial_index_basic (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new (64);
+  GPtrArray *hits;
+
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ 0, 0, 100, 100 });
+  phoc_spatial_index_update (index, ITEM (1), &(struct wlr_box){ 50, 50, 100, 100 });
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 2);
+
+  hits = phoc_spatial_index_query_point (index, 10, 10);
+  g_assert_cmpint (hits->len, ==, 1);
+  g_assert_true (hits_contain (hits, ITEM (0)));
+
+  hits = phoc_spatial_index_query_point (index, 75.5, 75.5);
+  g_assert_cmpint (hits->len, ==, 2);
+
+  /* Right and bottom edges are exclusive */
+  hits = phoc_spatial_index_query_point (index, 100, 10);
+  g_assert_cmpint (hits->len, ==, 0);
+  hits = phoc_spatial_index_query_point (index, 99.9, 10);
+  g_assert_cmpint (hits->len, ==, 1);
+
+  /* Moving updates the lookup */
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ 500, 500, 10, 10 });
+  hits = phoc_spatial_index_query_point (index, 10, 10);
+  g_assert_cmpint (hits->len, ==, 0);
+  hits = phoc_spatial_index_query_point (index, 505, 505);
+  g_assert_cmpint (hits->len, ==, 1);
+  g_assert_true (hits_contain (hits, ITEM (0)));
+
+  /* Empty boxes remove the item */
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ 0, 0, 0, 0 });
+  g_assert_false (phoc_spatial_index_contains (index, ITEM (0)));
+  hits = phoc_spatial_index_query_point (index, 505, 505);
+  g_assert_cmpint (hits->len, ==, 0);
+
+  g_assert_true (phoc_spatial_index_remove (index, ITEM (1)));
+  g_assert_false (phoc_spatial_index_remove (index, ITEM (1)));
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 0);
+}
+
+
+static void
+test_phoc_spatial_index_negative (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new (64);
+  GPtrArray *hits;
+
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ -100, -10, 90, 20 });
+
+  hits = phoc_spatial_index_query_point (index, -50, 0);
+  g_assert_cmpint (hits->len, ==, 1);
+  hits = phoc_spatial_index_query_point (index, -0.5, 0);
+  g_assert_cmpint (hits->len, ==, 0);
+  hits = phoc_spatial_index_query_point (index, -10.5, -10);
+  g_assert_cmpint (hits->len, ==, 1);
+}
+
+
+static void
+test_phoc_spatial_index_oversized (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new (1);
+  GPtrArray *hits;
+
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ 0, 0, 1000, 1000 });
+  hits = phoc_spatial_index_query_point (index, 999, 999);
+  g_assert_cmpint (hits->len, ==, 1);
+
+  /* Shrinking moves the item from the oversized list into the grid */
+  phoc_spatial_index_update (index, ITEM (0), &(struct wlr_box){ 0, 0, 2, 2 });
+  hits = phoc_spatial_index_query_point (index, 999, 999);
+  g_assert_cmpint (hits->len, ==, 0);
+  hits = phoc_spatial_index_query_point (index, 1, 1);
+  g_assert_cmpint (hits->len, ==, 1);
+}
+
+/*
+ * The index must give the same answers as checking all boxes.
+ */
+static void
+test_phoc_spatial_index_linear (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new (32);
+  g_autoptr (GRand) rand = g_rand_new_with_seed (42);
+  struct wlr_box boxes[64];
+
+  for (int round = 0; round < 4; round++) {
+    for (guint i = 0; i < G_N_ELEMENTS (boxes); i++) {
+      boxes[i] = (struct wlr_box) {
+        .x = g_rand_int_range (rand, -200, 800),
+        .y = g_rand_int_range (rand, -200, 800),
+        .width = g_rand_int_range (rand, 0, 300),
+        .height = g_rand_int_range (rand, 0, 300),
+      };
+      phoc_spatial_index_update (index, ITEM (i), &boxes[i]);
+    }
+
+    for (int j = 0; j < 500; j++) {
+      double x = g_rand_double_range (rand, -250, 1150);
+      double y = g_rand_double_range (rand, -250, 1150);
+      GPtrArray *hits = phoc_spatial_index_query_point (index, x, y);
+      guint n_expected = 0;
+
+      for (guint i = 0; i < G_N_ELEMENTS (boxes); i++) {
+        if (!wlr_box_contains_point (&boxes[i], x, y))
+          continue;
+
+        n_expected++;
+        g_assert_true (hits_contain (hits, ITEM (i)));
+      }
+      g_assert_cmpint (hits->len, ==, n_expected);
+    }
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/spatial-index/basic", test_phoc_spatial_index_basic);
+  g_test_add_func ("/phoc/spatial-index/negative", test_phoc_spatial_index_negative);
+  g_test_add_func ("/phoc/spatial-index/oversized", test_phoc_spatial_index_oversized);
+  g_test_add_func ("/phoc/spatial-index/linear", test_phoc_spatial_index_linear);
+
+  return g_test_run ();
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 Phosh.mobi e.V.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "spinner.h"
+
+#include <math.h>
+
+#define DEG(x) ((x) * G_PI / 180.0)
+
+
+static double
+angle_distance (double a, double b)
+{
+  double d = fmod (fabs (a - b), 2 * G_PI);
+
+  return MIN (d, 2 * G_PI - d);
+}
+
+
+static void
+test_phoc_spinner_atlas_quantization (void)
+{
+  double max_start_error = 0, max_length_error = 0;
+
+  /* One spin takes 2π, sample several of them */
+  for (double angle = 0; angle < 8 * G_PI; angle += 0.01) {
+    double start, length, atlas_start, atlas_length;
+
+    phoc_spinner_get_arc (angle, FALSE, &start, &length);
+    phoc_spinner_get_arc (angle, TRUE, &atlas_start, &atlas_length);
+
+    max_start_error = MAX (max_start_error, angle_distance (start, atlas_start));
+    max_length_error = MAX (max_length_error, fabs (length - atlas_length));
+  }
+
+  /* The accepted quantization as documented in PhocSpinner */
+  g_assert_cmpfloat (max_start_error, <=, DEG (3.75) + 1e-6);
+  g_assert_cmpfloat (max_length_error, <=, DEG (11.4));
+  /* The atlas is actually used */
+  g_assert_cmpfloat (max_start_error, >, 0);
+  g_assert_cmpfloat (max_length_error, >, 0);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/spinner/atlas-quantization", test_phoc_spinner_atlas_quantization);
+
+  return g_test_run ();
+}
@@ -44,12 +44,72 @@ test_phoc_utils_compute_scale (void)
   g_assert_cmpfloat (scale, ==, 1.0);
 }
 
+
+static void
+test_phoc_utils_region_area (void)
+{
+  pixman_region32_t region;
+
+  pixman_region32_init (&region);
+  g_assert_cmpint (phoc_utils_region_area (&region), ==, 0);
+
+  pixman_region32_union_rect (&region, &region, 0, 0, 10, 10);
+  g_assert_cmpint (phoc_utils_region_area (&region), ==, 100);
+
+  /* Overlapping parts only count once */
+  pixman_region32_union_rect (&region, &region, 5, 5, 10, 10);
+  g_assert_cmpint (phoc_utils_region_area (&region), ==, 175);
+
+  pixman_region32_fini (&region);
+}
+
+
+static void
+test_phoc_utils_region_simplify (void)
+{
+  pixman_region32_t region;
+  pixman_box32_t *extents;
+
+  pixman_region32_init (&region);
+  g_assert_false (phoc_utils_region_simplify (&region, 4, 0.8));
+
+  /* Two sparse rects stay as is */
+  pixman_region32_union_rect (&region, &region, 0, 0, 10, 10);
+  pixman_region32_union_rect (&region, &region, 90, 90, 10, 10);
+  g_assert_false (phoc_utils_region_simplify (&region, 4, 0.8));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 2);
+
+  /* Too many rects get merged */
+  for (int i = 0; i < 8; i++)
+    pixman_region32_union_rect (&region, &region, i * 12, 40, 5, 5);
+  g_assert_cmpint (pixman_region32_n_rects (&region), >, 4);
+  g_assert_true (phoc_utils_region_simplify (&region, 4, 0.8));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 1);
+  extents = pixman_region32_extents (&region);
+  g_assert_cmpint (extents->x1, ==, 0);
+  g_assert_cmpint (extents->y1, ==, 0);
+  g_assert_cmpint (extents->x2, ==, 100);
+  g_assert_cmpint (extents->y2, ==, 100);
+
+  /* Rects mostly filling their bounding box get merged */
+  pixman_region32_clear (&region);
+  pixman_region32_union_rect (&region, &region, 0, 0, 100, 50);
+  pixman_region32_union_rect (&region, &region, 0, 50, 90, 50);
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 2);
+  g_assert_true (phoc_utils_region_simplify (&region, 4, 0.8));
+  g_assert_cmpint (phoc_utils_region_area (&region), ==, 100 * 100);
+
+  pixman_region32_fini (&region);
+}
+
 int
 main (int argc, char *argv[])
 {
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/phoc/utils/compute_scale", test_phoc_utils_compute_scale);
+  g_test_add_func ("/phoc/utils/region_area", test_phoc_utils_region_area);
+  g_test_add_func ("/phoc/utils/region_simplify", test_phoc_utils_region_simplify);
 
   return g_test_run ();
 }
@@ -88,7 +88,10 @@ screencopy_frame_handle_buffer (void                            *data,
                                                 height,
                                                 format);
   g_assert_true (success);
-  zwlr_screencopy_frame_v1_copy (handle, frame->buffer.wl_buffer);
+  if (frame->with_damage)
+    zwlr_screencopy_frame_v1_copy_with_damage (handle, frame->buffer.wl_buffer);
+  else
+    zwlr_screencopy_frame_v1_copy (handle, frame->buffer.wl_buffer);
 }
 
 
@@ -112,6 +115,19 @@ screencopy_frame_handle_ready (void *data, struct zwlr_screencopy_frame_v1 *hand
 }
 
 
+static void
+screencopy_frame_handle_damage (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                                uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+  PhocTestScreencopyFrame *frame = data;
+
+  g_assert_true (frame->with_damage);
+  g_assert_cmpint (x + width, <=, frame->buffer.width);
+  g_assert_cmpint (y + height, <=, frame->buffer.height);
+  frame->n_damage_rects++;
+}
+
+
 G_NORETURN
 static void
 screencopy_frame_handle_failed (void *data, struct zwlr_screencopy_frame_v1 *frame)
@@ -125,6 +141,7 @@ static const struct zwlr_screencopy_frame_v1_listener screencopy_frame_listener
   .flags = screencopy_frame_handle_flags,
   .ready = screencopy_frame_handle_ready,
   .failed = screencopy_frame_handle_failed,
+  .damage = screencopy_frame_handle_damage,
 };
 
 
@@ -340,6 +357,8 @@ registry_handle_global (void               *data,
   } else if (!g_strcmp0 (interface, wl_shm_interface.name)) {
     globals->shm = wl_registry_bind (registry, name, &wl_shm_interface, 1);
     wl_shm_add_listener (globals->shm, &shm_listener, globals);
+  } else if (!g_strcmp0 (interface, wl_seat_interface.name)) {
+    globals->seat = wl_registry_bind (registry, name, &wl_seat_interface, 5);
   } else if (!g_strcmp0 (interface, wl_output_interface.name)) {
     /* TODO: only one output atm */
     g_assert_null (globals->output.output);
@@ -435,6 +454,7 @@ wl_client_run (GTask *task, gpointer source, gpointer data, GCancellable *cancel
   g_clear_pointer (&globals.layer_shell, zwlr_layer_shell_v1_destroy);
   wl_proxy_destroy ((struct wl_proxy *)globals.xdg_shell);
   g_clear_pointer (&globals.shm, wl_shm_destroy);
+  g_clear_pointer (&globals.seat, wl_seat_destroy);
   g_clear_pointer (&globals.compositor, wl_compositor_destroy);
   g_clear_pointer (&globals.output.output, wl_output_destroy);
   g_clear_pointer (&globals.formats, g_ptr_array_unref);
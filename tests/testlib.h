@@ -39,6 +39,8 @@ typedef struct _PhocTestScreencopyFrame {
   PhocTestBuffer buffer;
   gboolean done;
   uint32_t flags;
+  gboolean with_damage;
+  guint n_damage_rects;
   PhocTestClientGlobals *globals;
 } PhocTestScreencopyFrame;
 
@@ -62,6 +64,7 @@ struct _PhocTestClientGlobals {
   struct wl_display                       *display;
   struct wl_compositor                    *compositor;
   struct wl_shm                           *shm;
+  struct wl_seat                          *seat;
   struct xdg_wm_base                      *xdg_shell;
   struct xx_cutouts_manager_v1            *cutouts_manager;
   struct zwlr_layer_shell_v1              *layer_shell;